@@ -0,0 +1,109 @@
+#include "BatchTracker.h"
+#include "Model/PluginLoader.h"
+#include "Model/ImageStream.h"
+#include "Model/AreaDescriptor/AreaInfo.h"
+#include "Controller/ControllerDataExporter.h"
+#include "Interfaces/IBioTrackerPlugin.h"
+#include "Interfaces/IModel/IModelDataExporter.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+BatchTracker::BatchTracker(QObject *parent) : QObject(parent)
+{
+    m_parameters.m_Play = true;
+    m_parameters.m_Forw = false;
+    m_parameters.m_Back = false;
+    m_parameters.m_Stop = false;
+    m_parameters.m_Paus = false;
+    m_parameters.m_RecI = false;
+    m_parameters.m_RecO = false;
+    m_parameters.m_TotalNumbFrames = 0;
+    m_parameters.m_CurrentFrameNumber = 0;
+    m_parameters.m_fpsSourceVideo = 0;
+    m_parameters.m_fpsTarget = 0;
+}
+
+std::shared_ptr<BioTracker::Core::ImageStream> BatchTracker::openMedia(const std::string &media)
+{
+    boost::filesystem::path path(media);
+    if (!boost::filesystem::is_directory(path)) {
+        return BioTracker::Core::make_ImageStream3Video(path);
+    }
+
+    std::vector<boost::filesystem::path> files;
+    for (boost::filesystem::directory_iterator it(path), end; it != end; ++it) {
+        if (boost::filesystem::is_regular_file(it->path()))
+            files.push_back(it->path());
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty())
+        return BioTracker::Core::make_ImageStream3NoMedia();
+    return BioTracker::Core::make_ImageStream3Pictures(files);
+}
+
+int BatchTracker::run(const std::string &pluginFile, const std::string &media)
+{
+    PluginLoader *loader = new PluginLoader(this);
+    IBioTrackerPlugin *plugin = nullptr;
+    if (loader->loadPluginFromFilename(QString::fromStdString(pluginFile)))
+        plugin = loader->getPluginInstance();
+    if (!plugin) {
+        std::cout << "Error loading plugin: " << pluginFile << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<BioTracker::Core::ImageStream> stream = openMedia(media);
+    if (stream->type() == GuiParam::MediaType::NoMedia || stream->currentFrameIsEmpty()) {
+        std::cout << "Error loading media: " << media << std::endl;
+        return 1;
+    }
+
+    plugin->createPlugin();
+
+    //The plugin takes the tracking area and the rectification from the area descriptor
+    m_parameters.m_TotalNumbFrames = stream->numFrames();
+    m_parameters.m_CurrentFilename = QString::fromStdString(stream->currentFilename());
+    m_parameters.m_CurrentTitle = stream->getTitle();
+    m_parameters.m_CurrentFrame = stream->currentFrame();
+    m_parameters.m_fpsSourceVideo = stream->fps();
+    m_parameters.m_fpsTarget = stream->fps();
+    AreaInfo *area = new AreaInfo(this);
+    area->rcvPlayerParameters(&m_parameters);
+    plugin->receiveAreaDescriptor(area);
+
+    SourceVideoMetadata metadata;
+    metadata.name = m_parameters.m_CurrentFilename.toStdString();
+    metadata.fps = std::to_string(stream->fps());
+    metadata.fps = metadata.fps.erase(metadata.fps.find_last_not_of('0') + 1, std::string::npos);
+
+    ControllerDataExporter *exporter = new ControllerDataExporter(this);
+    exporter->setSourceMetadata(metadata);
+    exporter->setDataStructure(plugin->getTrackerComponentModel());
+    exporter->setComponentFactory(plugin->getComponentFactory());
+    IModelDataExporter *model = qobject_cast<IModelDataExporter*>(exporter->getModel());
+    if (model) {
+        model->setFps(stream->fps());
+        model->setTitle(stream->getTitle());
+    }
+
+    //Plugin and exporter live in this thread, so every frame is written before the next one is decoded
+    QObject::connect(dynamic_cast<QObject*>(plugin), SIGNAL(emitTrackingDone(uint)),
+        exporter, SLOT(receiveTrackingDone(uint)), Qt::DirectConnection);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t frames = 0;
+    do {
+        uint frameNumber = static_cast<uint>(stream->currentFrameNumber());
+        plugin->receiveCurrentFrameFromMainApp(stream->currentFrame(), frameNumber);
+        frames++;
+    } while (stream->nextFrame());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    exporter->cleanup();
+
+    std::cout << "Tracked " << frames << " frames of " << media << " in " << seconds << "s ("
+        << (seconds > 0 ? frames / seconds : 0) << " fps)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef BATCHTRACKER_H
+#define BATCHTRACKER_H
+
+#include <QObject>
+#include <memory>
+#include <string>
+#include "opencv2/core/core.hpp"
+#include "QString"
+#include "Model/MediaPlayerStateMachine/PlayerParameters.h"
+
+namespace BioTracker {
+namespace Core {
+class ImageStream;
+}
+}
+
+/**
+ * The BatchTracker class runs a tracking plugin over a video or an image sequence without any GUI.
+ * Frames are decoded and handed to the plugin one after another on the calling thread and the tracks are written
+ * through the configured IModelDataExporter. Neither the MediaPlayer state machine nor the TextureObject and
+ * GraphicsScene rendering is involved, and no event loop is needed.
+ */
+class BatchTracker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchTracker(QObject *parent = 0);
+
+    /**
+     * Tracks every frame of the media and writes the tracks to CFG_DIR_TRACKS.
+     * @param plugin the filepath of the tracking plugin
+     * @param media a video file or a directory holding an image sequence
+     * @return 0 on success, 1 if the plugin or the media could not be loaded
+     */
+    int run(const std::string &plugin, const std::string &media);
+
+private:
+    std::shared_ptr<BioTracker::Core::ImageStream> openMedia(const std::string &media);
+
+    // The AreaInfo keeps a pointer to these, so they have to live as long as the tracking runs
+    playerParameters m_parameters;
+};
+
+#endif // BATCHTRACKER_H
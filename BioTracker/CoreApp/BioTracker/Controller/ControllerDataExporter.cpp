@@ -7,11 +7,14 @@
 #include "settings/Settings.h"
 #include "util/types.h"
 #include <qmessagebox.h>
+#include <qdir.h>
+#include <qfile.h>
 
 
 ControllerDataExporter::ControllerDataExporter(QObject *parent, IBioTrackerContext *context, ENUMS::CONTROLLERTYPE ctr) :
 	IController(parent, context, ctr)
 {
+	_factory = nullptr;
 }
 
 ControllerDataExporter::~ControllerDataExporter()
@@ -43,6 +46,9 @@ void ControllerDataExporter::createModel() {
 }
 
 SourceVideoMetadata ControllerDataExporter::getSourceMetadata() {
+	if (!m_BioTrackerContext) {
+		return _sourceMetadata;
+	}
 	IController* ctrM = m_BioTrackerContext->requestController(ENUMS::CONTROLLERTYPE::PLAYER);
 	MediaPlayer* mplay = dynamic_cast<MediaPlayer*>(ctrM->getModel());
 	SourceVideoMetadata d;
@@ -91,6 +97,9 @@ void ControllerDataExporter::setDataStructure(IModel* exp) {
     else
         m_Model = nullptr;
 
+    //Journals of sessions that didn't end cleanly, looked up before the new one is created
+    _leftoverJournals = QDir(CFG_DIR_TEMP).entryList(QStringList() << "*.tmp.csv", QDir::Files);
+
     qobject_cast<IModelDataExporter*>(m_Model)->open(static_cast<IModelTrackedTrajectory*>(exp));
 
     IModelDataExporter* model;
@@ -102,6 +111,42 @@ void ControllerDataExporter::setDataStructure(IModel* exp) {
 
 void ControllerDataExporter::setComponentFactory(IModelTrackedComponentFactory* exp) {
 	_factory = exp;
+	recoverJournals();
+}
+
+void ControllerDataExporter::recoverJournals() {
+    IModelDataExporter *model = qobject_cast<IModelDataExporter*>(m_Model);
+    QStringList journals = _leftoverJournals;
+    _leftoverJournals.clear();
+    if (!_factory || !model)
+        return;
+
+    foreach(QString name, journals) {
+        QString path = QDir(CFG_DIR_TEMP).filePath(name);
+
+        //Nobody to ask in batch mode
+        if (!m_BioTrackerContext) {
+            std::cout << "Found the export journal of an unfinished session: " << path.toStdString() << std::endl;
+            continue;
+        }
+
+        int ret = QMessageBox::question(nullptr, QString("Trajectory Exporting"),
+            "The export journal of a session that did not finish was found:\n" + path + "\n\nLoad its trajectories?",
+            QMessageBox::Yes | QMessageBox::No);
+        if (ret == QMessageBox::Yes) {
+            //The journal is a CSV file, whichever exporter is configured
+            DataExporterCSV journalReader(this);
+            journalReader._root = model->_root;
+            journalReader.loadFile(path.toStdString());
+            emitViewUpdate();
+        }
+
+        //Kept with the exports, so it is neither lost nor offered again
+        QString kept = QDir(CFG_DIR_TRACKS).filePath(QString(name).replace(".tmp.csv", ".recovered.csv"));
+        QDir().mkpath(CFG_DIR_TRACKS);
+        if (!QFile::rename(path, kept))
+            std::cout << "Could not move the export journal to " << kept.toStdString() << std::endl;
+    }
 }
 
 void ControllerDataExporter::receiveTrackingDone(uint frame) {
@@ -141,6 +186,9 @@ void ControllerDataExporter::rcvPlayerParameters(playerParameters* parameters) {
         qobject_cast<IModelDataExporter*>(m_Model)->setFps(parameters->m_fpsSourceVideo);
         qobject_cast<IModelDataExporter*>(m_Model)->setTitle(parameters->m_CurrentTitle);
     }
+    if (qobject_cast<DataExporterGeneric*>(m_Model) != nullptr) {
+        qobject_cast<DataExporterGeneric*>(m_Model)->setFrameStride(int(parameters->m_CurrentFrameNumber), int(parameters->m_FrameStride));
+    }
 }
 
 int ControllerDataExporter::getTrialNumber() {
@@ -171,6 +219,12 @@ void ControllerDataExporter::receiveFileWritten(QFileInfo fname) {
     QString str = "Exported file:\n";
     str += fname.absoluteFilePath();
 
+    //Nobody to click the message box away in batch mode
+    if (!m_BioTrackerContext) {
+        std::cout << str.toStdString() << std::endl;
+        return;
+    }
+
     int ret = QMessageBox::information(nullptr, QString("Trajectory Exporting"),
         str,
         QMessageBox::Ok);
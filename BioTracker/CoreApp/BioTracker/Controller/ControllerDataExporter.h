@@ -5,6 +5,7 @@
 #include "Interfaces/IModel/IModelTrackedComponentFactory.h"
 #include "QPointer"
 #include "QThread"
+#include "QStringList"
 #include "Model/MediaPlayer.h"
 
 //POD class to bundle some infos
@@ -27,6 +28,10 @@ public:
 	void setComponentFactory(IModelTrackedComponentFactory* exp);
 	IModelTrackedComponentFactory* getComponentFactory() { return _factory; };
 	SourceVideoMetadata getSourceMetadata();
+	/**
+	* Metadata reported when the exporter runs without a context, i.e. in batch mode where there is no MediaPlayer.
+	*/
+	void setSourceMetadata(SourceVideoMetadata metadata) { _sourceMetadata = metadata; };
     int getTrialNumber();
     QString generateBasename(bool temporaryFile);
 
@@ -52,6 +57,14 @@ private Q_SLOTS:
 	void rcvPlayerParameters(playerParameters* parameters);
 
 private:
+	/**
+	* Offers to load the journals of sessions that didn't finish, e.g. after a crash, into the tracking structure.
+	* Afterwards they are moved to the tracks directory.
+	*/
+	void recoverJournals();
+
 	IModelTrackedComponentFactory* _factory;
+	SourceVideoMetadata _sourceMetadata;
+	QStringList _leftoverJournals;
 };
 
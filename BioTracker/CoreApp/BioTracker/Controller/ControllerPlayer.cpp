@@ -68,11 +68,11 @@ void ControllerPlayer::receiveRenderImage(std::shared_ptr<cv::Mat> mat, QString
     ctrTextureObject->receiveCvMat(mat, name);
 }
 
-void ControllerPlayer::receiveImageToTracker(std::shared_ptr<cv::Mat> mat, uint number) {
+void ControllerPlayer::receiveImageToTracker(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs, quint64 sequence) {
     IController* ctr = m_BioTrackerContext->requestController(ENUMS::CONTROLLERTYPE::PLUGIN);
     QPointer< ControllerPlugin > ctrPlugin = qobject_cast<ControllerPlugin*>(ctr);
 
-    ctrPlugin->sendCurrentFrameToPlugin(mat, number);
+    ctrPlugin->sendCurrentFrameToPlugin(mat, number, captureTimeUs, sequence);
 }
 
 void ControllerPlayer::changeImageView(QString str) {
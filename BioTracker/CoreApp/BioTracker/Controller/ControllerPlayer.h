@@ -100,7 +100,7 @@ class ControllerPlayer : public IController {
 		/**
 		* This SLOT receives a cv::Mat and its frame number and hands it over to the ControllerPlugin for Tracking in the BioTracker Plugin.
 		*/
-		void receiveImageToTracker(std::shared_ptr<cv::Mat> mat, uint number);
+		void receiveImageToTracker(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs, quint64 sequence);
 		/**
 		* This SLOT receives a framenumber and hands it over to the ControllerTrackedComponentCore for visualizing in the main app.
 		*/
@@ -15,7 +15,8 @@
 
 
 ControllerPlugin::ControllerPlugin(QObject* parent, IBioTrackerContext* context, ENUMS::CONTROLLERTYPE ctr) :
-	IController(parent, context, ctr) {
+	IController(parent, context, ctr),
+	m_trackingLock(QMutex::Recursive) {
 	m_BioTrackerPlugin = NULL;
 
 	m_TrackingThread = new QThread(this);
@@ -209,6 +210,7 @@ void ControllerPlugin::connectPlugin() {
 
 	IController* ctrC = m_BioTrackerContext->requestController(ENUMS::CONTROLLERTYPE::TRACKEDCOMPONENTCORE);
 	ControllerTrackedComponentCore* ctrCompView = qobject_cast<ControllerTrackedComponentCore*>(ctrC);
+	ctrCompView->setTrackingLock(&m_trackingLock);
 
 	IController* ctrD = m_BioTrackerContext->requestController(ENUMS::CONTROLLERTYPE::COREPARAMETER);
 	ControllerCoreParameter* ctrCoreParam = qobject_cast<ControllerCoreParameter*>(ctrD);
@@ -218,7 +220,12 @@ void ControllerPlugin::connectPlugin() {
 
 	QObject* obj = dynamic_cast<QObject*>(m_BioTrackerPlugin);
 
-	QObject::connect(obj, SIGNAL(emitTrackingDone(uint)), ctDataEx, SLOT(receiveTrackingDone(uint)));
+	//Tracking runs in the tracking thread
+	IBioTrackerPlugin* plugin = m_BioTrackerPlugin;
+	QObject::connect(this, &ControllerPlugin::signalCurrentFrameToPlugin, obj, [this, plugin](std::shared_ptr<cv::Mat> mat, uint frameNumber, qint64 captureTimeUs, quint64 sequence) {
+		QMutexLocker locker(&m_trackingLock);
+		plugin->receiveCapturedFrameFromMainApp(mat, frameNumber, captureTimeUs, sequence);
+	}, Qt::QueuedConnection);
 
 	QObject::connect(obj, SIGNAL(emitCvMat(std::shared_ptr<cv::Mat>, QString)),
 					 ctrTexture, SLOT(receiveCvMat(std::shared_ptr<cv::Mat>, QString)));
@@ -226,7 +233,7 @@ void ControllerPlugin::connectPlugin() {
 	//TODO whyy do this two times??
 	QObject::connect(obj, SIGNAL(emitTrackingDone(uint)), model, SLOT(receiveTrackingOperationDone()));
 
-	QObject::connect(obj, SIGNAL(emitTrackingDone(uint)), ctrCompView, SLOT(receiveVisualizeTrackingModel(uint)));
+	QObject::connect(obj, SIGNAL(emitTrackingDone(uint)), this, SLOT(receiveTrackingDone(uint)));
 
 	QObject::connect(obj, SIGNAL(emitChangeDisplayImage(QString)), ctrPlayer, SLOT(receiveChangeDisplayImage(QString)));
 
@@ -278,6 +285,7 @@ void ControllerPlugin::disconnectPlugin() {
 void ControllerPlugin::receiveRemoveTrajectory(IModelTrackedTrajectory * trajectory)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitRemoveTrajectory(trajectory);
 		emitUpdateView();
 	}
@@ -292,6 +300,7 @@ void ControllerPlugin::receiveRemoveTrajectory(IModelTrackedTrajectory * traject
 void ControllerPlugin::receiveRemoveTrajectoryId(int id)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitRemoveTrajectoryId(id);
 		emitUpdateView();
 	}
@@ -306,6 +315,7 @@ void ControllerPlugin::receiveRemoveTrajectoryId(int id)
 void ControllerPlugin::receiveRemoveTrackEntity(IModelTrackedTrajectory * trajectory, uint frameNumber)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitRemoveTrackEntity(trajectory, frameNumber);
 		emitUpdateView();
 	}
@@ -321,6 +331,7 @@ void ControllerPlugin::receiveRemoveTrackEntity(IModelTrackedTrajectory * trajec
 void ControllerPlugin::receiveAddTrajectory(QPoint pos)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitAddTrajectory(pos);
 		emitUpdateView();
 	}
@@ -335,6 +346,7 @@ void ControllerPlugin::receiveAddTrajectory(QPoint pos)
 void ControllerPlugin::receiveMoveElement(IModelTrackedTrajectory * trajectory, uint frameNumber, QPoint pos, int toMove)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitMoveElement(trajectory, frameNumber, pos);
 		//only emit the update after the last move is processed
 		if (toMove == 1) {
@@ -354,6 +366,7 @@ void ControllerPlugin::receiveMoveElement(IModelTrackedTrajectory * trajectory,
 void ControllerPlugin::receiveSwapIds(IModelTrackedTrajectory * trajectory0, IModelTrackedTrajectory * trajectory1)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitSwapIds(trajectory0, trajectory1);
 		emitUpdateView();
 	}
@@ -369,6 +382,7 @@ void ControllerPlugin::receiveSwapIds(IModelTrackedTrajectory * trajectory0, IMo
 void ControllerPlugin::receiveValidateTrajectory(int id)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitValidateTrajectory(id);
 		emitUpdateView();
 	}
@@ -383,6 +397,7 @@ void ControllerPlugin::receiveValidateTrajectory(int id)
 void ControllerPlugin::receiveValidateEntity(IModelTrackedTrajectory * trajectory, uint frameNumber)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitValidateEntity(trajectory, frameNumber);
 		emitUpdateView();
 	}
@@ -398,6 +413,7 @@ void ControllerPlugin::receiveValidateEntity(IModelTrackedTrajectory * trajector
 void ControllerPlugin::receiveToggleFixTrack(IModelTrackedTrajectory * trajectory, bool toggle)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitToggleFixTrack(trajectory, toggle);
 		emitUpdateView();
 	}
@@ -413,6 +429,7 @@ void ControllerPlugin::receiveToggleFixTrack(IModelTrackedTrajectory * trajector
 void ControllerPlugin::receiveEntityRotation(IModelTrackedTrajectory * trajectory, double angle, uint frameNumber)
 {
 	if (m_paused) {
+		QMutexLocker locker(&m_trackingLock);
 		emitEntityRotation(trajectory, angle, frameNumber);
 		emitUpdateView();
 	}
@@ -437,11 +454,12 @@ void ControllerPlugin::receiveCurrentFrameNumberToPlugin(uint frameNumber)
 	Q_EMIT signalCurrentFrameNumberToPlugin(frameNumber);
 }
 
-void ControllerPlugin::sendCurrentFrameToPlugin(std::shared_ptr<cv::Mat> mat, uint number) {
+void ControllerPlugin::sendCurrentFrameToPlugin(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs, quint64 sequence) {
 	m_currentFrameNumber = number;
 
 	//Prevent calling the plugin if none is loaded
 	if (m_BioTrackerPlugin) {
+		QMutexLocker locker(&m_trackingLock);
 		while (!m_editQueue.isEmpty()) {
 			queueElement edit = m_editQueue.dequeue();
 
@@ -479,10 +497,22 @@ void ControllerPlugin::sendCurrentFrameToPlugin(std::shared_ptr<cv::Mat> mat, ui
 				break;
 			}
 		}
-		m_BioTrackerPlugin->receiveCurrentFrameFromMainApp(mat, number);
+		locker.unlock();
+
+		Q_EMIT signalCurrentFrameToPlugin(mat, number, captureTimeUs, sequence);
 	}
 }
 
-void ControllerPlugin::receiveTrackingDone() {
+void ControllerPlugin::receiveTrackingDone(uint frameNumber) {
+	IController* ctr = m_BioTrackerContext->requestController(ENUMS::CONTROLLERTYPE::TRACKEDCOMPONENTCORE);
+	ControllerTrackedComponentCore* ctrCompView = qobject_cast<ControllerTrackedComponentCore*>(ctr);
+
+	IController* ctrData = m_BioTrackerContext->requestController(ENUMS::CONTROLLERTYPE::DATAEXPORT);
+	ControllerDataExporter* ctDataEx = qobject_cast<ControllerDataExporter*>(ctrData);
 
+	//The exporter lives in the main thread like all its other users. The frames arrive in order, and the lock
+	//keeps the tracking thread from changing the components while the frame is written.
+	QMutexLocker locker(&m_trackingLock);
+	ctDataEx->receiveTrackingDone(frameNumber);
+	ctrCompView->receiveVisualizeTrackingModel(frameNumber);
 }
@@ -12,6 +12,7 @@
 #include "Interfaces/IBioTrackerPlugin.h"
 #include "QThread"
 #include "QQueue"
+#include "QMutex"
 #include "QPoint"
 
 enum EDIT { REMOVE_TRACK, REMOVE_TRACK_ID, REMOVE_ENTITY, ADD, MOVE, SWAP, FIX, VALIDATE, VALIDATE_ENTITY, ROTATE_ENTITY };
@@ -49,8 +50,10 @@ class ControllerPlugin : public IController {
 
     /**
      * This function hands the received cv::Mat pointer and the current frame number to the PluginLoader.
+     * The frame is tracked in the tracking thread, so the caller can go on with the next frame right away.
+     * captureTimeUs (microseconds since the epoch, 0 if unknown) and sequence are passed on from the image stream.
      */
-    void sendCurrentFrameToPlugin(std::shared_ptr<cv::Mat> mat, uint number);
+    void sendCurrentFrameToPlugin(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs = 0, quint64 sequence = 0);
 
 	void selectPlugin(QString str);
 
@@ -68,6 +71,7 @@ signals:
 
 	void emitUpdateView();
 	void signalCurrentFrameNumberToPlugin(uint frameNumber);
+	void signalCurrentFrameToPlugin(std::shared_ptr<cv::Mat> mat, uint frameNumber, qint64 captureTimeUs, quint64 sequence);
 
 	// IController interface
   protected:
@@ -85,8 +89,9 @@ signals:
 	/**
 	 *
 	 * If Tracking is active and the tracking process was finished, the Plugin is able to emit a Signal that triggers this SLOT.
+	 * It visualizes the tracked frame while the tracking thread might already work on the next one.
 	 */
-	void receiveTrackingDone();
+	void receiveTrackingDone(uint frameNumber);
 	/**
 	*
 	* Receive command to remove a trajectory and put it in edit queue
@@ -141,6 +146,10 @@ signals:
 
 	QPointer< QThread >  m_TrackingThread;
 
+	// Held while the plugin tracks a frame and while the main thread edits or visualizes the tracked components.
+	// Recursive, as the view takes it again when it is refreshed from within an edit or a tracking-done
+	QMutex m_trackingLock;
+
 	bool m_paused = true;
 
 	uint m_currentFrameNumber = 0;
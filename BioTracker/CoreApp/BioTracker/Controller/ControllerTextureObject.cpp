@@ -17,7 +17,12 @@ void ControllerTextureObject::changeTextureModel(QString name) {
         name = m_DefaultTextureName;
 
     checkIfTextureModelExists(name);
+    // only the shown texture converts its images
+    TextureObject* previous = qobject_cast<TextureObject*>(m_Model);
+    if (previous)
+        previous->setActive(false);
     m_Model = m_TextureObjects.value(name);
+    m_TextureObjects.value(name)->setActive(true);
 
     changeTextureView(m_Model);
 }
@@ -40,7 +45,7 @@ void ControllerTextureObject::connectControllerToController() {
 void ControllerTextureObject::receiveCvMat(std::shared_ptr<cv::Mat> mat, QString name) {
     checkIfTextureModelExists(name);
 
-    m_TextureObjects.value(name)->set(*mat);
+    m_TextureObjects.value(name)->set(mat);
 
 }
 
@@ -48,6 +53,7 @@ void ControllerTextureObject::createModel() {
     createNewTextureObjectModel(m_DefaultTextureName);
 
     m_Model = m_TextureObjects.value(m_DefaultTextureName);
+    m_TextureObjects.value(m_DefaultTextureName)->setActive(true);
 }
 
 void ControllerTextureObject::createView() {
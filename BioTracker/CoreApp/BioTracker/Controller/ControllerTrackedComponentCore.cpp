@@ -123,6 +123,7 @@ void ControllerTrackedComponentCore::receiveToggleFixTrack(IModelTrackedTrajecto
 
 void ControllerTrackedComponentCore::receiveUpdateView()
 {
+	QMutexLocker locker(m_trackingLock);
 	TrackedComponentView* compView = dynamic_cast<TrackedComponentView*>(m_View);
 	compView->getNotified();
 	//signal the core parameter controller to update the track number
@@ -157,6 +158,7 @@ void ControllerTrackedComponentCore::addModel(IModel* model)
 	TrackedComponentView* view = dynamic_cast<TrackedComponentView*>(m_View);
 	
 	//signal initial track number to core params
+	QMutexLocker locker(m_trackingLock);
 	IModelTrackedTrajectory *iModel = dynamic_cast<IModelTrackedTrajectory *>(getModel());
 	if (iModel) {
 		int trackNumber = iModel->validCount();
@@ -167,6 +169,7 @@ void ControllerTrackedComponentCore::addModel(IModel* model)
 void ControllerTrackedComponentCore::receiveVisualizeTrackingModel(uint framenumber)
 {
 	//signal the view to update track entities
+	QMutexLocker locker(m_trackingLock);
 	TrackedComponentView* compView = dynamic_cast<TrackedComponentView*>(m_View);
 	compView->updateShapes(framenumber);
 	//signal the core parameter controller to update the track number
@@ -3,6 +3,7 @@
 
 #include "Interfaces/IController/IController.h"
 #include "Interfaces/IModel/IModelTrackedTrajectory.h"
+#include "QMutex"
 
 class ControllerTrackedComponentCore : public IController
 {
@@ -16,6 +17,10 @@ class ControllerTrackedComponentCore : public IController
 
 		IModel* getCoreParameter();
 
+		//the plugin controller's lock, to be held while reading the tracked components
+		void setTrackingLock(QMutex *lock) { m_trackingLock = lock; };
+		QMutex *getTrackingLock() { return m_trackingLock; };
+
 	signals:
 		// signal to ctrPlugin to remove trajectory
 		void emitRemoveTrajectory(IModelTrackedTrajectory* trajectory);
@@ -84,6 +89,7 @@ class ControllerTrackedComponentCore : public IController
 
 		IView* m_parameterView;
 		IModel* m_coreParameterModel;
+		QMutex* m_trackingLock = nullptr;
 };
 
 #endif // CONTROLLERTRACKEDCOMPONENTCORE_H
@@ -12,7 +12,6 @@ using namespace AreaMemory;
 AreaInfo::AreaInfo(QObject *parent) :
     IModelAreaDescriptor(parent)
 {
-    _parms = nullptr;
     _rect = std::make_shared<AreaInfoElement>();
     _rect->setShowNumbers(true);
     _rect->setAreaType(BiotrackerTypes::AreaType::RECT);
@@ -36,7 +35,7 @@ void AreaInfo::reset(int w, int h) {
     _vdimY = h;
 
 
-    QVector<QString> vertices = _parms != nullptr ? getVertices(_parms->m_CurrentFilename) : QVector<QString>();
+    QVector<QString> vertices = _hasFrame ? getVertices(_filename) : QVector<QString>();
 
     if ( vertices == DEFAULT_PAIR  //couldn't find entry
         || vertices.empty()) //biotracker just started
@@ -61,12 +60,11 @@ void AreaInfo::reset(int w, int h) {
 
 void AreaInfo::loadAreas() {
 
-    QVector<QString> pair = getVertices(_parms ? _parms->m_CurrentFilename : "");
+    QVector<QString> pair = getVertices(_hasFrame ? _filename : "");
 
     if (pair[1] == QString(DEFAULT_RECT)) {
-        if (_parms) {
-            std::shared_ptr<cv::Mat> m = _parms->m_CurrentFrame;
-            reset(m->size().width, m->size().height);
+        if (_hasFrame) {
+            reset(_frameW, _frameH);
         }
         else {
             reset(100, 100);
@@ -83,38 +81,41 @@ void AreaInfo::loadAreas() {
 
 void AreaInfo::rcvPlayerParameters(playerParameters* parameters)
 {
-    if (_parms == nullptr || _parms->m_CurrentFilename != parameters->m_CurrentFilename) {
+    if (!_hasFrame || _filename != parameters->m_CurrentFilename) {
         _rectInitialized = false;
     }
     if (parameters->m_CurrentFrame == nullptr) {
         return;
     }
 
-    _parms = parameters;
-    std::shared_ptr<cv::Mat> m = parameters->m_CurrentFrame;
-    if ((m->size().width != _vdimX || m->size().height != _vdimY) &&
+    //the player overwrites the parameters with the next frame, so keep copies only
+    _hasFrame = true;
+    _filename = parameters->m_CurrentFilename;
+    _frameW = parameters->m_CurrentFrame->size().width;
+    _frameH = parameters->m_CurrentFrame->size().height;
+    if ((_frameW != _vdimX || _frameH != _vdimY) &&
         _useEntireScreen) {
-        reset(m->size().width, m->size().height);
+        reset(_frameW, _frameH);
         loadAreas();
         updateRectification();
     }
 }
 
 void AreaInfo::updateRectification() {
-    if (_parms) {
+    if (_hasFrame) {
         if (!_rectInitialized) {
-            QVector<QString> vertices = getVertices(_parms->m_CurrentFilename);
+            QVector<QString> vertices = getVertices(_filename);
             std::vector<QPoint> pts = toQPointVector(vertices[0]);
             Rectification::instance().setArea(pts);
             Rectification::instance().setupRecitification(100, 100, _vdimX, _vdimY);
             _rectInitialized = true;
         }
         else {
-            QVector<QString> vertices = getVertices(_parms->m_CurrentFilename);
+            QVector<QString> vertices = getVertices(_filename);
             Rectification::instance().setArea(_rect->getQVertices());
             Rectification::instance().setupRecitification(100, 100, _vdimX, _vdimY);
 
-            setVertices(_parms->m_CurrentFilename,
+            setVertices(_filename,
                 QVector<QString>{
                 cvPointsToString(_rect->getVertices()).c_str(),
                 cvPointsToString(_apperture->getVertices()).c_str(),
@@ -132,11 +133,11 @@ void AreaInfo::setRectificationDimensions(double w, double h) {
 
 void AreaInfo::updateApperture() {
 
-    if (_parms && _rectInitialized) {
-            QVector<QString> vertices = getVertices(_parms->m_CurrentFilename);
+    if (_hasFrame && _rectInitialized) {
+            QVector<QString> vertices = getVertices(_filename);
             std::vector<cv::Point> p = _apperture->getVertices();
 
-            setVertices(_parms->m_CurrentFilename,
+            setVertices(_filename,
                 QVector<QString>{
                 cvPointsToString(_rect->getVertices()).c_str(),
                 cvPointsToString(p).c_str(),
@@ -49,7 +49,11 @@ private:
     bool _useEntireScreen = false;
     int _vdimX = 1;
     int _vdimY = 1;
-    playerParameters* _parms;
+    //filename and frame size of the last frame the player reported
+    bool _hasFrame = false;
+    QString _filename;
+    int _frameW = 0;
+    int _frameH = 0;
     bool _rectInitialized = false;
 
 public Q_SLOTS:
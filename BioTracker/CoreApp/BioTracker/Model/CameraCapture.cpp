@@ -0,0 +1,169 @@
+#include "CameraCapture.h"
+
+#include <iostream>
+
+// Frames in use outside the queue at the same time: display, tracking pipeline and recorder.
+// Beyond that the capture thread allocates, it never waits for a buffer.
+#define CAPTUREPOOLEXTRA 8
+// Consecutive failed grabs after which the camera counts as gone
+#define CAPTUREMAXFAILURES 50
+
+namespace BioTracker {
+	namespace Core {
+
+		CameraCapture::CameraCapture(cv::VideoCapture &capture, size_t capacity, DropPolicy policy)
+			: m_capture(capture)
+			, m_policy(policy)
+			, m_slots(capacity > 0 ? capacity : 1)
+			, m_head(0)
+			, m_count(0)
+			, m_abort(false)
+			, m_failed(false)
+			, m_stride(1)
+			, m_captured(0)
+			, m_dropped(0) {
+		}
+
+		CameraCapture::~CameraCapture() {
+			stop();
+		}
+
+		void CameraCapture::start() {
+			if (m_thread.joinable()) {
+				return;
+			}
+			m_thread = std::thread(&CameraCapture::run, this);
+		}
+
+		void CameraCapture::stop() {
+			if (!m_thread.joinable()) {
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_abort = true;
+			}
+			m_thread.join();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (Frame &slot : m_slots) {
+				slot.image.reset();
+			}
+			m_head = 0;
+			m_count = 0;
+			m_abort = false;
+			m_failed = false;
+		}
+
+		bool CameraCapture::pop(Frame &frame, std::chrono::milliseconds timeout) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (!m_notEmpty.wait_for(lock, timeout, [this] { return m_count > 0 || m_failed; }) || m_count == 0) {
+				return false;
+			}
+
+			Frame &slot = m_slots[m_head];
+			frame.image = std::move(slot.image);
+			frame.captureTime = slot.captureTime;
+			frame.sequence = slot.sequence;
+			m_head = (m_head + 1) % m_slots.size();
+			m_count--;
+			return true;
+		}
+
+		void CameraCapture::setSink(FrameSink sink) {
+			std::lock_guard<std::mutex> lock(m_sinkMutex);
+			m_sink = sink;
+		}
+
+		void CameraCapture::setStride(size_t stride) {
+			m_stride = stride > 0 ? stride : 1;
+		}
+
+		void CameraCapture::run() {
+			unsigned long long sequence = 0;
+			size_t skipped = 0;
+			int failures = 0;
+			while (true) {
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (m_abort) {
+						return;
+					}
+				}
+
+				// grab() returns as soon as the driver has the frame; the time is taken before decoding it
+				if (!m_capture.grab()) {
+					if (++failures >= CAPTUREMAXFAILURES) {
+						std::cout << "Camera delivers no frames anymore" << std::endl;
+						{
+							std::lock_guard<std::mutex> lock(m_mutex);
+							m_failed = true;
+						}
+						m_notEmpty.notify_all();
+						return;
+					}
+					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+					continue;
+				}
+				failures = 0;
+				const std::chrono::system_clock::time_point captureTime = std::chrono::system_clock::now();
+
+				// Frames the player skips are only decoded if the sink wants them
+				const bool offered = ++skipped >= m_stride;
+				if (offered) {
+					skipped = 0;
+				}
+				else {
+					std::lock_guard<std::mutex> lock(m_sinkMutex);
+					if (!m_sink) {
+						continue;
+					}
+				}
+
+				Frame frame;
+				frame.captureTime = captureTime;
+				frame.sequence = offered ? ++sequence : sequence;
+				frame.image = m_pool ? m_pool->acquire() : nullptr;
+				if (!frame.image) {
+					frame.image = std::make_shared<cv::Mat>();
+				}
+				if (!m_capture.retrieve(*frame.image) || frame.image->empty()) {
+					continue;
+				}
+				if (!m_pool || !m_pool->matches(frame.image->rows, frame.image->cols, frame.image->type())) {
+					m_pool = FramePool::create(frame.image->rows, frame.image->cols, frame.image->type(),
+						m_slots.size() + CAPTUREPOOLEXTRA);
+				}
+				m_captured++;
+
+				{
+					std::lock_guard<std::mutex> lock(m_sinkMutex);
+					if (m_sink) {
+						m_sink(frame);
+					}
+				}
+				if (!offered) {
+					continue;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (m_count == m_slots.size()) {
+						m_dropped++;
+						if (m_policy == DROP_NEWEST) {
+							continue;
+						}
+						m_head = (m_head + 1) % m_slots.size();
+						m_count--;
+					}
+					// assigning releases the frame a dropped slot still held
+					Frame &slot = m_slots[(m_head + m_count) % m_slots.size()];
+					slot = std::move(frame);
+					m_count++;
+				}
+				m_notEmpty.notify_one();
+			}
+		}
+
+	}
+}
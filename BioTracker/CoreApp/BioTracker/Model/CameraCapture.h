@@ -0,0 +1,119 @@
+#ifndef CAMERACAPTURE_H
+#define CAMERACAPTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+
+#include "util/FramePool.h"
+
+namespace BioTracker {
+namespace Core {
+
+/**
+ * The CameraCapture runs a dedicated thread which grabs every frame from a camera as soon as the driver delivers it,
+ * so the driver's buffer never fills up with stale frames while tracking is busy. Each frame is stamped with the time
+ * it was grabbed and a sequence number, and put into a small bounded ring the player thread pops from.
+ *
+ * When the ring is full the policy decides which frame is lost: DROP_OLDEST keeps the newest frames (lowest latency,
+ * with a capacity of 1 the player always gets the latest frame), DROP_NEWEST keeps the queued ones.
+ * Gaps in the sequence numbers of popped frames are the frames dropped that way.
+ *
+ * With a stride n only every n-th frame is offered to the player, the others are grabbed but not decoded, which
+ * saves the decoding cost of the skipped frames. Sequence numbers count the offered frames only.
+ *
+ * A sink can be set that is called in the capture thread for every frame, skipped, dropped or not, e.g. to record
+ * the input. While a sink is set all frames are decoded. While the capture thread is running it owns the capture
+ * exclusively.
+ */
+class CameraCapture {
+  public:
+    enum DropPolicy {
+        DROP_OLDEST = 0,
+        DROP_NEWEST = 1
+    };
+
+    struct Frame {
+        std::shared_ptr<cv::Mat> image;
+        std::chrono::system_clock::time_point captureTime;
+        // starts at 1
+        unsigned long long sequence;
+    };
+
+    typedef std::function<void(const Frame &)> FrameSink;
+
+    /**
+     * @param capture the opened camera. Must outlive this object.
+     * @param capacity the number of frames to queue for the player.
+     * @param policy which frame to drop when the queue is full.
+     */
+    CameraCapture(cv::VideoCapture &capture, size_t capacity, DropPolicy policy);
+    ~CameraCapture();
+
+    /**
+     * Starts the capture thread. Does nothing if it is already running.
+     */
+    void start();
+
+    /**
+     * Stops and joins the capture thread and drops all queued frames.
+     */
+    void stop();
+
+    /**
+     * Blocks until a frame is queued and moves it into frame.
+     * Returns false if the camera delivered nothing within timeout or has failed.
+     */
+    bool pop(Frame &frame, std::chrono::milliseconds timeout);
+
+    /**
+     * Sets the function called for every captured frame. Pass an empty function to remove it.
+     */
+    void setSink(FrameSink sink);
+
+    /**
+     * Offers only every stride-th frame to the player. Takes effect with the next frame.
+     */
+    void setStride(size_t stride);
+
+    unsigned long long capturedFrames() const { return m_captured; }
+    unsigned long long droppedFrames() const { return m_dropped; }
+
+  private:
+    void run();
+
+    cv::VideoCapture &m_capture;
+    const DropPolicy m_policy;
+
+    std::vector<Frame> m_slots;
+    size_t m_head;
+    size_t m_count;
+    bool m_abort;
+    bool m_failed;
+
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::thread m_thread;
+
+    std::mutex m_sinkMutex;
+    FrameSink m_sink;
+
+    std::atomic<size_t> m_stride;
+
+    // only touched by the capture thread
+    std::shared_ptr<FramePool> m_pool;
+
+    std::atomic<unsigned long long> m_captured;
+    std::atomic<unsigned long long> m_dropped;
+};
+
+}
+}
+
+#endif // CAMERACAPTURE_H
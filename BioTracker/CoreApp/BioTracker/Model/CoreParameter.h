@@ -58,6 +58,10 @@ public:
 	int m_trackNumber = 0;
 	//Ignore zooming
 	bool m_ignoreZoom = false;
+	//Level of detail: tracks are drawn as plain dots if there are more than m_lodTrackCount of them
+	//or if the view is zoomed out below m_lodZoom
+	int m_lodTrackCount = 150;
+	double m_lodZoom = 0.3;
 
 
 };
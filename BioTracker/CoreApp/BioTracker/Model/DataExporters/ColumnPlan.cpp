@@ -0,0 +1,199 @@
+#include "ColumnPlan.h"
+#include <cstring>
+
+ColumnPlan::ColumnPlan(IModelTrackedComponent *comp) :
+    _metaObject(comp->metaObject())
+{
+    const bool euclidian = dynamic_cast<IModelComponentEuclidian2D*>(comp) != nullptr;
+    const bool temporal = dynamic_cast<IModelComponentTemporal2D*>(comp) != nullptr;
+
+    for (int i = 0; i < _metaObject->propertyCount(); ++i)
+    {
+        QMetaProperty property = _metaObject->property(i);
+        if (!property.isStored(comp) || !property.isStored()) {
+            continue;
+        }
+        Column c;
+        c.getter = resolve(property.name(), euclidian, temporal);
+        c.property = property;
+        _columns.push_back(c);
+        _names.push_back(property.name());
+    }
+}
+
+ColumnPlan::Getter ColumnPlan::resolve(const char *name, bool euclidian, bool temporal)
+{
+    struct Named {
+        const char *name;
+        Getter getter;
+    };
+    static const Named base[] = {
+        { "valid", GETTER_VALID }, { "id", GETTER_ID }
+    };
+    static const Named euclidian2D[] = {
+        { "coordinateUnit", GETTER_COORDINATEUNIT },
+        { "x", GETTER_X }, { "y", GETTER_Y }, { "w", GETTER_W }, { "h", GETTER_H },
+        { "wpx", GETTER_WPX }, { "hpx", GETTER_HPX }, { "rad", GETTER_RAD }, { "deg", GETTER_DEG },
+        { "xpx", GETTER_XPX }, { "ypx", GETTER_YPX }
+    };
+    static const Named temporal2D[] = {
+        { "time", GETTER_TIME }, { "timeString", GETTER_TIMESTRING }
+    };
+
+    for (const Named &n : base) {
+        if (std::strcmp(n.name, name) == 0)
+            return n.getter;
+    }
+    if (euclidian) {
+        for (const Named &n : euclidian2D) {
+            if (std::strcmp(n.name, name) == 0)
+                return n.getter;
+        }
+    }
+    if (temporal) {
+        for (const Named &n : temporal2D) {
+            if (std::strcmp(n.name, name) == 0)
+                return n.getter;
+        }
+    }
+    return GETTER_VARIANT;
+}
+
+bool ColumnPlan::isText(size_t column) const
+{
+    return type(column) == TYPE_TEXT;
+}
+
+ColumnPlan::Type ColumnPlan::type(size_t column) const
+{
+    switch (_columns[column].getter) {
+    case GETTER_VALID:          return TYPE_BOOL;
+    case GETTER_ID:
+    case GETTER_TIME:           return TYPE_INT;
+    case GETTER_COORDINATEUNIT:
+    case GETTER_TIMESTRING:
+    case GETTER_VARIANT:        return TYPE_TEXT;
+    default:                    return TYPE_FLOAT;
+    }
+}
+
+int ColumnPlan::indexOf(const std::string &name) const
+{
+    for (size_t i = 0; i < _names.size(); i++) {
+        if (_names[i] == name)
+            return int(i);
+    }
+    return -1;
+}
+
+QString ColumnPlan::text(IModelTrackedComponent *comp, size_t column) const
+{
+    const Column &c = _columns[column];
+    switch (c.getter) {
+    case GETTER_COORDINATEUNIT: return static_cast<IModelComponentEuclidian2D*>(comp)->getCoordinateUnit();
+    case GETTER_TIMESTRING:     return static_cast<IModelComponentTemporal2D*>(comp)->getTimeString();
+    default:                    return c.property.read(comp).toString();
+    }
+}
+
+// the plan was built from this very type, so the getters and setters resolved for it can't fail
+qint64 ColumnPlan::integer(IModelTrackedComponent *comp, size_t column) const
+{
+    switch (_columns[column].getter) {
+    case GETTER_VALID:  return comp->getValid() ? 1 : 0;
+    case GETTER_ID:     return comp->getId();
+    case GETTER_TIME:   return static_cast<IModelComponentTemporal2D*>(comp)->getTime();
+    default:            return 0;
+    }
+}
+
+float ColumnPlan::real(IModelTrackedComponent *comp, size_t column) const
+{
+    IModelComponentEuclidian2D *e = static_cast<IModelComponentEuclidian2D*>(comp);
+
+    switch (_columns[column].getter) {
+    case GETTER_X:      return e->getX();
+    case GETTER_Y:      return e->getY();
+    case GETTER_W:      return e->getW();
+    case GETTER_H:      return e->getH();
+    case GETTER_WPX:    return e->getWpx();
+    case GETTER_HPX:    return e->getHpx();
+    case GETTER_RAD:    return e->getRad();
+    case GETTER_DEG:    return e->getDeg();
+    case GETTER_XPX:    return e->getXpx();
+    case GETTER_YPX:    return e->getYpx();
+    default:            return 0;
+    }
+}
+
+void ColumnPlan::setText(IModelTrackedComponent *comp, size_t column, const QString &value) const
+{
+    const Column &c = _columns[column];
+    switch (c.getter) {
+    case GETTER_COORDINATEUNIT: static_cast<IModelComponentEuclidian2D*>(comp)->setCoordinateUnit(value); break;
+    case GETTER_TIMESTRING:     static_cast<IModelComponentTemporal2D*>(comp)->setTimeString(value); break;
+    default:                    c.property.write(comp, QVariant(value)); break;
+    }
+}
+
+void ColumnPlan::setInteger(IModelTrackedComponent *comp, size_t column, qint64 value) const
+{
+    switch (_columns[column].getter) {
+    case GETTER_VALID:  comp->setValid(value != 0); break;
+    case GETTER_ID:     comp->setId(int(value)); break;
+    case GETTER_TIME:   static_cast<IModelComponentTemporal2D*>(comp)->setTime(value); break;
+    default:            break;
+    }
+}
+
+void ColumnPlan::setReal(IModelTrackedComponent *comp, size_t column, float value) const
+{
+    IModelComponentEuclidian2D *e = static_cast<IModelComponentEuclidian2D*>(comp);
+
+    switch (_columns[column].getter) {
+    case GETTER_X:      e->setX(value); break;
+    case GETTER_Y:      e->setY(value); break;
+    case GETTER_W:      e->setW(value); break;
+    case GETTER_H:      e->setH(value); break;
+    case GETTER_WPX:    e->setWpx(value); break;
+    case GETTER_HPX:    e->setHpx(value); break;
+    case GETTER_RAD:    e->setRad(value); break;
+    case GETTER_DEG:    e->setDeg(value); break;
+    case GETTER_XPX:    e->setXpx(value); break;
+    case GETTER_YPX:    e->setYpx(value); break;
+    default:            break;
+    }
+}
+
+void ColumnPlan::writeNumber(IModelTrackedComponent *comp, size_t column, TextBuffer &out) const
+{
+    switch (type(column)) {
+    case TYPE_BOOL:     integer(comp, column) ? out.append("true", 4) : out.append("false", 5); break;
+    case TYPE_INT:      out.appendInt(integer(comp, column)); break;
+    case TYPE_FLOAT:    out.appendNumber(real(comp, column)); break;
+    default:            break;
+    }
+}
+
+void ColumnPlan::write(IModelTrackedComponent *comp, const std::string &separator, TextBuffer &out) const
+{
+    if (!comp->getValid()) {
+        for (size_t i = 0; i < _columns.size(); i++)
+            out.append(separator);
+        return;
+    }
+
+    for (size_t i = 0; i < _columns.size(); i++) {
+        out.append(separator);
+        if (isText(i)) {
+            const QByteArray utf8 = text(comp, i).toUtf8();
+            if (utf8.isEmpty())
+                out.append('0');
+            else
+                out.append(utf8.constData(), utf8.size());
+        }
+        else {
+            writeNumber(comp, i, out);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "Interfaces/IModel/IModelTrackedComponent.h"
+#include "TextBuffer.h"
+#include <QMetaProperty>
+#include <string>
+#include <vector>
+
+/**
+*  The stored properties of one tracked component type, resolved once into typed getters.
+*
+*  The numeric properties of the interfaces (x, y, time, valid, ...) are read through their virtual getters and
+*  formatted straight into a TextBuffer. The text properties are returned as QString, the ones unknown to the
+*  interfaces are read through QMetaProperty and QVariant.
+*  A plan is only valid for components of the type it was built from.
+*/
+class ColumnPlan
+{
+public:
+    /**
+    *  Value type of a column, as stored by the binary track format
+    */
+    enum Type {
+        TYPE_BOOL,
+        TYPE_INT,
+        TYPE_FLOAT,
+        TYPE_TEXT
+    };
+
+    /**
+    *  Collects the stored properties of the type of comp, in the order of its meta object.
+    */
+    explicit ColumnPlan(IModelTrackedComponent *comp);
+
+    const QMetaObject *metaObject() const { return _metaObject; }
+
+    /**
+    *  Names of the columns, matching the CSV header
+    */
+    const std::vector<std::string> &names() const { return _names; }
+
+    size_t size() const { return _columns.size(); }
+
+    /**
+    *  Whether the column holds text, otherwise it is a number or a boolean
+    */
+    bool isText(size_t column) const;
+
+    Type type(size_t column) const;
+
+    QString text(IModelTrackedComponent *comp, size_t column) const;
+
+    /**
+    *  Value of a TYPE_BOOL or TYPE_INT column
+    */
+    qint64 integer(IModelTrackedComponent *comp, size_t column) const;
+
+    /**
+    *  Value of a TYPE_FLOAT column
+    */
+    float real(IModelTrackedComponent *comp, size_t column) const;
+
+    /**
+    *  Setters matching the getters above, through the interfaces' setters where there is one
+    */
+    void setText(IModelTrackedComponent *comp, size_t column, const QString &value) const;
+    void setInteger(IModelTrackedComponent *comp, size_t column, qint64 value) const;
+    void setReal(IModelTrackedComponent *comp, size_t column, float value) const;
+
+    /**
+    *  Index of the column with the given name or -1
+    */
+    int indexOf(const std::string &name) const;
+
+    /**
+    *  Appends the value of a number or boolean column
+    */
+    void writeNumber(IModelTrackedComponent *comp, size_t column, TextBuffer &out) const;
+
+    /**
+    *  Appends separator and value of every column as a CSV row part, empty texts become "0".
+    *  Invalid components only get the separators.
+    */
+    void write(IModelTrackedComponent *comp, const std::string &separator, TextBuffer &out) const;
+
+private:
+    enum Getter {
+        GETTER_VALID,
+        GETTER_ID,
+        GETTER_COORDINATEUNIT,
+        GETTER_X,
+        GETTER_Y,
+        GETTER_W,
+        GETTER_H,
+        GETTER_WPX,
+        GETTER_HPX,
+        GETTER_RAD,
+        GETTER_DEG,
+        GETTER_XPX,
+        GETTER_YPX,
+        GETTER_TIME,
+        GETTER_TIMESTRING,
+        GETTER_VARIANT
+    };
+
+    struct Column {
+        Getter getter;
+        QMetaProperty property;
+    };
+
+    static Getter resolve(const char *name, bool euclidian, bool temporal);
+
+    const QMetaObject *_metaObject;
+    std::vector<Column> _columns;
+    std::vector<std::string> _names;
+};
@@ -5,18 +5,34 @@
 #include <qdebug.h>
 #include <qfile.h>
 #include <qdatetime.h>
+#include <cstdlib>
 
 DataExporterCSV::DataExporterCSV(QObject *parent) :
-    DataExporterGeneric(parent)
+    DataExporterGeneric(parent),
+    _journalStream(&_journal),
+    _row(_journalStream, 4096),
+    _journalHeaderWritten(false)
 {
     _root = 0;
     BioTracker::Core::Settings *settings = BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION);
     _separator = settings->getValueOrDefault<std::string>(CFG_SER_CSVSEP, CFG_SER_CSVSEP_VAL);
+    _strideColumn = settings->getValueOrDefault<bool>(CFG_ADAPTIVE_STRIDE, CFG_ADAPTIVE_STRIDE_VAL);
 }
 
 
 DataExporterCSV::~DataExporterCSV()
 {
+    _journal.close();
+}
+
+void DataExporterCSV::open(IModelTrackedTrajectory *root) {
+    DataExporterGeneric::open(root);
+
+    //The journal takes the place of the plain temporary file
+    _ofs.close();
+    _journalHeaderWritten = false;
+    if (!_journal.open(_tmpFile))
+        qDebug() << "Could not open the export journal" << _tmpFile.c_str();
 }
 
 //https://codereview.stackexchange.com/questions/29611/finding-the-number-of-occurrences-of-a-string-in-another-string
@@ -33,78 +49,56 @@ int DataExporterCSV::key_search(const std::string& s, const std::string& key)
 
 
 std::vector<std::string> DataExporterCSV::getHeaderElements(IModelTrackedComponent *comp) {
-    std::vector<std::string> ret;
-
-    for (int i = 0; i<comp->metaObject()->propertyCount(); ++i)
-    {
-        if (comp->metaObject()->property(i).isStored(comp))
-        {
-            if (!comp->metaObject()->property(i).isStored()) {
-                continue;
-            }
-            ret.push_back(comp->metaObject()->property(i).name());
-        }
-    }
-
-    return ret;
+    return getPlan(comp).names();
 }
 
 std::string DataExporterCSV::getHeader(IModelTrackedComponent *comp, int cnt) {
     std::stringstream ss;
 
     ss << "FRAME" << _separator << "MillisecsByFPS";
+    if (_strideColumn)
+        ss << _separator << "STRIDE";
+    const std::vector<std::string> &names = getPlan(comp).names();
     for (int c = 0; c < cnt; c++) {
-        for (int i = 0; i<comp->metaObject()->propertyCount(); ++i)
-        {
-            if (comp->metaObject()->property(i).isStored(comp))
-            {
-                if (!comp->metaObject()->property(i).isStored()) {
-                    continue;
-                }
-                ss << _separator << comp->metaObject()->property(i).name();
-            }
-        }
+        for (const std::string &name : names)
+            ss << _separator << name;
     }
 
     std::string s = ss.str();
     return s;
 }
 
-/* Writes a tracked component to string
+/* Writes a tracked component into the buffer
 */
-std::string DataExporterCSV::writeComponentCSV(IModelTrackedComponent* comp, int tid) {
-    std::stringstream ss;
-
-    for (int i = 0; i<comp->metaObject()->propertyCount(); ++i)
-    {
-        if (comp->metaObject()->property(i).isStored(comp))
-        {
-            if (!comp->metaObject()->property(i).isStored()) {
-                continue;
-            }
-            if (!comp->getValid()) {
-                ss << _separator;
-                continue;
-            }
-            std::string str = comp->metaObject()->property(i).name();
-            QVariant v = comp->metaObject()->property(i).read(comp);
-            std::string val = v.toString().toStdString();
-            val = (val == "" ? "0" : val);
-            ss << _separator << val;
-        }
-    }
-
-    return ss.str();
+void DataExporterCSV::writeComponentCSV(IModelTrackedComponent* comp, int tid, TextBuffer &out) {
+    getPlan(comp).write(comp, _separator, out);
 }
 
-void DataExporterCSV::setProperty(IModelTrackedComponent* comp, std::string key, std::string val) {
-    QString qval = QString(val.c_str());
-    QVariant v(qval);
-    comp->setProperty(key.c_str(), v);
+void DataExporterCSV::setColumn(const ColumnPlan &plan, IModelTrackedComponent* comp, size_t column, const std::string &val) {
+    if (val.empty())
+        return;
+
+    switch (plan.type(column)) {
+    case ColumnPlan::TYPE_BOOL:
+        plan.setInteger(comp, column, val == "true" || val == "1");
+        break;
+    case ColumnPlan::TYPE_INT:
+        plan.setInteger(comp, column, std::strtoll(val.c_str(), nullptr, 10));
+        break;
+    case ColumnPlan::TYPE_FLOAT:
+        plan.setReal(comp, column, std::strtof(val.c_str(), nullptr));
+        break;
+    default:
+        plan.setText(comp, column, QString::fromStdString(val));
+        break;
+    }
 }
 
 void DataExporterCSV::addChildOfChild(IModelTrackedTrajectory *root, IModelTrackedComponent* child, IModelTrackedComponentFactory* factory, int idx) {
     IModelTrackedTrajectory *traj = dynamic_cast<IModelTrackedTrajectory *>(root->getChild(child->getId()));
+    //The trajectory may take over the child on add
+    int id = child->getId();
+    bool valid = child->getValid();
 
     if (traj) {
         traj->add(child, idx);
@@ -114,10 +108,10 @@ void DataExporterCSV::addChildOfChild(IModelTrackedTrajectory *root, IModelTrack
         traj = static_cast<IModelTrackedTrajectory*>(factory->getNewTrackedTrajectory("0"));
         traj->setValid(false);
         traj->add(child, idx);
-        root->add(traj, child->getId());
+        root->add(traj, id);
     }
     
-    traj->setValid(child->getValid());
+    traj->setValid(valid);
 }
 
 void DataExporterCSV::loadFile(std::string file)
@@ -136,23 +130,29 @@ void DataExporterCSV::loadFile(std::string file)
         return;
     }
     IModelTrackedComponent* dummy = static_cast<IModelTrackedComponent*>(factory->getNewTrackedElement("0"));
-    std::vector<std::string> headerElsStr = getHeaderElements(dummy);
-    int headerEls = headerElsStr.size();
+    const ColumnPlan &plan = getPlan(dummy);
+    int headerEls = plan.size();
+    delete dummy;
 
     std::vector<std::string> strs;
     split(line, strs, _separator[0]);
-    int idcnt = (strs.size() - 2) / headerEls;
+    //The global header has an optional STRIDE column
+    int globals = strs.size() > 2 && strs[2] == "STRIDE" ? 3 : 2;
+    int idcnt = (strs.size() - globals) / headerEls;
 
     //Add data lines
     while (!ifs.eof()) {
 
         getline(ifs, line);
+        //A last line without line break is a row torn by a crash while journaling
+        if (ifs.eof() && !line.empty())
+            break;
         std::vector<std::string> strs;
         split(line, strs, _separator[0]);
-        if (strs.size() < 2)
+        if (strs.size() < globals)
             continue;
 
-        //First two entries are the "global header" (trajectory info, same for all at current timeslice)
+        //First entries are the "global header" (trajectory info, same for all at current timeslice)
         int frame = atoi(strs[0].c_str());
         float frameById = atof(strs[1].c_str());
 
@@ -160,8 +160,8 @@ void DataExporterCSV::loadFile(std::string file)
         int curTrajCnt = 0;
         IModelTrackedComponent* comp = static_cast<IModelTrackedComponent*>(factory->getNewTrackedElement("0"));
 
-        for (int x = 2; x < strs.size(); x++) {
-            setProperty(comp, headerElsStr[curTrajCnt], strs[x].c_str());
+        for (int x = globals; x < strs.size(); x++) {
+            setColumn(plan, comp, curTrajCnt, strs[x]);
 
             curTrajCnt++;
             if (curTrajCnt >= headerEls) {
@@ -175,14 +175,33 @@ void DataExporterCSV::loadFile(std::string file)
 }
 
 void DataExporterCSV::write(int idx) {
-    if (!_root) {
+    if (!_root || !_journal.isOpen()) {
         qDebug() << "No output opened!";
         return;
     }
 
     //TODO there is some duplicated code here
-    _ofs << std::to_string(idx)
-        << _separator + std::to_string((long long)((((double)idx) / _fps) * 1000));
+    TextBuffer &row = _row;
+    if (!_journalHeaderWritten) {
+        ControllerDataExporter *ctr = dynamic_cast<ControllerDataExporter*>(_parent);
+        IModelTrackedComponentFactory* factory = ctr ? ctr->getComponentFactory() : nullptr;
+        if (factory != nullptr) {
+            IModelTrackedComponent *ptraj = static_cast<IModelTrackedComponent*>(factory->getNewTrackedElement("0"));
+            row.append("# Export journal, load this file to recover the session\n");
+            row.append(getHeader(ptraj, 1));
+            row.append('\n');
+            delete ptraj;
+            _journalHeaderWritten = true;
+        }
+    }
+
+    row.appendInt(idx);
+    row.append(_separator);
+    row.appendInt((long long)((((double)idx) / _fps) * 1000));
+    if (_strideColumn) {
+        row.append(_separator);
+        row.appendInt(getFrameStride(idx));
+    }
 
     //Write single trajectory
     int trajNumber = 0;
@@ -196,12 +215,14 @@ void DataExporterCSV::write(int idx) {
             else
                 e = dynamic_cast<IModelTrackedPoint*>(t->getChild(idx));
             if (e && e->getValid()) {
-                _ofs << writeComponentCSV(e, trajNumber);
+                writeComponentCSV(e, trajNumber, row);
             }
             trajNumber++;
         }
     }
-    _ofs << std::endl;
+    //Only hands the row to the journal's writer thread
+    row.append('\n');
+    row.flush();
 }
 
 void DataExporterCSV::finalizeAndReInit() {
@@ -218,9 +239,9 @@ void DataExporterCSV::writeAll(std::string f) {
         qDebug() << "No output opened!";
         return;
     }
-    if (_ofs.is_open()) {
-        _ofs.close();
-    }
+    //The journal keeps running, writeAll only reads the structure.
+    //Everything tracked so far is on disk first, in case the rewrite fails.
+    _journal.checkpoint();
 
     //Find max length of all tracks
     int max = getMaxLinecount();
@@ -266,41 +287,52 @@ void DataExporterCSV::writeAll(std::string f) {
 
     //Write out everything to a new file
     int trajNumber = 0;
+    TextBuffer out(o);
+
+    //The tracks don't change while writing, so look them up only once
+    std::vector<IModelTrackedTrajectory *> tracks;
+    for (int i = 0; i < _root->size(); i++) {
+        IModelTrackedTrajectory *t = dynamic_cast<IModelTrackedTrajectory *>(_root->getChild(i));
+        if (t && t->validCount() > 0)
+            tracks.push_back(t);
+    }
+    int count = _root->validCount();
 
     //idx is the frame number
     for (int idx = 0; idx < max; idx++) {
 
-        o << std::to_string(idx)
-            << _separator + std::to_string((((float)idx) / _fps) * 1000);
+        out.appendInt(idx);
+        out.append(_separator);
+        out.appendNumber((((float)idx) / _fps) * 1000);
+        if (_strideColumn) {
+            out.append(_separator);
+            out.appendInt(getFrameStride(idx));
+        }
 
         int linecnt = 0;
         //i is the track number
-        for (int i = 0; i < _root->size(); i++) {
-
-            IModelTrackedTrajectory *t = dynamic_cast<IModelTrackedTrajectory *>(_root->getChild(i));
-            if (t && t->validCount() > 0) {
-                IModelTrackedPoint *e = dynamic_cast<IModelTrackedPoint*>(t->getChild(idx));
-                if (e) {
-                    std::string line = writeComponentCSV(e, trajNumber);
-                    o << line;
-                    linecnt++;
-                }
-                trajNumber++;
+        for (IModelTrackedTrajectory *t : tracks) {
+            IModelTrackedPoint *e = dynamic_cast<IModelTrackedPoint*>(t->getChild(idx));
+            if (e) {
+                writeComponentCSV(e, trajNumber, out);
+                linecnt++;
             }
+            trajNumber++;
         }
-        int count = _root->validCount();
         while (linecnt < count) {
             for (int i = 0; i<headerCount; i++)
-                o << _separator;
+                out.append(_separator);
             linecnt++;
         }
-        o << std::endl;
+        out.append('\n');
+        out.endRow();
     }
+    out.flush();
     o.close();
 }
 
 void DataExporterCSV::close() {
-    _ofs.close();
+    _journal.close();
 
     if (!_root || _root->size() == 0) {
         //Remove temporary file
@@ -1,6 +1,13 @@
 #pragma once
 #include "DataExporterGeneric.h"
-
+#include "ExportJournal.h"
+
+/**
+*  Exports the tracking structure as CSV.
+*  While tracking, every frame is appended to the temporary file, which is an ExportJournal written in the
+*  background. It is a CSV file itself, so a session lost in a crash is recovered by loading it, which
+*  ControllerDataExporter offers when the next session starts.
+*/
 class DataExporterCSV : public DataExporterGeneric
 {
 	Q_OBJECT
@@ -8,6 +15,11 @@ public:
 	DataExporterCSV(QObject *parent = 0);
 	~DataExporterCSV();
 
+    /**
+    *  Opens the journal for the passed tracking structure
+    */
+    void open(IModelTrackedTrajectory *root) override;
+
     /**
     *  Add a single frame index to the output file
     *  @param Index to write or -1 for latest
@@ -41,6 +53,8 @@ private:
     std::string writeTrackpoint(IModelTrackedPoint *e, int trajNumber);
 
     std::string _separator;
+    //With an adaptive stride the frames are not equally spaced, so each row gets the stride it was reached with
+    bool _strideColumn;
 
 
     /* finding the number of occurrences of a string in another strin
@@ -63,15 +77,24 @@ private:
     */
     std::string getHeader(IModelTrackedComponent *comp, int cnt);
 
-    /* Sets sets a property to a components.
+    /* Sets a column of a component from its CSV text, empty texts are left out.
     */
-    void setProperty(IModelTrackedComponent* comp, std::string key, std::string val);
+    void setColumn(const ColumnPlan &plan, IModelTrackedComponent* comp, size_t column, const std::string &val);
 
-    /* Writes a tracked component to string
+    /* Writes a tracked component into the buffer
     */
-    std::string writeComponentCSV(IModelTrackedComponent* comp, int tid);
+    void writeComponentCSV(IModelTrackedComponent* comp, int tid, TextBuffer &out);
 
 
     void addChildOfChild(IModelTrackedTrajectory *root, IModelTrackedComponent* child, IModelTrackedComponentFactory* factory, int idx);
+
+    ExportJournal _journal;
+    std::ostream _journalStream;
+
+    //Collects the row of a frame, kept to reuse its buffer
+    TextBuffer _row;
+
+    //The header is written with the first frame, the component factory isn't known on open
+    bool _journalHeaderWritten;
 };
 
@@ -31,12 +31,21 @@ int DataExporterGeneric::getMaxLinecount()
     return max;
 }
 
+const ColumnPlan &DataExporterGeneric::getPlan(IModelTrackedComponent *comp)
+{
+    std::unique_ptr<ColumnPlan> &plan = _plans[comp->metaObject()];
+    if (!plan)
+        plan.reset(new ColumnPlan(comp));
+    return *plan;
+}
+
 void DataExporterGeneric::cleanup()
 {
     int s = _root->size();
 
     //Erase all tracking data from the tracking structure!
     _root->clear();
+    _strides.clear();
 
     //Remove temporary file
     QFile file(_tmpFile.c_str());
@@ -50,6 +59,20 @@ void DataExporterGeneric::cleanup()
     return;
 }
 
+void DataExporterGeneric::setFrameStride(int idx, int stride)
+{
+    if (idx < 0)
+        return;
+    if (idx >= int(_strides.size()))
+        _strides.resize(idx + 1, 1);
+    _strides[idx] = stride;
+}
+
+int DataExporterGeneric::getFrameStride(int idx)
+{
+    return idx >= 0 && idx < int(_strides.size()) ? _strides[idx] : 1;
+}
+
 void DataExporterGeneric::finalize()
 {
     close();
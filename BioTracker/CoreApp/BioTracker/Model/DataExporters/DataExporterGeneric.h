@@ -3,8 +3,12 @@
 #include "Interfaces/IModel/IModelTrackedTrajectory.h"
 #include "Interfaces/IModel/IModelTrackedComponent.h"
 #include "Interfaces/IModel/IModelTrackedComponentFactory.h"
+#include "ColumnPlan.h"
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <vector>
 
 class DataExporterGeneric : public IModelDataExporter
 {
@@ -20,12 +24,28 @@ public:
 
     void finalize() override;
 
+    /**
+     *  Remembers the frame stride the player used to get to frame idx. Forgotten with the tracking data in cleanup.
+     *  Like write, only called in the main thread.
+     */
+    void setFrameStride(int idx, int stride);
+
 protected:
 
     int getMaxLinecount();
 
+    /**
+    *  The stride set for frame idx, 1 if none was
+    */
+    int getFrameStride(int idx);
+
     void cleanup();
 
+    /**
+    *  Gets the column plan of the component's type, building it on first use
+    */
+    const ColumnPlan &getPlan(IModelTrackedComponent *comp);
+
     QObject *_parent = nullptr;
 
     std::ofstream _ofs;
@@ -37,5 +57,9 @@ protected:
     std::string _finalFile;
 private:
 
+    std::map<const QMetaObject*, std::unique_ptr<ColumnPlan>> _plans;
+
+    std::vector<int> _strides;
+
 };
 
@@ -13,33 +13,62 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <boost/property_tree/ptree.hpp>
-#include <type_traits>
+#include <deque>
+#include <cstdlib>
+#include <functional>
+#include "JsonReader.h"
+#include "TextBuffer.h"
 
 
 
 namespace DataExporterJsonUtil {
-    template<typename T>
-    static T preprocess_value(T &&paramValue) {
-        return std::forward<T>(paramValue);
-    }
-
-    /* Writes a tracked component to a property tree for json serialization
+    /* Appends a quoted and escaped JSON string
     */
-    void writeComponentJson(IModelTrackedComponent* comp, boost::property_tree::ptree *pt) {
-
-        for (int i = 0; i<comp->metaObject()->propertyCount(); ++i)
-        {
-            if (comp->metaObject()->property(i).isStored(comp))
-            {
-                if (!comp->metaObject()->property(i).isStored()) {
-                    continue;
+    void appendQuoted(const QByteArray &utf8, TextBuffer &out) {
+        static const char hex[] = "0123456789abcdef";
+        out.append('"');
+        for (char c : utf8) {
+            switch (c) {
+            case '"':  out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[] = { '\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF] };
+                    out.append(escaped, sizeof(escaped));
+                }
+                else {
+                    out.append(c);
                 }
-                std::string str = comp->metaObject()->property(i).name();
-                QVariant v = comp->metaObject()->property(i).read(comp);
-                pt->put(str, v.toString().toStdString());
             }
         }
+        out.append('"');
+    }
+
+    /* Starts a member of the currently open object, the key is a plain identifier
+    */
+    void appendKey(const std::string &key, const std::string &indent, bool &first, TextBuffer &out) {
+        if (!first)
+            out.append(',');
+        first = false;
+        out.append(indent);
+        out.append('"');
+        out.append(key);
+        out.append("\": ", 3);
+    }
+
+    /* Writes the stored properties of a component as members of the currently open object
+    */
+    void writeComponentJson(IModelTrackedComponent* comp, const ColumnPlan &plan, const std::string &indent, bool &first, TextBuffer &out) {
+        for (size_t i = 0; i < plan.size(); i++) {
+            appendKey(plan.names()[i], indent, first, out);
+            if (plan.isText(i))
+                appendQuoted(plan.text(comp, i).toUtf8(), out);
+            else
+                plan.writeNumber(comp, i, out);
+        }
     }
 
     /* Helper function to extract a suffix number from a string
@@ -57,56 +86,97 @@ namespace DataExporterJsonUtil {
         return id;
     }
 
-    /* Helper function to set elements
+    /* Helper function to set elements from the value just read, through the typed setters of the plan.
+    *  Older files store numbers and booleans as strings, so all values are parsed from their text.
     */
-    void setElemProperty(boost::property_tree::ptree *tree, std::string key, IModelTrackedComponent* comp) {
-        QString val = QString(tree->data().c_str());
-        std::string check = val.toStdString();
-        QVariant v(val);
-        comp->setProperty(key.c_str(), v);
+    void setElemProperty(JsonReader &reader, JsonReader::Token value, const std::string &key, const ColumnPlan &plan, IModelTrackedComponent* comp) {
+        int column = plan.indexOf(key);
+        if (column < 0)
+            return;
+
+        std::string val;
+        switch (value) {
+        case JsonReader::TOKEN_STRING:
+        case JsonReader::TOKEN_NUMBER: val = reader.text(); break;
+        case JsonReader::TOKEN_TRUE:   val = "true"; break;
+        case JsonReader::TOKEN_FALSE:  val = "false"; break;
+        default:                       return;
+        }
+
+        switch (plan.type(column)) {
+        case ColumnPlan::TYPE_BOOL:
+            plan.setInteger(comp, column, val == "true" || val == "1");
+            break;
+        case ColumnPlan::TYPE_INT:
+            plan.setInteger(comp, column, std::strtoll(val.c_str(), nullptr, 10));
+            break;
+        case ColumnPlan::TYPE_FLOAT:
+            plan.setReal(comp, column, std::strtof(val.c_str(), nullptr));
+            break;
+        default:
+            plan.setText(comp, column, QString::fromStdString(val));
+            break;
+        }
     }
 
-    /* Recursion to write the tracked component tree into a boost property tree
+    typedef std::function<const ColumnPlan &(IModelTrackedComponent*)> PlanLookup;
+
+    /* Recursion reading the members of an object into the tracked component tree.
+    *  The object has been opened already, the prefixes from level on tell the children's kind (nodes or leafs).
     */
-    void populateLevel(
+    bool populateLevel(
+        JsonReader &reader,
         IModelTrackedComponent* comp,
-        boost::property_tree::basic_ptree<std::string, std::string, std::less<std::string>> *pt,
         IModelTrackedComponentFactory* factory,
-        std::deque<std::string> prefixes)
+        const PlanLookup &planOf,
+        const std::deque<std::string> &prefixes,
+        size_t level)
     {
         //Check the prefixes (are the children leafs or nodes?)
-        std::string prefix = "";
-        if (prefixes.size() > 0) {
-            prefix = prefixes.front();
-            prefixes.pop_front();
-        }
-
-        //Iterate children
-        for (auto it : *pt) {
-            //Get ID if any
-            int id = getId(it.first, prefix);
+        std::string prefix = level < prefixes.size() ? prefixes[level] : "";
+        bool childrenAreNodes = level + 1 < prefixes.size();
+        const ColumnPlan &plan = planOf(comp);
+
+        while (true) {
+            JsonReader::Token t = reader.next();
+            if (t == JsonReader::TOKEN_END_OBJECT)
+                return true;
+            if (t != JsonReader::TOKEN_KEY)
+                return false;
+            std::string key = reader.text();
+
+            t = reader.next();
+            if (t == JsonReader::TOKEN_BEGIN_OBJECT && !prefix.empty()) {
+                //Get ID if any
+                int id = getId(key, prefix);
+                IModelTrackedComponent *child;
 
-            //Check if there is a subtree
-            if (it.second.size() > 0) {
                 //This is a valid subtree
-                if (prefixes.size() > 0) {
-                    IModelTrackedTrajectory *child = static_cast<IModelTrackedTrajectory*>(factory->getNewTrackedTrajectory("0"));
-                    populateLevel(child, &(it.second), factory, prefixes);
-                    static_cast<IModelTrackedTrajectory*>(comp)->add(child, id);
-                }
+                if (childrenAreNodes)
+                    child = static_cast<IModelTrackedComponent*>(factory->getNewTrackedTrajectory("0"));
                 //This is a leaf node with only properties beneath
-                else {
-                    IModelTrackedComponent *node = static_cast<IModelTrackedComponent*>(factory->getNewTrackedElement("0"));
-                    populateLevel(node, &(it.second), factory, prefixes);
-                    static_cast<IModelTrackedTrajectory*>(comp)->add(node, id);
+                else
+                    child = static_cast<IModelTrackedComponent*>(factory->getNewTrackedElement("0"));
+
+                if (!populateLevel(reader, child, factory, planOf, prefixes, level + 1)) {
+                    delete child;
+                    return false;
                 }
+                static_cast<IModelTrackedTrajectory*>(comp)->add(child, id);
+            }
+            else if (t == JsonReader::TOKEN_BEGIN_OBJECT || t == JsonReader::TOKEN_BEGIN_ARRAY) {
+                //Nothing we could store, e.g. below a leaf
+                if (!reader.skipValue(t))
+                    return false;
             }
             //Found a property and assigning it
+            else if (t == JsonReader::TOKEN_ERROR || t == JsonReader::TOKEN_END || t == JsonReader::TOKEN_END_OBJECT) {
+                return false;
+            }
             else {
-                setElemProperty(&(it.second), it.first, comp);
+                setElemProperty(reader, t, key, plan, comp);
             }
         }
-
     }
 }
 
@@ -135,7 +205,7 @@ void DataExporterJson::write(int idx) {
         return;
     }
 
-    _ofs << std::endl;
+    //The JSON nests the elements in their trajectories, so the file is written as a whole by writeAll
 }
 
 void DataExporterJson::finalizeAndReInit() {
@@ -146,24 +216,26 @@ void DataExporterJson::finalizeAndReInit() {
 }
 
 void DataExporterJson::loadFile(std::string file) {
-    boost::property_tree::ptree ptRoot;
-    boost::property_tree::read_json(file, ptRoot);
-
     ControllerDataExporter *ctr = dynamic_cast<ControllerDataExporter*>(_parent);
     IModelTrackedComponentFactory* factory = ctr ? ctr->getComponentFactory() : nullptr;
     if (!factory) {
         return;
     }
 
+    std::ifstream in(file, std::ifstream::in | std::ifstream::binary);
+    JsonReader reader(in);
+    if (reader.next() != JsonReader::TOKEN_BEGIN_OBJECT) {
+        qDebug() << "Not a JSON track file:" << file.c_str();
+        return;
+    }
+
     //ID's of entities are managed via prefix+enumeration
     std::deque<std::string> prefixes = { "Trajectory_", "Element_" };
 
-    //Recursively reads the json
-    DataExporterJsonUtil::populateLevel(
-        _root,
-        &ptRoot,
-        factory,
-        prefixes);
+    //Recursively reads the json, element by element
+    DataExporterJsonUtil::PlanLookup planOf = [this](IModelTrackedComponent *comp) -> const ColumnPlan & { return getPlan(comp); };
+    if (!DataExporterJsonUtil::populateLevel(reader, _root, factory, planOf, prefixes, 0))
+        qDebug() << "Could not read" << file.c_str() << ":" << reader.error().c_str();
 };
 
 void DataExporterJson::writeAll(std::string f) {
@@ -185,34 +257,51 @@ void DataExporterJson::writeAll(std::string f) {
     if (target.size() <= 1) {
         target = _finalFile;
     }
-    if (target.substr(target.size() - 4) != ".json")
+    if (target.size() < 5 || target.substr(target.size() - 5) != ".json")
         target += ".json";
 
-    boost::property_tree::ptree ptRoot; 
-    DataExporterJsonUtil::writeComponentJson(_root, &ptRoot);
-    
+    //Stream the tree into the file, trajectory by trajectory
+    std::ofstream o(target, std::ofstream::out | std::ofstream::binary);
+    TextBuffer out(o);
+    const std::string rootIndent = "\n    ";
+    const std::string trajectoryIndent = "\n        ";
+
+    out.append('{');
+    bool firstInRoot = true;
+    DataExporterJsonUtil::writeComponentJson(_root, getPlan(_root), rootIndent, firstInRoot, out);
+
     //go through all trajectories
 	for (int i = 0; i < _root->size(); i++) {
-		IModelTrackedTrajectory *t = static_cast<IModelTrackedTrajectory *>(_root->getChild(i));
-        boost::property_tree::ptree ptt;
-        DataExporterJsonUtil::writeComponentJson(t, &ptt);
+		IModelTrackedTrajectory *t = dynamic_cast<IModelTrackedTrajectory *>(_root->getChild(i));
+        if (!t)
+            continue;
+
+        DataExporterJsonUtil::appendKey("Trajectory_" + std::to_string(i), rootIndent, firstInRoot, out);
+        out.append('{');
+        bool firstInTrajectory = true;
+        DataExporterJsonUtil::writeComponentJson(t, getPlan(t), trajectoryIndent, firstInTrajectory, out);
 
         ////i is the track number
         for (int idx = 0; idx < t->size(); idx++) {
             IModelTrackedComponent *e = static_cast<IModelTrackedComponent*>(t->getChild(idx));
 
-            //If the node exists (i.e. not NULL) then it to the property tree
+            //If the node exists (i.e. not NULL) then write it on a line of its own
             if (e) {
-                boost::property_tree::ptree pte;
-                DataExporterJsonUtil::writeComponentJson(e, &pte);
-                ptt.put_child("Element_"+std::to_string(idx), pte);
+                DataExporterJsonUtil::appendKey("Element_" + std::to_string(idx), trajectoryIndent, firstInTrajectory, out);
+                out.append('{');
+                bool firstInElement = true;
+                DataExporterJsonUtil::writeComponentJson(e, getPlan(e), " ", firstInElement, out);
+                out.append(" }", 2);
+                out.endRow();
             }
         }
-        //Insert the trajectory into the tree
-        ptRoot.put_child("Trajectory_" + std::to_string(i), ptt);
+        out.append(rootIndent);
+        out.append('}');
 	}
 
-    write_json(target, ptRoot);
+    out.append("\n}\n", 3);
+    out.flush();
+    o.close();
 }
 
 void DataExporterJson::close() {
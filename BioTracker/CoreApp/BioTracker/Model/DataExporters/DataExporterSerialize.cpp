@@ -8,9 +8,122 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <unordered_map>
+#include <cstring>
+#include "TrackFile.h"
+#include "TrackFileSource.h"
 
 #include "Controller/ControllerDataExporter.h"
 
+namespace DataExporterSerializeUtil {
+    /* Collects the texts of a file, storing every distinct text once
+    */
+    class StringTable {
+    public:
+        uint32_t index(const QString &s) {
+            std::string utf8 = s.toStdString();
+            auto it = _index.find(utf8);
+            if (it != _index.end())
+                return it->second;
+            uint32_t i = uint32_t(_strings.size());
+            _index.emplace(utf8, i);
+            _strings.push_back(utf8);
+            return i;
+        }
+
+        void write(std::ostream &out) {
+            uint64_t count = _strings.size();
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            uint64_t offset = 0;
+            for (const std::string &s : _strings) {
+                out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+                offset += s.size();
+            }
+            out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+            for (const std::string &s : _strings)
+                out.write(s.data(), s.size());
+        }
+
+    private:
+        std::unordered_map<std::string, uint32_t> _index;
+        std::vector<std::string> _strings;
+    };
+
+    /* The columns of a plan as they are described in the file, an empty schema without a plan
+    */
+    std::vector<TrackFile::ColumnEntry> getSchema(const ColumnPlan *plan, StringTable &strings) {
+        std::vector<TrackFile::ColumnEntry> schema;
+        for (size_t i = 0; plan && i < plan->size(); i++) {
+            TrackFile::ColumnEntry c;
+            c.type = plan->type(i);
+            c.name = strings.index(QString::fromStdString(plan->names()[i]));
+            schema.push_back(c);
+        }
+        return schema;
+    }
+
+    void writeSchema(const std::vector<TrackFile::ColumnEntry> &schema, std::ostream &out) {
+        uint32_t count = uint32_t(schema.size());
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        if (!schema.empty())
+            out.write(reinterpret_cast<const char*>(schema.data()), schema.size() * sizeof(TrackFile::ColumnEntry));
+    }
+
+    /* Writes a block of rows, getRow(r) returning the component of row r or nullptr.
+    *  The rows are visited once, as the components handed out by a trajectory may be reused by later calls.
+    */
+    template<typename GetRow>
+    void writeBlock(const ColumnPlan *plan, const std::vector<TrackFile::ColumnEntry> &schema, uint32_t rows, GetRow getRow, StringTable &strings, std::ostream &out) {
+        std::vector<char> presence(rows, 0);
+        std::vector<std::vector<char>> columns(schema.size());
+        for (size_t c = 0; c < schema.size(); c++)
+            columns[c].resize(TrackFile::typeWidth(schema[c].type) * rows);
+
+        for (uint32_t r = 0; r < rows; r++) {
+            IModelTrackedComponent *comp = getRow(r);
+            //Components of another type don't fit the schema
+            if (!comp || !plan || comp->metaObject() != plan->metaObject())
+                continue;
+            presence[r] = 1;
+
+            for (size_t c = 0; c < schema.size(); c++) {
+                char *p = columns[c].data() + TrackFile::typeWidth(schema[c].type) * r;
+                switch (schema[c].type) {
+                case ColumnPlan::TYPE_BOOL: {
+                    *p = char(plan->integer(comp, c) != 0);
+                    break;
+                }
+                case ColumnPlan::TYPE_INT: {
+                    qint64 v = plan->integer(comp, c);
+                    std::memcpy(p, &v, sizeof(v));
+                    break;
+                }
+                case ColumnPlan::TYPE_FLOAT: {
+                    float v = plan->real(comp, c);
+                    std::memcpy(p, &v, sizeof(v));
+                    break;
+                }
+                default: {
+                    uint32_t v = strings.index(plan->text(comp, c));
+                    std::memcpy(p, &v, sizeof(v));
+                    break;
+                }
+                }
+            }
+        }
+
+        //Every column starts 8 byte aligned
+        static const char padding[8] = {};
+        auto writePadded = [&out](const std::vector<char> &data) {
+            out.write(data.data(), data.size());
+            out.write(padding, (8 - data.size() % 8) % 8);
+        };
+        writePadded(presence);
+        for (const std::vector<char> &column : columns)
+            writePadded(column);
+    }
+}
+
 DataExporterSerialize::DataExporterSerialize(QObject *parent) :
     DataExporterGeneric(parent)
 {
@@ -35,7 +148,7 @@ void DataExporterSerialize::write(int idx) {
         return;
     }
 
-    _ofs << std::endl;
+    //The track file is written as a whole by writeAll, as its columns span all frames
 }
 
 void DataExporterSerialize::finalizeAndReInit() {
@@ -48,6 +161,51 @@ void DataExporterSerialize::finalizeAndReInit() {
 extern IModelTrackedComponentFactory* factory;
 
 void DataExporterSerialize::loadFile(std::string file){
+    if (!TrackFile::isTrackFile(file)) {
+        loadLegacyFile(file);
+        return;
+    }
+
+	ControllerDataExporter *ctr = dynamic_cast<ControllerDataExporter*>(_parent);
+    IModelTrackedComponentFactory* factory = ctr ? ctr->getComponentFactory() : nullptr;
+	if (!factory) {
+		return;
+	}
+
+    //The mapping is shared by the trajectories, which read their elements from it when they need them
+    std::shared_ptr<TrackFileSource::Shared> shared = std::make_shared<TrackFileSource::Shared>();
+    TrackFile &in = shared->file;
+    if (!in.open(file)) {
+        qDebug() << "Could not read" << file.c_str() << ":" << in.error().c_str();
+        return;
+    }
+
+    in.readRoot(_root, getPlan(_root));
+
+    //i is the track number
+    for (int i = 0; i < in.trackCount(); i++) {
+        IModelTrackedTrajectory *child = static_cast<IModelTrackedTrajectory*>(factory->getNewTrackedTrajectory("0"));
+        in.readTrajectory(i, child, getPlan(child));
+
+        if (child->setElementSource(std::make_shared<TrackFileSource>(shared, i))) {
+            _root->add(child, in.slot(i));
+            continue;
+        }
+
+        //The trajectory can't read on demand, idx is the frame number, absent frames are skipped
+        const int last = in.firstFrame(i) + in.frameCount(i);
+        for (int idx = in.firstFrame(i); idx < last; idx++) {
+            if (!in.hasFrame(i, idx))
+                continue;
+            IModelTrackedComponent *e = static_cast<IModelTrackedComponent*>(factory->getNewTrackedElement("0"));
+            in.readElement(i, idx, e, getPlan(e));
+            child->add(e, idx);
+        }
+        _root->add(child, in.slot(i));
+    }
+}
+
+void DataExporterSerialize::loadLegacyFile(std::string file){
 
 	ControllerDataExporter *ctr = dynamic_cast<ControllerDataExporter*>(_parent);
     factory = ctr ? ctr->getComponentFactory() : nullptr;
@@ -107,49 +265,106 @@ void DataExporterSerialize::writeAll(std::string f) {
     if (target.size() <= 1) {
         target = _finalFile;
     }
-    if (target.substr(target.size() - 4) != ".dat")
+    if (target.size() < 4 || target.substr(target.size() - 4) != ".dat")
         target += ".dat";
 
-    //Create final file
-	QFile file(target.c_str());
-	file.open(QIODevice::WriteOnly);
-	QDataStream out(&file);
-
-	//serialize tree nodes (!= leafs)
-	out << *_root;
-	out << _root->size();
-	for (int i = 0; i < _root->size(); i++) {
-		IModelTrackedTrajectory *t = dynamic_cast<IModelTrackedTrajectory *>(_root->getChild(i));
-		out << *t;
-	}
+    //Create final file. It is written next to the target and moved over it at the end,
+    //as the target may be the file the trajectories still read their elements from.
+    using namespace DataExporterSerializeUtil;
+    const std::string part = target + ".part";
+    std::ofstream out(part, std::ofstream::out | std::ofstream::binary);
+    StringTable strings;
+
+    //The schemas are taken from the first trajectory and element
+    std::vector<IModelTrackedTrajectory*> tracks;
+    std::vector<int> slots;
+    const ColumnPlan *trajectoryPlan = nullptr;
+    const ColumnPlan *elementPlan = nullptr;
+    for (int i = 0; i < _root->size(); i++) {
+        IModelTrackedTrajectory *t = dynamic_cast<IModelTrackedTrajectory *>(_root->getChild(i));
+        if (!t)
+            continue;
+        tracks.push_back(t);
+        slots.push_back(i);
+        if (!trajectoryPlan)
+            trajectoryPlan = &getPlan(t);
+        for (int idx = 0; !elementPlan && idx < t->size(); idx++) {
+            IModelTrackedComponent *e = t->getChild(idx);
+            if (e)
+                elementPlan = &getPlan(e);
+        }
+    }
+
+    std::vector<TrackFile::ColumnEntry> schemas[TrackFile::SCHEMA_COUNT] = {
+        getSchema(&getPlan(_root), strings),
+        getSchema(trajectoryPlan, strings),
+        getSchema(elementPlan, strings)
+    };
 
+    TrackFile::Header header = {};
+    std::memcpy(header.magic, TrackFile::Magic, sizeof(header.magic));
+    header.version = TrackFile::Version;
+    header.byteOrder = TrackFile::ByteOrder;
+    header.trackCount = uint32_t(tracks.size());
+
+    //Header and track table are rewritten once the offsets are known
+    std::vector<TrackFile::TrackEntry> table(tracks.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.schemaOffset = uint64_t(out.tellp());
+    for (const std::vector<TrackFile::ColumnEntry> &schema : schemas)
+        writeSchema(schema, out);
+    header.trackTableOffset = uint64_t(out.tellp());
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TrackFile::TrackEntry));
+
+    static const char padding[8] = {};
+    out.write(padding, (8 - uint64_t(out.tellp()) % 8) % 8);
+    header.rootBlockOffset = uint64_t(out.tellp());
+    const ColumnPlan *rootPlan = &getPlan(_root);
+    writeBlock(rootPlan, schemas[TrackFile::SCHEMA_ROOT], 1,
+        [this](uint32_t) { return static_cast<IModelTrackedComponent*>(_root); }, strings, out);
 
 	//i is the track number
-	for (int i = 0; i < _root->size(); i++) {
-		IModelTrackedTrajectory *t = dynamic_cast<IModelTrackedTrajectory *>(_root->getChild(i));
-
-        int cnt = 0;
-        for (int idx = 0; idx < t->size(); idx++) {
-            if (t) {
-                IModelTrackedComponent *e = dynamic_cast<IModelTrackedComponent*>(t->getChild(idx));
-                if (e) {
-                    cnt++;
-                }
-            }
-        }
-        out << cnt;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        IModelTrackedTrajectory *t = tracks[i];
 
-		//idx is the frame number
-		for (int idx = 0; idx < t->size(); idx++) {
-            if (t) {
-				IModelTrackedComponent *e = dynamic_cast<IModelTrackedComponent*>(t->getChild(idx));
-                if (e) {
-                    out << idx;
-                    out << *e;
-                }
-            }
-        }
+        //The element block spans the first to the last existing element
+        int first = 0;
+        while (first < t->size() && !t->getChild(first))
+            first++;
+        int last = t->size() - 1;
+        while (last >= first && !t->getChild(last))
+            last--;
+
+        TrackFile::TrackEntry &entry = table[i];
+        entry.slot = slots[i];
+        entry.firstFrame = first;
+        entry.frameCount = last - first + 1;
+        entry.trajectoryBlockOffset = uint64_t(out.tellp());
+        writeBlock(trajectoryPlan, schemas[TrackFile::SCHEMA_TRAJECTORY], 1,
+            [t](uint32_t) { return static_cast<IModelTrackedComponent*>(t); }, strings, out);
+
+        entry.elementBlockOffset = uint64_t(out.tellp());
+        writeBlock(elementPlan, schemas[TrackFile::SCHEMA_ELEMENT], uint32_t(entry.frameCount),
+            [t, first](uint32_t r) { return t->getChild(first + int(r)); }, strings, out);
+    }
+
+    header.stringTableOffset = uint64_t(out.tellp());
+    strings.write(out);
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.seekp(std::streamoff(header.trackTableOffset));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TrackFile::TrackEntry));
+    out.close();
+
+    if (!out) {
+        qDebug() << "Could not write" << target.c_str();
+        QFile::remove(part.c_str());
+        return;
     }
+    QFile::remove(target.c_str());
+    if (!QFile::rename(part.c_str(), target.c_str()))
+        qDebug() << "Could not replace" << target.c_str();
 }
 
 void DataExporterSerialize::close() {
@@ -2,6 +2,10 @@
 
 #include "DataExporterGeneric.h"
 
+/**
+*  Exports the tracking structure in the binary track format, see TrackFile.
+*  Files of the former QDataStream format can still be loaded.
+*/
 class DataExporterSerialize : public DataExporterGeneric
 {
 	Q_OBJECT
@@ -27,6 +31,11 @@ public:
 
 	void loadFile(std::string file) override;
 
+    /**
+    *  Loads a file of the QDataStream format used before the track format
+    */
+    void loadLegacyFile(std::string file);
+
     /**
     *  Effectively a writeAll, close and open.
     */
@@ -0,0 +1,169 @@
+#include "ExportJournal.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+ExportJournal::ExportJournal(size_t batchSize, size_t maxPending,
+    std::chrono::milliseconds flushInterval, std::chrono::milliseconds checkpointInterval) :
+    _batchSize(batchSize),
+    _maxPending(maxPending > batchSize ? maxPending : batchSize),
+    _flushInterval(flushInterval),
+    _checkpointInterval(checkpointInterval),
+    _file(nullptr),
+    _appended(0),
+    _synced(0),
+    _checkpointRequested(false),
+    _abort(false)
+{
+}
+
+ExportJournal::~ExportJournal()
+{
+    close();
+}
+
+bool ExportJournal::open(const std::string &path)
+{
+    close();
+
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    // the writer batches itself
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    _file = file;
+    _pending.clear();
+    _pending.reserve(_batchSize);
+    _appended = 0;
+    _synced = 0;
+    _checkpointRequested = false;
+    _abort = false;
+    _thread = std::thread(&ExportJournal::run, this);
+    return true;
+}
+
+void ExportJournal::close()
+{
+    if (!_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _abort = true;
+    }
+    _wake.notify_all();
+    _thread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::fclose(_file);
+        _file = nullptr;
+    }
+    _drained.notify_all();
+}
+
+bool ExportJournal::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _file != nullptr;
+}
+
+void ExportJournal::syncFile(FILE *file)
+{
+    std::fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+void ExportJournal::append(const char *data, size_t size)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_file || _abort)
+        return;
+    // backpressure, only when the disk can't keep up at all
+    _drained.wait(lock, [this] { return _pending.size() < _maxPending || !_file || _abort; });
+    // closed while waiting, the writer won't take anything any more
+    if (!_file || _abort)
+        return;
+
+    _pending.append(data, size);
+    _appended += size;
+    if (_pending.size() >= _batchSize) {
+        lock.unlock();
+        _wake.notify_one();
+    }
+}
+
+void ExportJournal::checkpoint()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_file)
+        return;
+    const unsigned long long target = _appended;
+    _checkpointRequested = true;
+    _wake.notify_one();
+    _drained.wait(lock, [this, target] { return _synced >= target || !_file || _abort; });
+}
+
+std::streamsize ExportJournal::xsputn(const char *s, std::streamsize n)
+{
+    append(s, size_t(n));
+    return n;
+}
+
+ExportJournal::int_type ExportJournal::overflow(int_type c)
+{
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        const char ch = traits_type::to_char_type(c);
+        append(&ch, 1);
+    }
+    return traits_type::not_eof(c);
+}
+
+void ExportJournal::run()
+{
+    std::string writing;
+    writing.reserve(_batchSize);
+    auto lastSync = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _wake.wait_for(lock, _flushInterval, [this] {
+            return _abort || _checkpointRequested || _pending.size() >= _batchSize;
+        });
+
+        const bool last = _abort;
+        const bool requested = _checkpointRequested;
+        _checkpointRequested = false;
+        writing.swap(_pending);
+        const unsigned long long written = _appended;
+        lock.unlock();
+        // room for the producers again
+        _drained.notify_all();
+
+        if (!writing.empty())
+            std::fwrite(writing.data(), 1, writing.size(), _file);
+        writing.clear();
+
+        const auto now = std::chrono::steady_clock::now();
+        const bool doSync = last || requested || now - lastSync >= _checkpointInterval;
+        if (doSync) {
+            syncFile(_file);
+            lastSync = now;
+        }
+
+        lock.lock();
+        if (doSync) {
+            _synced = written;
+            _drained.notify_all();
+        }
+        if (last && _pending.empty())
+            return;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+/**
+*  Append-only file written by a background thread.
+*
+*  Everything put into the journal (as a std::streambuf, e.g. through a std::ostream or a TextBuffer) is only
+*  copied into a pending buffer, the writer thread writes it in batches once batchSize bytes are pending or
+*  flushInterval passed. Every checkpointInterval the file is synced to disk, so after a crash at most that
+*  much data is lost, besides a possibly torn last line.
+*  The caller only blocks when more than maxPending bytes wait for the disk.
+*/
+class ExportJournal : public std::streambuf
+{
+public:
+    ExportJournal(size_t batchSize = 2 << 20, size_t maxPending = 64 << 20,
+        std::chrono::milliseconds flushInterval = std::chrono::milliseconds(1000),
+        std::chrono::milliseconds checkpointInterval = std::chrono::milliseconds(5000));
+    ~ExportJournal();
+
+    /**
+    *  Opens the file, truncating it, and starts the writer thread.
+    *  An open journal is closed first.
+    */
+    bool open(const std::string &path);
+
+    /**
+    *  Writes and syncs everything pending and stops the writer thread
+    */
+    void close();
+
+    /**
+    *  Thread safe, close() may run in another thread
+    */
+    bool isOpen() const;
+
+    void append(const char *data, size_t size);
+
+    /**
+    *  Blocks until everything appended so far is written and synced
+    */
+    void checkpoint();
+
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int_type overflow(int_type c) override;
+
+private:
+    void run();
+    void syncFile(FILE *file);
+
+    const size_t _batchSize;
+    const size_t _maxPending;
+    const std::chrono::milliseconds _flushInterval;
+    const std::chrono::milliseconds _checkpointInterval;
+
+    FILE *_file;
+    std::string _pending;
+
+    // bytes appended, and written and synced, since open
+    unsigned long long _appended;
+    unsigned long long _synced;
+    bool _checkpointRequested;
+    bool _abort;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+    std::thread _thread;
+};
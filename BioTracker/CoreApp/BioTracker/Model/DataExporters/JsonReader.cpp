@@ -0,0 +1,351 @@
+#include "JsonReader.h"
+#include <cstring>
+
+namespace {
+    const size_t blockSize = 1 << 16;
+
+    bool isDigit(int c) { return c >= '0' && c <= '9'; }
+}
+
+JsonReader::JsonReader(std::istream &in) :
+    _in(in),
+    _buffer(blockSize),
+    _pos(0),
+    _end(0),
+    _offset(0),
+    _state(STATE_VALUE),
+    _final(TOKEN_END),
+    _finished(false)
+{
+}
+
+int JsonReader::peekChar()
+{
+    if (_pos == _end) {
+        _offset += _end;
+        _pos = 0;
+        _end = 0;
+        if (_in) {
+            _in.read(_buffer.data(), _buffer.size());
+            _end = static_cast<size_t>(_in.gcount());
+        }
+        if (_end == 0)
+            return -1;
+    }
+    return static_cast<unsigned char>(_buffer[_pos]);
+}
+
+int JsonReader::getChar()
+{
+    int c = peekChar();
+    if (c >= 0)
+        _pos++;
+    return c;
+}
+
+void JsonReader::skipWhitespace()
+{
+    int c = peekChar();
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        _pos++;
+        c = peekChar();
+    }
+}
+
+bool JsonReader::fail(const char *what)
+{
+    _error = "offset " + std::to_string(_offset + _pos) + ": " + what;
+    _final = TOKEN_ERROR;
+    _finished = true;
+    return false;
+}
+
+void JsonReader::afterValue()
+{
+    _state = _inObject.empty() ? STATE_EOF : STATE_SEPARATOR_OR_END;
+}
+
+JsonReader::Token JsonReader::next()
+{
+    if (_finished)
+        return _final;
+
+    skipWhitespace();
+    int c = peekChar();
+
+    if (_state == STATE_EOF) {
+        if (c < 0) {
+            _finished = true;
+            return _final;
+        }
+        fail("unexpected data after the document");
+        return _final;
+    }
+
+    if (_state == STATE_SEPARATOR_OR_END) {
+        if (c == ',') {
+            _pos++;
+            _state = _inObject.back() ? STATE_KEY : STATE_VALUE;
+            skipWhitespace();
+            c = peekChar();
+        }
+        else if (c == '}' && _inObject.back()) {
+            _pos++;
+            _inObject.pop_back();
+            afterValue();
+            return TOKEN_END_OBJECT;
+        }
+        else if (c == ']' && !_inObject.back()) {
+            _pos++;
+            _inObject.pop_back();
+            afterValue();
+            return TOKEN_END_ARRAY;
+        }
+        else {
+            fail("expected ',' or the end of the object or array");
+            return _final;
+        }
+    }
+
+    if (_state == STATE_KEY_OR_END && c == '}') {
+        _pos++;
+        _inObject.pop_back();
+        afterValue();
+        return TOKEN_END_OBJECT;
+    }
+    if (_state == STATE_VALUE_OR_END && c == ']') {
+        _pos++;
+        _inObject.pop_back();
+        afterValue();
+        return TOKEN_END_ARRAY;
+    }
+
+    if (_state == STATE_KEY || _state == STATE_KEY_OR_END) {
+        if (c != '"') {
+            fail("expected a key");
+            return _final;
+        }
+        _pos++;
+        if (!readString())
+            return _final;
+        skipWhitespace();
+        if (getChar() != ':') {
+            fail("expected ':'");
+            return _final;
+        }
+        _state = STATE_VALUE;
+        return TOKEN_KEY;
+    }
+
+    // a value
+    switch (c) {
+    case '{':
+        _pos++;
+        _inObject.push_back(true);
+        _state = STATE_KEY_OR_END;
+        return TOKEN_BEGIN_OBJECT;
+    case '[':
+        _pos++;
+        _inObject.push_back(false);
+        _state = STATE_VALUE_OR_END;
+        return TOKEN_BEGIN_ARRAY;
+    case '"':
+        _pos++;
+        if (!readString())
+            return _final;
+        afterValue();
+        return TOKEN_STRING;
+    case 't':
+        if (!readLiteral("true"))
+            return _final;
+        afterValue();
+        return TOKEN_TRUE;
+    case 'f':
+        if (!readLiteral("false"))
+            return _final;
+        afterValue();
+        return TOKEN_FALSE;
+    case 'n':
+        if (!readLiteral("null"))
+            return _final;
+        afterValue();
+        return TOKEN_NULL;
+    default:
+        if (c == '-' || isDigit(c)) {
+            if (!readNumber())
+                return _final;
+            afterValue();
+            return TOKEN_NUMBER;
+        }
+        fail(c < 0 ? "unexpected end of the document" : "expected a value");
+        return _final;
+    }
+}
+
+bool JsonReader::skipValue(Token first)
+{
+    if (first != TOKEN_BEGIN_OBJECT && first != TOKEN_BEGIN_ARRAY)
+        return first != TOKEN_ERROR && first != TOKEN_END;
+
+    int depth = 1;
+    while (depth > 0) {
+        Token t = next();
+        if (t == TOKEN_BEGIN_OBJECT || t == TOKEN_BEGIN_ARRAY)
+            depth++;
+        else if (t == TOKEN_END_OBJECT || t == TOKEN_END_ARRAY)
+            depth--;
+        else if (t == TOKEN_ERROR || t == TOKEN_END)
+            return false;
+    }
+    return true;
+}
+
+bool JsonReader::readLiteral(const char *literal)
+{
+    for (const char *p = literal; *p; p++) {
+        if (getChar() != *p)
+            return fail("invalid literal");
+    }
+    return true;
+}
+
+bool JsonReader::readNumber()
+{
+    _text.clear();
+    int c = peekChar();
+    if (c == '-') {
+        _text.push_back(char(getChar()));
+        c = peekChar();
+    }
+    if (!isDigit(c))
+        return fail("invalid number");
+    while (isDigit(c)) {
+        _text.push_back(char(getChar()));
+        c = peekChar();
+    }
+    if (c == '.') {
+        _text.push_back(char(getChar()));
+        c = peekChar();
+        if (!isDigit(c))
+            return fail("invalid number");
+        while (isDigit(c)) {
+            _text.push_back(char(getChar()));
+            c = peekChar();
+        }
+    }
+    if (c == 'e' || c == 'E') {
+        _text.push_back(char(getChar()));
+        c = peekChar();
+        if (c == '+' || c == '-') {
+            _text.push_back(char(getChar()));
+            c = peekChar();
+        }
+        if (!isDigit(c))
+            return fail("invalid number");
+        while (isDigit(c)) {
+            _text.push_back(char(getChar()));
+            c = peekChar();
+        }
+    }
+    return true;
+}
+
+bool JsonReader::readHex4(unsigned long &value)
+{
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = getChar();
+        value <<= 4;
+        if (isDigit(c))
+            value |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            value |= c - 'A' + 10;
+        else
+            return fail("invalid unicode escape");
+    }
+    return true;
+}
+
+void JsonReader::appendUtf8(unsigned long codepoint)
+{
+    if (codepoint < 0x80) {
+        _text.push_back(char(codepoint));
+    }
+    else if (codepoint < 0x800) {
+        _text.push_back(char(0xC0 | (codepoint >> 6)));
+        _text.push_back(char(0x80 | (codepoint & 0x3F)));
+    }
+    else if (codepoint < 0x10000) {
+        _text.push_back(char(0xE0 | (codepoint >> 12)));
+        _text.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+        _text.push_back(char(0x80 | (codepoint & 0x3F)));
+    }
+    else {
+        _text.push_back(char(0xF0 | (codepoint >> 18)));
+        _text.push_back(char(0x80 | ((codepoint >> 12) & 0x3F)));
+        _text.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+        _text.push_back(char(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+bool JsonReader::readString()
+{
+    _text.clear();
+    while (true) {
+        // copy plain runs within the block at once
+        size_t begin = _pos;
+        while (_pos < _end && _buffer[_pos] != '"' && _buffer[_pos] != '\\' && static_cast<unsigned char>(_buffer[_pos]) >= 0x20)
+            _pos++;
+        _text.append(_buffer.data() + begin, _pos - begin);
+
+        int c = getChar();
+        if (c == '"')
+            return true;
+        if (c < 0)
+            return fail("unterminated string");
+        if (c < 0x20)
+            return fail("control character in string");
+        if (c != '\\') {
+            // the run ended at the block end
+            _text.push_back(char(c));
+            continue;
+        }
+
+        c = getChar();
+        switch (c) {
+        case '"':  _text.push_back('"'); break;
+        case '\\': _text.push_back('\\'); break;
+        case '/':  _text.push_back('/'); break;
+        case 'b':  _text.push_back('\b'); break;
+        case 'f':  _text.push_back('\f'); break;
+        case 'n':  _text.push_back('\n'); break;
+        case 'r':  _text.push_back('\r'); break;
+        case 't':  _text.push_back('\t'); break;
+        case 'u': {
+            unsigned long codepoint;
+            if (!readHex4(codepoint))
+                return false;
+            if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                // a surrogate pair
+                unsigned long low;
+                if (getChar() != '\\' || getChar() != 'u')
+                    return fail("unpaired surrogate");
+                if (!readHex4(low))
+                    return false;
+                if (low < 0xDC00 || low > 0xDFFF)
+                    return fail("unpaired surrogate");
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                return fail("unpaired surrogate");
+            }
+            appendUtf8(codepoint);
+            break;
+        }
+        default:
+            return fail("invalid escape");
+        }
+    }
+}
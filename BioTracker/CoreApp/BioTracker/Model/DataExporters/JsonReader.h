@@ -0,0 +1,92 @@
+#pragma once
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+*  Pull parser for JSON, reading the stream in blocks.
+*  Every call to next() returns one token, so a document can be processed without holding it in memory.
+*  Keys and texts are returned in UTF-8 with all escapes resolved, numbers as their literal text.
+*/
+class JsonReader
+{
+public:
+    enum Token {
+        TOKEN_BEGIN_OBJECT,
+        TOKEN_END_OBJECT,
+        TOKEN_BEGIN_ARRAY,
+        TOKEN_END_ARRAY,
+        TOKEN_KEY,
+        TOKEN_STRING,
+        TOKEN_NUMBER,
+        TOKEN_TRUE,
+        TOKEN_FALSE,
+        TOKEN_NULL,
+        TOKEN_END,
+        TOKEN_ERROR
+    };
+
+    JsonReader(std::istream &in);
+
+    /**
+    *  Reads the next token. After TOKEN_END or TOKEN_ERROR the same token is returned again.
+    */
+    Token next();
+
+    /**
+    *  Text of the last TOKEN_KEY, TOKEN_STRING or TOKEN_NUMBER
+    */
+    const std::string &text() const { return _text; }
+
+    /**
+    *  Skips the value whose first token was just read, e.g. a whole object after TOKEN_BEGIN_OBJECT
+    *  @return false on malformed input
+    */
+    bool skipValue(Token first);
+
+    /**
+    *  Describes where parsing failed
+    */
+    std::string error() const { return _error; }
+
+private:
+    int peekChar();
+    int getChar();
+    void skipWhitespace();
+    bool fail(const char *what);
+    bool readString();
+    bool readNumber();
+    bool readLiteral(const char *literal);
+    bool readHex4(unsigned long &value);
+    void appendUtf8(unsigned long codepoint);
+
+    /**
+    *  Called after a complete value, decides what may follow
+    */
+    void afterValue();
+
+    enum State {
+        STATE_VALUE,
+        STATE_VALUE_OR_END,
+        STATE_KEY,
+        STATE_KEY_OR_END,
+        STATE_SEPARATOR_OR_END,
+        STATE_EOF
+    };
+
+    std::istream &_in;
+    std::vector<char> _buffer;
+    size_t _pos;
+    size_t _end;
+    size_t _offset;
+
+    std::string _text;
+    std::string _error;
+
+    // for every open object or array whether it is an object
+    std::vector<bool> _inObject;
+    State _state;
+    // TOKEN_END or TOKEN_ERROR once reached
+    Token _final;
+    bool _finished;
+};
@@ -0,0 +1,100 @@
+#include "TextBuffer.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+    const uint64_t powersOf10[] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull
+    };
+    const int maxDecimals = 12;
+
+    /**
+    *  Writes the digits of v right aligned into the end of buf, at least minDigits of them.
+    *  @return the first digit
+    */
+    char *formatDigits(uint64_t v, char *end, int minDigits)
+    {
+        char *p = end;
+        while (v > 0 || minDigits > 0) {
+            *--p = char('0' + v % 10);
+            v /= 10;
+            minDigits--;
+        }
+        return p;
+    }
+}
+
+TextBuffer::TextBuffer(std::ostream &out, size_t capacity) :
+    _out(out),
+    _capacity(capacity)
+{
+    // some headroom, so the last row doesn't reallocate
+    _data.reserve(capacity + capacity / 4);
+}
+
+TextBuffer::~TextBuffer()
+{
+    flush();
+}
+
+void TextBuffer::flush()
+{
+    if (!_data.empty()) {
+        _out.write(_data.data(), _data.size());
+        // keeps the capacity
+        _data.clear();
+    }
+}
+
+void TextBuffer::appendInt(long long v)
+{
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    uint64_t magnitude = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    char *p = formatDigits(magnitude, end, 1);
+    if (v < 0)
+        *--p = '-';
+    _data.append(p, end - p);
+}
+
+void TextBuffer::appendNumber(double v, int significant)
+{
+    const double magnitude = std::fabs(v);
+    if (!std::isfinite(v) || magnitude >= 1e15) {
+        char buf[32];
+        int n = std::snprintf(buf, sizeof(buf), "%g", v);
+        _data.append(buf, n > 0 ? n : 0);
+        return;
+    }
+
+    int intDigits = 0;
+    for (uint64_t i = static_cast<uint64_t>(magnitude); i > 0; i /= 10)
+        intDigits++;
+    int decimals = significant - intDigits;
+    decimals = decimals < 0 ? 0 : (decimals > maxDecimals ? maxDecimals : decimals);
+
+    // round once on the scaled value, so 0.99999999 carries over into the integer part
+    const uint64_t scaled = static_cast<uint64_t>(magnitude * double(powersOf10[decimals]) + 0.5);
+    const uint64_t integer = scaled / powersOf10[decimals];
+    uint64_t fraction = scaled % powersOf10[decimals];
+
+    if (v < 0 && scaled != 0)
+        _data.push_back('-');
+
+    char buf[48];
+    char *end = buf + sizeof(buf);
+    char *p = formatDigits(integer, end, 1);
+    _data.append(p, end - p);
+
+    if (fraction != 0) {
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            decimals--;
+        }
+        p = formatDigits(fraction, end, decimals);
+        _data.push_back('.');
+        _data.append(p, end - p);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <ostream>
+#include <string>
+
+/**
+*  Collects formatted text in a large buffer and hands it to a stream in big blocks.
+*  Numbers are formatted by hand, without locale lookups or temporary strings.
+*/
+class TextBuffer
+{
+public:
+    /**
+    *  @param out Stream receiving the text
+    *  @param capacity Number of bytes collected before they are written out
+    */
+    TextBuffer(std::ostream &out, size_t capacity = 4 << 20);
+
+    /**
+    *  Writes out the remaining text
+    */
+    ~TextBuffer();
+
+    void append(char c) { _data.push_back(c); }
+    void append(const char *s, size_t n) { _data.append(s, n); }
+    void append(const std::string &s) { _data.append(s); }
+
+    void appendInt(long long v);
+
+    /**
+    *  Appends v in fixed point notation with about significant digits, dropping trailing zeros.
+    *  Non-finite and very large values fall back to printf's %g.
+    */
+    void appendNumber(double v, int significant = 7);
+
+    /**
+    *  Writes out the collected text once the capacity is reached.
+    *  Call this after every row, rows are never split.
+    */
+    void endRow() { if (_data.size() >= _capacity) flush(); }
+
+    void flush();
+
+private:
+    std::ostream &_out;
+    size_t _capacity;
+    std::string _data;
+};
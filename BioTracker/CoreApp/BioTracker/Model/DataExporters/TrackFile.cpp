@@ -0,0 +1,282 @@
+#include "TrackFile.h"
+#include <cstring>
+
+const char TrackFile::Magic[8] = { 'B', 'T', 'T', 'R', 'A', 'C', 'K', '\0' };
+
+namespace {
+    uint64_t align8(uint64_t v) { return (v + 7) & ~uint64_t(7); }
+
+    template<typename T>
+    T load(const uchar *p)
+    {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        return v;
+    }
+}
+
+size_t TrackFile::typeWidth(uint32_t type)
+{
+    switch (type) {
+    case ColumnPlan::TYPE_BOOL:  return 1;
+    case ColumnPlan::TYPE_INT:   return 8;
+    case ColumnPlan::TYPE_FLOAT: return 4;
+    case ColumnPlan::TYPE_TEXT:  return 4;
+    default:                     return 0;
+    }
+}
+
+uint64_t TrackFile::columnOffset(const std::vector<ColumnEntry> &schema, int column, uint32_t rows)
+{
+    uint64_t offset = align8(rows);
+    for (int i = 0; i < column; i++)
+        offset += align8(uint64_t(typeWidth(schema[i].type)) * rows);
+    return column < 0 ? 0 : offset;
+}
+
+uint64_t TrackFile::blockSize(const std::vector<ColumnEntry> &schema, uint32_t rows)
+{
+    return columnOffset(schema, int(schema.size()), rows);
+}
+
+bool TrackFile::isTrackFile(const std::string &path)
+{
+    QFile f(path.c_str());
+    char magic[sizeof(Magic)];
+    return f.open(QIODevice::ReadOnly) && f.read(magic, sizeof(magic)) == qint64(sizeof(magic)) &&
+        std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+TrackFile::TrackFile() :
+    _data(nullptr),
+    _size(0),
+    _stringCount(0),
+    _stringOffsets(nullptr),
+    _stringData(nullptr)
+{
+    for (int s = 0; s < SCHEMA_COUNT; s++)
+        _mappedPlan[s] = nullptr;
+}
+
+TrackFile::~TrackFile()
+{
+    close();
+}
+
+void TrackFile::close()
+{
+    if (_data)
+        _file.unmap(const_cast<uchar*>(_data));
+    _file.close();
+    _data = nullptr;
+    _size = 0;
+    _tracks.clear();
+    for (int s = 0; s < SCHEMA_COUNT; s++) {
+        _schemas[s].clear();
+        _mapping[s].clear();
+        _mappedPlan[s] = nullptr;
+    }
+}
+
+bool TrackFile::fail(const std::string &what)
+{
+    _error = what;
+    close();
+    return false;
+}
+
+bool TrackFile::open(const std::string &path)
+{
+    close();
+    _error.clear();
+
+    _file.setFileName(path.c_str());
+    if (!_file.open(QIODevice::ReadOnly))
+        return fail("cannot open " + path);
+    _size = uint64_t(_file.size());
+    if (_size < sizeof(Header))
+        return fail("not a track file");
+    _data = _file.map(0, _file.size());
+    if (!_data)
+        return fail("cannot map " + path);
+
+    _header = load<Header>(_data);
+    if (std::memcmp(_header.magic, Magic, sizeof(Magic)) != 0)
+        return fail("not a track file");
+    if (_header.byteOrder != ByteOrder)
+        return fail("track file of a different byte order");
+    if (_header.version != Version)
+        return fail("unsupported track file version " + std::to_string(_header.version));
+
+    if (!readStrings() || !readSchemas())
+        return false;
+
+    // the track table
+    const uint64_t tableSize = uint64_t(_header.trackCount) * sizeof(TrackEntry);
+    if (_header.trackTableOffset > _size || tableSize > _size - _header.trackTableOffset)
+        return fail("track table out of bounds");
+    if (!checkBlock(SCHEMA_ROOT, _header.rootBlockOffset, 1))
+        return false;
+
+    _tracks.resize(_header.trackCount);
+    for (uint32_t i = 0; i < _header.trackCount; i++) {
+        const TrackEntry t = load<TrackEntry>(_data + _header.trackTableOffset + i * sizeof(TrackEntry));
+        if (t.frameCount < 0 || t.firstFrame < 0 || t.slot < 0)
+            return fail("invalid track " + std::to_string(i));
+        if (!checkBlock(SCHEMA_TRAJECTORY, t.trajectoryBlockOffset, 1) ||
+            !checkBlock(SCHEMA_ELEMENT, t.elementBlockOffset, uint32_t(t.frameCount)))
+            return false;
+        _tracks[i] = t;
+    }
+    return true;
+}
+
+bool TrackFile::readStrings()
+{
+    const uint64_t offset = _header.stringTableOffset;
+    if (offset > _size || _size - offset < sizeof(uint64_t))
+        return fail("string table out of bounds");
+    _stringCount = load<uint64_t>(_data + offset);
+    const uint64_t slots = (_size - offset) / sizeof(uint64_t);
+    if (slots < 2 || _stringCount > slots - 2)
+        return fail("string table out of bounds");
+
+    _stringOffsets = _data + offset + sizeof(uint64_t);
+    _stringData = _stringOffsets + (_stringCount + 1) * sizeof(uint64_t);
+    const uint64_t dataSize = _size - uint64_t(_stringData - _data);
+
+    uint64_t previous = 0;
+    for (uint64_t i = 0; i <= _stringCount; i++) {
+        const uint64_t o = load<uint64_t>(_stringOffsets + i * sizeof(uint64_t));
+        if (o < previous || o > dataSize)
+            return fail("invalid string table");
+        previous = o;
+    }
+    return true;
+}
+
+bool TrackFile::readSchemas()
+{
+    uint64_t offset = _header.schemaOffset;
+    for (int s = 0; s < SCHEMA_COUNT; s++) {
+        if (offset > _size || _size - offset < sizeof(uint32_t))
+            return fail("schema out of bounds");
+        const uint32_t count = load<uint32_t>(_data + offset);
+        offset += sizeof(uint32_t);
+        if (count > (_size - offset) / sizeof(ColumnEntry))
+            return fail("schema out of bounds");
+
+        for (uint32_t c = 0; c < count; c++) {
+            const ColumnEntry e = load<ColumnEntry>(_data + offset);
+            offset += sizeof(ColumnEntry);
+            if (typeWidth(e.type) == 0 || e.name >= _stringCount)
+                return fail("invalid schema");
+            _schemas[s].push_back(e);
+        }
+    }
+    return true;
+}
+
+bool TrackFile::checkBlock(Schema schema, uint64_t offset, uint32_t rows)
+{
+    if (offset > _size || blockSize(_schemas[schema], rows) > _size - offset)
+        return fail("block out of bounds");
+    return true;
+}
+
+QString TrackFile::string(uint32_t index) const
+{
+    if (index >= _stringCount)
+        return QString();
+    const uint64_t begin = load<uint64_t>(_stringOffsets + index * sizeof(uint64_t));
+    const uint64_t end = load<uint64_t>(_stringOffsets + (index + 1) * sizeof(uint64_t));
+    return QString::fromUtf8(reinterpret_cast<const char*>(_stringData + begin), int(end - begin));
+}
+
+bool TrackFile::hasFrame(int track, int frame) const
+{
+    const TrackEntry &t = _tracks[track];
+    if (frame < t.firstFrame || frame - t.firstFrame >= t.frameCount)
+        return false;
+    return _data[t.elementBlockOffset + uint64_t(frame - t.firstFrame)] != 0;
+}
+
+void TrackFile::readRoot(IModelTrackedComponent *comp, const ColumnPlan &plan)
+{
+    readRow(SCHEMA_ROOT, _header.rootBlockOffset, 1, 0, comp, plan);
+}
+
+void TrackFile::readTrajectory(int track, IModelTrackedComponent *comp, const ColumnPlan &plan)
+{
+    readRow(SCHEMA_TRAJECTORY, _tracks[track].trajectoryBlockOffset, 1, 0, comp, plan);
+}
+
+bool TrackFile::readElement(int track, int frame, IModelTrackedComponent *comp, const ColumnPlan &plan)
+{
+    if (!hasFrame(track, frame))
+        return false;
+    const TrackEntry &t = _tracks[track];
+    readRow(SCHEMA_ELEMENT, t.elementBlockOffset, uint32_t(t.frameCount), uint32_t(frame - t.firstFrame), comp, plan);
+    return true;
+}
+
+void TrackFile::readRow(Schema schema, uint64_t offset, uint32_t rows, uint32_t row, IModelTrackedComponent *comp, const ColumnPlan &plan)
+{
+    const std::vector<ColumnEntry> &columns = _schemas[schema];
+
+    // match the columns by name once per plan
+    if (_mappedPlan[schema] != &plan) {
+        _mapping[schema].clear();
+        for (const ColumnEntry &c : columns)
+            _mapping[schema].push_back(plan.indexOf(string(c.name).toStdString()));
+        _mappedPlan[schema] = &plan;
+    }
+
+    uint64_t columnStart = offset + align8(rows);
+    for (size_t i = 0; i < columns.size(); i++) {
+        const uint32_t type = columns[i].type;
+        const uint64_t width = typeWidth(type);
+        const uchar *p = _data + columnStart + row * width;
+        columnStart += align8(width * rows);
+
+        const int target = _mapping[schema][i];
+        if (target < 0)
+            continue;
+
+        // convert where the file and the component disagree on the type
+        const ColumnPlan::Type targetType = plan.type(size_t(target));
+        switch (type) {
+        case ColumnPlan::TYPE_BOOL:
+        case ColumnPlan::TYPE_INT: {
+            const qint64 v = type == ColumnPlan::TYPE_BOOL ? qint64(*p) : load<qint64>(p);
+            if (targetType == ColumnPlan::TYPE_FLOAT)
+                plan.setReal(comp, size_t(target), float(v));
+            else if (targetType == ColumnPlan::TYPE_TEXT)
+                plan.setText(comp, size_t(target), QString::number(v));
+            else
+                plan.setInteger(comp, size_t(target), v);
+            break;
+        }
+        case ColumnPlan::TYPE_FLOAT: {
+            const float v = load<float>(p);
+            if (targetType == ColumnPlan::TYPE_FLOAT)
+                plan.setReal(comp, size_t(target), v);
+            else if (targetType == ColumnPlan::TYPE_TEXT)
+                plan.setText(comp, size_t(target), QString::number(v));
+            else
+                plan.setInteger(comp, size_t(target), qint64(v));
+            break;
+        }
+        default: {
+            const QString v = string(load<uint32_t>(p));
+            if (targetType == ColumnPlan::TYPE_FLOAT)
+                plan.setReal(comp, size_t(target), v.toFloat());
+            else if (targetType == ColumnPlan::TYPE_TEXT)
+                plan.setText(comp, size_t(target), v);
+            else
+                plan.setInteger(comp, size_t(target), v.toLongLong());
+            break;
+        }
+        }
+    }
+}
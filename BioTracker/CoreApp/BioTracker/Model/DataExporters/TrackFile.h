@@ -0,0 +1,141 @@
+#pragma once
+#include "ColumnPlan.h"
+#include <QFile>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+*  Random access to a file in the binary track format, which DataExporterSerialize writes.
+*
+*  Layout (version 1, little endian):
+*  Header | schemas | track table | blocks | string table
+*  A schema lists the stored properties of one component type (root, trajectory, element) as typed columns.
+*  A block holds the rows of one schema column after column, each column at fixed width and starting 8 byte
+*  aligned, preceded by a presence column of one byte per row. The root and every trajectory have a block of
+*  one row, the elements of a trajectory one row per frame from its first to its last element.
+*  Texts are stored as indices into the string table.
+*
+*  The file is mapped into memory and checked once on open, reading a frame then only touches the pages
+*  holding its values.
+*/
+class TrackFile
+{
+public:
+    enum Schema {
+        SCHEMA_ROOT,
+        SCHEMA_TRAJECTORY,
+        SCHEMA_ELEMENT,
+        SCHEMA_COUNT
+    };
+
+    static const char Magic[8];
+    static const uint32_t Version = 1;
+    static const uint32_t ByteOrder = 0x01020304;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t trackCount;
+        uint32_t reserved;
+        uint64_t schemaOffset;
+        uint64_t trackTableOffset;
+        uint64_t rootBlockOffset;
+        uint64_t stringTableOffset;
+    };
+
+    /* Every schema is a uint32_t column count followed by its columns */
+    struct ColumnEntry {
+        uint32_t type; //ColumnPlan::Type
+        uint32_t name; //string index
+    };
+
+    struct TrackEntry {
+        int32_t slot; //position of the trajectory in the root
+        int32_t firstFrame;
+        int32_t frameCount;
+        uint32_t reserved;
+        uint64_t trajectoryBlockOffset;
+        uint64_t elementBlockOffset;
+    };
+
+    /* The string table is a uint64_t count, count + 1 uint64_t offsets into the data following them and the
+    *  UTF-8 data */
+
+    static size_t typeWidth(uint32_t type);
+
+    /**
+    *  Offset of a column within a block, column -1 being the presence column
+    */
+    static uint64_t columnOffset(const std::vector<ColumnEntry> &schema, int column, uint32_t rows);
+
+    static uint64_t blockSize(const std::vector<ColumnEntry> &schema, uint32_t rows);
+
+    /**
+    *  Whether the file starts with the magic of the format
+    */
+    static bool isTrackFile(const std::string &path);
+
+    TrackFile();
+    ~TrackFile();
+
+    /**
+    *  Maps the file and checks its structure
+    *  @return false if the file is not a readable track file, see error()
+    */
+    bool open(const std::string &path);
+
+    void close();
+
+    const std::string &error() const { return _error; }
+
+    int trackCount() const { return int(_tracks.size()); }
+    int slot(int track) const { return _tracks[track].slot; }
+    int firstFrame(int track) const { return _tracks[track].firstFrame; }
+    int frameCount(int track) const { return _tracks[track].frameCount; }
+
+    bool hasFrame(int track, int frame) const;
+
+    /**
+    *  Set the stored properties the schema has in common with the plan, matched by name.
+    *  @param plan Plan of the type of comp
+    */
+    void readRoot(IModelTrackedComponent *comp, const ColumnPlan &plan);
+    void readTrajectory(int track, IModelTrackedComponent *comp, const ColumnPlan &plan);
+
+    /**
+    *  @return false if the track has no element at that frame
+    */
+    bool readElement(int track, int frame, IModelTrackedComponent *comp, const ColumnPlan &plan);
+
+private:
+    bool fail(const std::string &what);
+    bool readSchemas();
+    bool readStrings();
+    bool checkBlock(Schema schema, uint64_t offset, uint32_t rows);
+
+    QString string(uint32_t index) const;
+
+    /**
+    *  Copies row of the block at offset into comp
+    */
+    void readRow(Schema schema, uint64_t offset, uint32_t rows, uint32_t row, IModelTrackedComponent *comp, const ColumnPlan &plan);
+
+    QFile _file;
+    const uchar *_data;
+    uint64_t _size;
+    std::string _error;
+
+    Header _header;
+    std::vector<ColumnEntry> _schemas[SCHEMA_COUNT];
+    std::vector<TrackEntry> _tracks;
+
+    uint64_t _stringCount;
+    const uchar *_stringOffsets;
+    const uchar *_stringData;
+
+    // plan column of every schema column, for the plan last read into
+    std::vector<int> _mapping[SCHEMA_COUNT];
+    const ColumnPlan *_mappedPlan[SCHEMA_COUNT];
+};
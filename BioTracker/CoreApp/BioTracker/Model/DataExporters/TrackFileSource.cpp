@@ -0,0 +1,29 @@
+#include "TrackFileSource.h"
+#include <qdebug.h>
+
+TrackFileSource::TrackFileSource(std::shared_ptr<Shared> shared, int track) :
+    _shared(shared),
+    _track(track)
+{
+}
+
+int TrackFileSource::frameEnd()
+{
+    return _shared->file.firstFrame(_track) + _shared->file.frameCount(_track);
+}
+
+bool TrackFileSource::readElement(int frame, IModelTrackedComponent *comp)
+{
+    QMutexLocker locker(&_shared->mutex);
+    if (!_shared->file.hasFrame(_track, frame))
+        return false;
+
+    //All elements of a file are of one type, the file keeps its column mapping for this one plan
+    if (!_shared->elementPlan)
+        _shared->elementPlan.reset(new ColumnPlan(comp));
+    if (comp->metaObject() != _shared->elementPlan->metaObject()) {
+        qDebug() << "Element type" << comp->metaObject()->className() << "doesn't match the loaded elements";
+        return false;
+    }
+    return _shared->file.readElement(_track, frame, comp, *_shared->elementPlan);
+}
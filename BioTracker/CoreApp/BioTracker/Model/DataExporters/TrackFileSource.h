@@ -0,0 +1,32 @@
+#pragma once
+#include "Interfaces/IModel/IModelTrackedTrajectory.h"
+#include "ColumnPlan.h"
+#include "TrackFile.h"
+#include <QMutex>
+#include <memory>
+
+/**
+*  The elements of one track of a TrackFile, which a trajectory reads on demand.
+*  The sources of all tracks of a file share it, it stays mapped until the last of them is released.
+*/
+class TrackFileSource : public IModelTrackedElementSource
+{
+public:
+    /**
+    *  The mapped file and the plan of the element type, built on the first read
+    */
+    struct Shared {
+        TrackFile file;
+        std::unique_ptr<ColumnPlan> elementPlan;
+        QMutex mutex;
+    };
+
+    TrackFileSource(std::shared_ptr<Shared> shared, int track);
+
+    int frameEnd() override;
+    bool readElement(int frame, IModelTrackedComponent *comp) override;
+
+private:
+    std::shared_ptr<Shared> _shared;
+    int _track;
+};
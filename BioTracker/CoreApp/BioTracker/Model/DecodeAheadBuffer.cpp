@@ -0,0 +1,118 @@
+#include "DecodeAheadBuffer.h"
+
+namespace BioTracker {
+	namespace Core {
+
+		DecodeAheadBuffer::DecodeAheadBuffer(cv::VideoCapture &capture, size_t capacity, size_t stride)
+			: m_capture(capture)
+			, m_stride(stride > 0 ? stride : 1)
+			, m_head(0)
+			, m_count(0)
+			, m_abort(false)
+			, m_endOfStream(false) {
+			m_slots.reserve(capacity > 0 ? capacity : 1);
+			for (size_t i = 0; i < m_slots.capacity(); i++) {
+				m_slots.push_back(std::make_shared<cv::Mat>());
+			}
+		}
+
+		DecodeAheadBuffer::~DecodeAheadBuffer() {
+			stop();
+		}
+
+		void DecodeAheadBuffer::start() {
+			if (m_thread.joinable()) {
+				return;
+			}
+			m_thread = std::thread(&DecodeAheadBuffer::run, this);
+		}
+
+		void DecodeAheadBuffer::stop() {
+			if (!m_thread.joinable()) {
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_abort = true;
+			}
+			m_notFull.notify_all();
+			m_thread.join();
+
+			m_head = 0;
+			m_count = 0;
+			m_abort = false;
+			m_endOfStream = false;
+		}
+
+		void DecodeAheadBuffer::setStride(size_t stride) {
+			if (!m_thread.joinable()) {
+				m_stride = stride > 0 ? stride : 1;
+			}
+		}
+
+		std::shared_ptr<cv::Mat> DecodeAheadBuffer::pop() {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (!m_thread.joinable() && m_count == 0) {
+				return std::make_shared<cv::Mat>();
+			}
+			m_notEmpty.wait(lock, [this] { return m_count > 0 || m_endOfStream; });
+			if (m_count == 0) {
+				return std::make_shared<cv::Mat>();
+			}
+
+			// The slot keeps its reference, so the decoder can tell whether the frame is still in use when it wraps around
+			std::shared_ptr<cv::Mat> frame = m_slots[m_head];
+			m_head = (m_head + 1) % m_slots.size();
+			m_count--;
+			lock.unlock();
+			m_notFull.notify_one();
+			return frame;
+		}
+
+		void DecodeAheadBuffer::run() {
+			bool first = true;
+			while (true) {
+				std::shared_ptr<cv::Mat> frame;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_notFull.wait(lock, [this] { return m_abort || m_count < m_slots.size(); });
+					if (m_abort) {
+						return;
+					}
+					std::shared_ptr<cv::Mat> &slot = m_slots[(m_head + m_count) % m_slots.size()];
+					// Frame is still referenced by tracking or display: leave it alone and decode into a fresh one.
+					// Besides other shared_ptrs that includes cv::Mat headers sharing its pixels. OpenCV changes their
+					// count atomically in other threads, so it is read atomically as well.
+					if (slot.use_count() > 1 || (slot->u && CV_XADD(&slot->u->refcount, 0) > 1)) {
+						slot = std::make_shared<cv::Mat>();
+					}
+					frame = slot;
+				}
+
+				// Decode outside of the lock. The slot is not visible to pop() until m_count is increased.
+				// Skipped frames are only grabbed, which spares their decoding and color conversion.
+				bool ok = true;
+				for (size_t i = 1; i < m_stride && ok && !first; i++) {
+					ok = m_capture.grab();
+				}
+				ok = ok && m_capture.read(*frame);
+				first = false;
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (ok) {
+						m_count++;
+					}
+					else {
+						m_endOfStream = true;
+					}
+				}
+				m_notEmpty.notify_one();
+				if (!ok) {
+					return;
+				}
+			}
+		}
+
+	}
+}
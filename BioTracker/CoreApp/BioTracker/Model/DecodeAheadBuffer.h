@@ -0,0 +1,82 @@
+#ifndef DECODEAHEADBUFFER_H
+#define DECODEAHEADBUFFER_H
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+
+namespace BioTracker {
+namespace Core {
+
+/**
+ * The DecodeAheadBuffer runs a dedicated decoder thread which reads frames from a cv::VideoCapture into a bounded ring of
+ * preallocated frames ahead of the playhead. The player thread only pops decoded frames.
+ *
+ * While the decoder thread is running it owns the capture exclusively. Seeking therefore has to stop() the buffer,
+ * reposition the capture and start() it again; all frames decoded so far are dropped.
+ *
+ * A ring slot is reused in place as long as nobody outside the buffer holds its frame anymore, neither through the
+ * shared_ptr nor through a cv::Mat header sharing the pixels. Otherwise the slot is
+ * given a fresh cv::Mat, so frames handed out to tracking or display are never overwritten.
+ *
+ * The first frame after start() is the one the capture is positioned at. Between two delivered frames the stride - 1
+ * frames in between are only grabbed, never decoded.
+ */
+class DecodeAheadBuffer {
+  public:
+    /**
+     * @param capture the opened capture to decode from. Must outlive this object.
+     * @param capacity the number of frames to decode ahead of the playhead.
+     * @param stride the number of frames to advance per popped frame ("use only every n'th frame").
+     */
+    DecodeAheadBuffer(cv::VideoCapture &capture, size_t capacity, size_t stride);
+    ~DecodeAheadBuffer();
+
+    /**
+     * Starts the decoder thread at the capture's current position. Does nothing if it is already running.
+     */
+    void start();
+
+    /**
+     * Stops and joins the decoder thread and drops all buffered frames.
+     */
+    void stop();
+
+    /**
+     * Blocks until the next frame is decoded and returns it.
+     * Returns an empty frame if the end of the stream has been reached.
+     */
+    std::shared_ptr<cv::Mat> pop();
+
+    /**
+     * Changes the stride. Only allowed while the buffer is stopped.
+     */
+    void setStride(size_t stride);
+
+    size_t stride() const { return m_stride; }
+
+  private:
+    void run();
+
+    cv::VideoCapture &m_capture;
+    size_t m_stride;
+
+    std::vector<std::shared_ptr<cv::Mat>> m_slots;
+    size_t m_head;
+    size_t m_count;
+    bool m_abort;
+    bool m_endOfStream;
+
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::thread m_thread;
+};
+
+}
+}
+
+#endif // DECODEAHEADBUFFER_H
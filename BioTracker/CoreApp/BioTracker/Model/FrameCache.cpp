@@ -0,0 +1,52 @@
+#include "FrameCache.h"
+
+namespace BioTracker {
+	namespace Core {
+
+		FrameCache::FrameCache(size_t capacity) : m_capacity(capacity) {
+		}
+
+		std::shared_ptr<cv::Mat> FrameCache::get(size_t frameNumber) {
+			auto it = m_index.find(frameNumber);
+			if (it == m_index.end()) {
+				return nullptr;
+			}
+			m_frames.splice(m_frames.begin(), m_frames, it->second);
+			return it->second->second;
+		}
+
+		void FrameCache::put(size_t frameNumber, std::shared_ptr<cv::Mat> frame) {
+			if (m_capacity == 0 || !frame || frame->empty()) {
+				return;
+			}
+
+			auto it = m_index.find(frameNumber);
+			if (it != m_index.end()) {
+				it->second->second = frame;
+				m_frames.splice(m_frames.begin(), m_frames, it->second);
+				return;
+			}
+
+			if (m_frames.size() >= m_capacity) {
+				m_index.erase(m_frames.back().first);
+				m_frames.pop_back();
+			}
+			m_frames.emplace_front(frameNumber, frame);
+			m_index[frameNumber] = m_frames.begin();
+		}
+
+		bool FrameCache::contains(size_t frameNumber) const {
+			return m_index.find(frameNumber) != m_index.end();
+		}
+
+		void FrameCache::clear() {
+			m_index.clear();
+			m_frames.clear();
+		}
+
+		size_t FrameCache::capacity() const {
+			return m_capacity;
+		}
+
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+namespace BioTracker {
+namespace Core {
+
+/**
+ * The FrameCache class is a bounded least-recently-used cache of decoded frames, keyed by frame number.
+ * ImageStreams use it to serve back-steps and short scrubs without decoding again.
+ *
+ * The cache is not synchronized; callers sharing it between threads have to guard it themselves.
+ */
+class FrameCache {
+  public:
+    /**
+     * @param capacity the maximum number of frames kept. A capacity of 0 disables the cache.
+     */
+    explicit FrameCache(size_t capacity);
+
+    /**
+     * @return the cached frame and marks it as most recently used, or nullptr if the frame is not cached.
+     */
+    std::shared_ptr<cv::Mat> get(size_t frameNumber);
+
+    /**
+     * Inserts or replaces a frame. Evicts the least recently used frame if the cache is full.
+     */
+    void put(size_t frameNumber, std::shared_ptr<cv::Mat> frame);
+
+    bool contains(size_t frameNumber) const;
+
+    void clear();
+
+    size_t capacity() const;
+
+  private:
+    typedef std::list<std::pair<size_t, std::shared_ptr<cv::Mat>>> FrameList;
+
+    const size_t m_capacity;
+    // most recently used frame first
+    FrameList m_frames;
+    std::unordered_map<size_t, FrameList::iterator> m_index;
+};
+
+}
+}
+
+#endif // FRAMECACHE_H
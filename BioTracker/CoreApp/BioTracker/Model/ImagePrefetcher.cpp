@@ -0,0 +1,105 @@
+#include "ImagePrefetcher.h"
+
+#include <algorithm>
+
+namespace BioTracker {
+	namespace Core {
+
+		ImagePrefetcher::ImagePrefetcher(const std::vector<boost::filesystem::path> &files, size_t threads, size_t lookahead, size_t cacheSize)
+			: m_lookahead(lookahead)
+			, m_cache(cacheSize + lookahead + 1)
+			, m_waiting(false)
+			, m_waitingFor(0)
+			, m_abort(false) {
+			m_files.reserve(files.size());
+			for (const boost::filesystem::path &file : files) {
+				m_files.push_back(file.string());
+			}
+
+			if (threads == 0) {
+				threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			for (size_t i = 0; i < threads; i++) {
+				m_workers.push_back(std::thread(&ImagePrefetcher::run, this));
+			}
+		}
+
+		ImagePrefetcher::~ImagePrefetcher() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_abort = true;
+			}
+			m_work.notify_all();
+			m_done.notify_all();
+			for (std::thread &worker : m_workers) {
+				worker.join();
+			}
+		}
+
+		std::shared_ptr<cv::Mat> ImagePrefetcher::get(size_t frameNumber, size_t stride) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			// Drop what was queued for the previous position. Frames already being decoded stay pending.
+			for (size_t queued : m_queue) {
+				m_pending.erase(queued);
+			}
+			m_queue.clear();
+
+			std::shared_ptr<cv::Mat> frame = m_cache.get(frameNumber);
+			if (!frame && m_pending.count(frameNumber) == 0) {
+				m_queue.push_back(frameNumber);
+				m_pending.insert(frameNumber);
+			}
+			for (size_t i = 1; i <= m_lookahead; i++) {
+				const size_t next = frameNumber + i * stride;
+				if (next >= m_files.size()) {
+					break;
+				}
+				// get() instead of contains() marks the frame as recently used, so it survives until it is shown
+				if (!m_cache.get(next) && m_pending.count(next) == 0) {
+					m_queue.push_back(next);
+					m_pending.insert(next);
+				}
+			}
+			m_work.notify_all();
+
+			if (!frame) {
+				m_waiting = true;
+				m_waitingFor = frameNumber;
+				m_done.wait(lock, [this, frameNumber] { return m_abort || m_pending.count(frameNumber) == 0; });
+				frame = m_waitedFrame;
+				m_waitedFrame.reset();
+				m_waiting = false;
+			}
+			return frame ? frame : std::make_shared<cv::Mat>();
+		}
+
+		void ImagePrefetcher::run() {
+			while (true) {
+				size_t frameNumber;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_work.wait(lock, [this] { return m_abort || !m_queue.empty(); });
+					if (m_abort) {
+						return;
+					}
+					frameNumber = m_queue.front();
+					m_queue.pop_front();
+				}
+
+				std::shared_ptr<cv::Mat> frame = std::make_shared<cv::Mat>(cv::imread(m_files[frameNumber]));
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_cache.put(frameNumber, frame);
+					m_pending.erase(frameNumber);
+					if (m_waiting && m_waitingFor == frameNumber) {
+						m_waitedFrame = frame;
+					}
+				}
+				m_done.notify_all();
+			}
+		}
+
+	}
+}
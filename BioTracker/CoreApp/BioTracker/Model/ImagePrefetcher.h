@@ -0,0 +1,69 @@
+#ifndef IMAGEPREFETCHER_H
+#define IMAGEPREFETCHER_H
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <set>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+#include <boost/filesystem.hpp>
+
+#include "Model/FrameCache.h"
+
+namespace BioTracker {
+namespace Core {
+
+/**
+ * The ImagePrefetcher class decodes the files of an image sequence on a pool of worker threads.
+ * Whenever a frame is requested, the following frames are queued for decoding in parallel, so the player thread
+ * usually finds the next frame already decoded. Decoded frames are kept in a bounded LRU cache, which also serves
+ * back-steps.
+ */
+class ImagePrefetcher {
+  public:
+    /**
+     * @param files the image sequence.
+     * @param threads the number of decoder threads; 0 uses one per core.
+     * @param lookahead the number of frames decoded ahead of the requested one.
+     * @param cacheSize the number of already shown frames kept for back-stepping.
+     */
+    ImagePrefetcher(const std::vector<boost::filesystem::path> &files, size_t threads, size_t lookahead, size_t cacheSize);
+    ~ImagePrefetcher();
+
+    /**
+     * Returns the decoded frame, blocking until it is available, and queues the next lookahead frames
+     * (every stride'th one) for decoding. Returns an empty frame if the file could not be decoded.
+     * Only to be called from one thread.
+     */
+    std::shared_ptr<cv::Mat> get(size_t frameNumber, size_t stride);
+
+  private:
+    void run();
+
+    std::vector<std::string> m_files;
+    const size_t m_lookahead;
+
+    // frames decoded or being decoded; guarded by m_mutex
+    FrameCache m_cache;
+    std::deque<size_t> m_queue;
+    std::set<size_t> m_pending;
+    // the frame get() waits for is handed over directly, other workers' frames could evict it from the cache
+    bool m_waiting;
+    size_t m_waitingFor;
+    std::shared_ptr<cv::Mat> m_waitedFrame;
+    bool m_abort;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work;
+    std::condition_variable m_done;
+    std::vector<std::thread> m_workers;
+};
+
+}
+}
+
+#endif // IMAGEPREFETCHER_H
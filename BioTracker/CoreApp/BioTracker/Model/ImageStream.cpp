@@ -1,6 +1,7 @@
 #include "ImageStream.h"
 
 #include "util/stdext.h"
+#include <algorithm>  // std::max
 #include <cassert>    // assert
 #include <stdexcept>  // std::invalid_argument
 #include <chrono>
@@ -16,6 +17,10 @@
 #include "util/singleton.h"
 #include "settings/Settings.h"
 #include "util/VideoCoder.h"
+#include "Model/DecodeAheadBuffer.h"
+#include "Model/CameraCapture.h"
+#include "Model/FrameCache.h"
+#include "Model/ImagePrefetcher.h"
 
 namespace BioTracker {
 	namespace Core {
@@ -23,8 +28,14 @@ namespace BioTracker {
 		ImageStream::ImageStream(QObject *parent) : QObject(parent),
 			m_current_frame(new cv::Mat(cv::Size(0, 0), CV_8UC3)),
 			m_current_frame_number(0),
-			m_frame_stride(BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION)->
-				getValueOrDefault<int>(CFG_INPUT_FRAME_STRIDE, CFG_INPUT_FRAME_STRIDE_VAL)) {
+			m_current_capture_sequence(0),
+			m_frame_stride(std::max(1, BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION)->
+				getValueOrDefault<int>(CFG_INPUT_FRAME_STRIDE, CFG_INPUT_FRAME_STRIDE_VAL))),
+			m_base_stride(m_frame_stride),
+			m_frame_period(0) {
+			Settings *set = BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION);
+			m_adaptive_stride = set->getValueOrDefault<bool>(CFG_ADAPTIVE_STRIDE, CFG_ADAPTIVE_STRIDE_VAL);
+			m_max_stride = std::max<size_t>(m_base_stride, set->getValueOrDefault<int>(CFG_ADAPTIVE_STRIDE_MAX, CFG_ADAPTIVE_STRIDE_MAX_VAL));
 		}
 
 		size_t ImageStream::currentFrameNumber() const {
@@ -35,6 +46,45 @@ namespace BioTracker {
 			return m_current_frame;
 		}
 
+		std::chrono::system_clock::time_point ImageStream::currentCaptureTime() const {
+			return m_current_capture_time;
+		}
+
+		unsigned long long ImageStream::currentCaptureSequence() const {
+			return m_current_capture_sequence;
+		}
+
+		size_t ImageStream::frameStride() const {
+			return m_frame_stride;
+		}
+
+		void ImageStream::adaptStride(double targetFps) {
+			if (!m_adaptive_stride || targetFps <= 0) {
+				return;
+			}
+			const auto now = std::chrono::steady_clock::now();
+			const double dt = std::chrono::duration<double>(now - m_last_adapt).count();
+			m_last_adapt = now;
+			// A long gap is a pause, not load: start measuring anew
+			if (dt > 1.0) {
+				m_frame_period = 0;
+				return;
+			}
+			m_frame_period = m_frame_period > 0 ? 0.9 * m_frame_period + 0.1 * dt : dt;
+
+			// Source frames that pass in real time while the player handles one, compared to the frames it advances by.
+			// The gap between the thresholds keeps the stride from flapping.
+			const double needed = m_frame_period * targetFps;
+			if (needed > m_frame_stride * 1.1 && m_frame_stride < m_max_stride) {
+				m_frame_stride++;
+				m_frame_period = 0;
+			}
+			else if (m_frame_stride > m_base_stride && needed < (m_frame_stride - 1) * 0.8) {
+				m_frame_stride--;
+				m_frame_period = 0;
+			}
+		}
+
 		bool ImageStream::setFrameNumber(size_t frame_number) {
 			// valid new frame number
 			if (frame_number < this->numFrames()) {
@@ -97,6 +147,13 @@ namespace BioTracker {
 			m_current_frame.swap(img);
 		}
 
+		void ImageStream::set_current_frame(std::shared_ptr<cv::Mat> img, std::chrono::system_clock::time_point captureTime,
+			unsigned long long sequence) {
+			m_current_frame.swap(img);
+			m_current_capture_time = captureTime;
+			m_current_capture_sequence = sequence;
+		}
+
 		void ImageStream::clearImage() {
 			m_current_frame.reset();
 			m_current_frame_number = this->numFrames();
@@ -165,14 +222,20 @@ namespace BioTracker {
                     m_fps = 1;
                 }
 
+				// decode the upcoming files in parallel, if configured
+				int prefetchFrames = set->getValueOrDefault<int>(CFG_PREFETCH_FRAMES, CFG_PREFETCH_FRAMES_VAL);
+				int prefetchThreads = set->getValueOrDefault<int>(CFG_PREFETCH_THREADS, CFG_PREFETCH_THREADS_VAL);
+				int cacheSize = set->getValueOrDefault<int>(CFG_SEEK_CACHE, CFG_SEEK_CACHE_VAL);
+				if (prefetchFrames > 0 && this->numFrames() > 0) {
+					m_prefetcher = std::make_unique<ImagePrefetcher>(m_picture_files, std::max(prefetchThreads, 0), prefetchFrames, std::max(cacheSize, 0));
+				}
+
 				// load first image
+				m_recording = false;
 				if (this->numFrames() > 0) {
 					this->setFrameNumber_impl(0);
-					std::string filename = m_picture_files[0].string();
-					std::shared_ptr<cv::Mat> new_frame = std::make_shared<cv::Mat>(cv::imread(filename));
-					m_w = new_frame->size().width;
-					m_h = new_frame->size().height;
-					m_recording = false;
+					m_w = this->currentFrame()->size().width;
+					m_h = this->currentFrame()->size().height;
 					vCoder = std::make_shared<VideoCoder>();
 				}
 
@@ -204,8 +267,7 @@ namespace BioTracker {
 				m_currentFrame += m_frame_stride;
 				if (this->numFrames() > m_currentFrame) {
 
-					const std::string &filename = m_picture_files[m_currentFrame].string();
-					std::shared_ptr<cv::Mat> new_frame = std::make_shared<cv::Mat>(cv::imread(filename));
+					std::shared_ptr<cv::Mat> new_frame = loadFrame(m_currentFrame);
 					this->set_current_frame(new_frame);
 					if (m_recording) {
 						if (vCoder) vCoder->add(new_frame);
@@ -216,8 +278,7 @@ namespace BioTracker {
 			}
 
 			virtual bool setFrameNumber_impl(size_t frame_number) override {
-				const std::string &filename = m_picture_files[frame_number].string();
-				std::shared_ptr<cv::Mat> new_frame = std::make_shared<cv::Mat>(cv::imread(filename));
+				std::shared_ptr<cv::Mat> new_frame = loadFrame(frame_number);
 				this->set_current_frame(new_frame);
 				m_currentFrame = frame_number;
 				if (m_recording) {
@@ -225,7 +286,15 @@ namespace BioTracker {
 				}
 				return !new_frame->empty();
 			}
+			std::shared_ptr<cv::Mat> loadFrame(size_t frame_number) {
+				if (m_prefetcher) {
+					return m_prefetcher->get(frame_number, m_frame_stride);
+				}
+				return std::make_shared<cv::Mat>(cv::imread(m_picture_files[frame_number].string()));
+			}
+
 			std::vector<boost::filesystem::path> m_picture_files;
+			std::unique_ptr<ImagePrefetcher> m_prefetcher;
 			std::shared_ptr<VideoCoder> vCoder;
 			double m_w;
 			double m_h;
@@ -236,8 +305,10 @@ namespace BioTracker {
 
 
 		/*********************************************************/
-
-
+// Frames the video capture grabs forward without decoding before it rather seeks
+#define MAXGRABFORWARD 64
+// Capture position that is not known
+#define NOPOSITION static_cast<size_t>(-1)
 		class ImageStream3Video : public ImageStream {
 		public:
 			/**
@@ -250,7 +321,12 @@ namespace BioTracker {
 				: m_capture(filename.string())
 				, m_num_frames(static_cast<size_t>(m_capture.get(CV_CAP_PROP_FRAME_COUNT)))
 				, m_fps(m_capture.get(CV_CAP_PROP_FPS))
-				, m_fileName(filename.string()) {
+				, m_fileName(filename.string())
+				, m_cache(BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION)->
+					getValueOrDefault<int>(CFG_SEEK_CACHE, CFG_SEEK_CACHE_VAL))
+				, m_nextFrame(NOPOSITION)
+				, m_frameOffset(m_frame_stride - 1)
+				, m_position(0) {
 				if (!boost::filesystem::exists(filename)) {
 					throw file_not_found("Could not find file " + filename.string());
 				}
@@ -270,9 +346,15 @@ namespace BioTracker {
 				m_recording = false;
 				vCoder = std::make_shared<VideoCoder>();
 
+				// decode frames ahead of the playhead on a separate thread, if configured. It is started at the first frame.
+				int decodeAhead = set->getValueOrDefault<int>(CFG_DECODE_AHEAD, CFG_DECODE_AHEAD_VAL);
+				if (decodeAhead > 0) {
+					m_decodeAhead = std::make_unique<DecodeAheadBuffer>(m_capture, decodeAhead, m_frame_stride);
+				}
+
 				// load first image
 				if (this->numFrames() > 0) {
-					this->nextFrame_impl();
+					this->showFrame(0);
 				}
 			}
 			virtual GuiParam::MediaType type() const override {
@@ -298,29 +380,114 @@ namespace BioTracker {
 
 		private:
 			virtual bool nextFrame_impl() override {
-				cv::Mat new_frame;
-				for (int i = 0; i<m_frame_stride; i++)
-					m_capture >> new_frame;
-				std::shared_ptr<cv::Mat> mat(new cv::Mat(new_frame));
+				return this->showFrame(this->currentFrameNumber() + m_frame_stride, true);
+			}
+
+			virtual bool setFrameNumber_impl(size_t frame_number) override {
+				return this->showFrame(frame_number);
+			}
+
+			/**
+			* Makes frame_number the current frame. Cached frames are served without decoding, everything else is
+			* decoded by decodeFrame(). Only frames reached by a jump are cached, playing forward is left to the
+			* decode-ahead ring: a cached ring frame would be pinned and make the decoder allocate a new one.
+			*/
+			bool showFrame(size_t frame_number, bool forward = false) {
+				std::shared_ptr<cv::Mat> mat = m_cache.get(frame_number);
+				if (!mat) {
+					// Stepping backwards: a seek decodes from the previous keyframe anyway, so keep the whole
+					// block in front of the requested frame. Further back-steps are then served from the cache.
+					if (frame_number < this->currentFrameNumber() && m_cache.capacity() > 0) {
+						fillCache(frame_number);
+						mat = m_cache.get(frame_number);
+					}
+					if (!mat) {
+						mat = decodeFrame(frame_number);
+						if (!forward) {
+							// the cache keeps its own copy rather than a slot of the decode-ahead ring
+							m_cache.put(frame_number, m_decodeAhead ? std::make_shared<cv::Mat>(mat->clone()) : mat);
+						}
+					}
+				}
+
 				this->set_current_frame(mat);
 				if (m_recording) {
 					if (vCoder) vCoder->add(mat);
 				}
-				return !new_frame.empty();
+				return !mat->empty();
 			}
 
-			virtual bool setFrameNumber_impl(size_t frame_number) override {
-				// new frame is next frame --> use next frame function
-				if (this->currentFrameNumber() + 1 == frame_number) {
-					return this->nextFrame_impl();
+			/**
+			* Decodes frame_number. With decode-ahead the frame is popped from the decoder thread, which is restarted
+			* when the playhead jumped or the stride changed.
+			*/
+			std::shared_ptr<cv::Mat> decodeFrame(size_t frame_number) {
+				if (m_decodeAhead) {
+					if (frame_number != m_nextFrame || m_decodeAhead->stride() != m_frame_stride) {
+						m_decodeAhead->stop();
+						moveTo(frame_number);
+						m_decodeAhead->setStride(m_frame_stride);
+						m_decodeAhead->start();
+						// the decoder thread owns the capture from here on
+						m_position = NOPOSITION;
+					}
+					m_nextFrame = frame_number + m_frame_stride;
+					return m_decodeAhead->pop();
+				}
+
+				moveTo(frame_number);
+				std::shared_ptr<cv::Mat> mat = std::make_shared<cv::Mat>();
+				if (m_capture.read(*mat)) {
+					m_position++;
 				}
 				else {
+					m_position = NOPOSITION;
+				}
+				return mat;
+			}
+
+			/**
+			* Positions the capture so the next read decodes frame_number. Frames up to MAXGRABFORWARD ahead are reached
+			* by grabbing without decoding them, that's cheaper than a seek, which has to decode from the previous keyframe.
+			*/
+			void moveTo(size_t frame_number) {
+				const size_t position = frame_number + m_frameOffset;
+				if (position < m_position || position - m_position > MAXGRABFORWARD) {
 					// adjust frame position ("0-based index of the frame to be decoded/captured next.")
-					m_capture.set(CV_CAP_PROP_POS_FRAMES, static_cast<double>(frame_number));
-					return this->nextFrame_impl();
+					m_capture.set(CV_CAP_PROP_POS_FRAMES, static_cast<double>(position));
+					m_position = position;
+				}
+				while (m_position < position) {
+					if (!m_capture.grab()) {
+						// end of the video, the following read fails as well
+						m_position = NOPOSITION;
+						return;
+					}
+					m_position++;
 				}
 			}
 
+			/**
+			* Decodes the frames up to and including frame_number into the cache, as many as the cache holds.
+			* Afterwards the capture is positioned right behind frame_number.
+			*/
+			void fillCache(size_t frame_number) {
+				if (m_decodeAhead) {
+					m_decodeAhead->stop();
+					m_nextFrame = NOPOSITION;
+				}
+				const size_t first = frame_number + 1 > m_cache.capacity() ? frame_number + 1 - m_cache.capacity() : 0;
+				moveTo(first);
+				bool ok = true;
+				for (size_t i = first; i <= frame_number && ok; i++) {
+					std::shared_ptr<cv::Mat> mat = std::make_shared<cv::Mat>();
+					ok = m_capture.read(*mat);
+					m_cache.put(i, mat);
+				}
+				// position is unknown after a failed read; the next decodeFrame() falls back to a seek
+				m_position = ok ? frame_number + m_frameOffset + 1 : NOPOSITION;
+			}
+
 			cv::VideoCapture m_capture;
 			const size_t     m_num_frames;
 			const std::string m_fileName;
@@ -329,11 +496,22 @@ namespace BioTracker {
 			double m_w;
 			double m_h;
 			bool m_recording;
+			FrameCache m_cache;
+			// frame number the decode-ahead delivers next, NOPOSITION while it is stopped
+			size_t m_nextFrame;
+			// a frame number refers to the last of the m_frame_stride frames decoded for it at the configured stride
+			const size_t m_frameOffset;
+			// frame the capture decodes next, NOPOSITION if unknown or owned by the decoder thread
+			size_t m_position;
+			// declared after m_capture so the decoder thread is joined before the capture is released
+			std::unique_ptr<DecodeAheadBuffer> m_decodeAhead;
 		};
 
 
 		/*********************************************************/
 #include <chrono>
+// Milliseconds the player waits for the next camera frame before it gives up on this one
+#define CAMERAFRAMETIMEOUT 1000
 		class ImageStream3Camera : public ImageStream {
 		public:
 			/**
@@ -380,6 +558,14 @@ namespace BioTracker {
 				m_h = m_capture.get(CV_CAP_PROP_FRAME_HEIGHT);
 				m_fps = m_capture.get(CV_CAP_PROP_FPS);
 				std::cout << "Cam open: " << m_capture.isOpened() << " w/h:" << m_w << "/" << m_h << " fps:" << m_fps << std::endl;
+
+				// From here on the capture thread drains the camera, the player only takes what it has queued
+				int queueSize = set->getValueOrDefault<int>(CFG_CAMERA_QUEUE, CFG_CAMERA_QUEUE_VAL);
+				int policy = set->getValueOrDefault<int>(CFG_CAMERA_DROP_POLICY, CFG_CAMERA_DROP_POLICY_VAL);
+				m_cameraCapture.reset(new CameraCapture(m_capture, queueSize > 0 ? size_t(queueSize) : 1,
+					policy == CameraCapture::DROP_NEWEST ? CameraCapture::DROP_NEWEST : CameraCapture::DROP_OLDEST));
+				m_cameraCapture->start();
+
 				// load first image
 				if (this->numFrames() > 0) {
 					this->nextFrame_impl();
@@ -395,7 +581,17 @@ namespace BioTracker {
 				if (!m_capture.isOpened()) {
 					return false;
 				}
+				// The capture thread must not add frames while the coder is switched, but keeps grabbing meanwhile.
+				// Removing the sink waits for a running call. It's only set while recording, otherwise the capture
+				// thread doesn't decode the frames the player skips.
+				m_cameraCapture->setSink(CameraCapture::FrameSink());
 				m_recording = vCoder->toggle(m_w, m_h, m_fps);
+				if (m_recording) {
+					// Recording gets every frame the camera delivers, also those the player skips or drops
+					m_cameraCapture->setSink([this](const CameraCapture::Frame &frame) {
+						vCoder->add(frame.image);
+					});
+				}
 
 				return m_recording;
 			}
@@ -409,18 +605,15 @@ namespace BioTracker {
 		private:
 
 			virtual bool nextFrame_impl() override {
-				cv::Mat new_frame;
-
-				for (int i = 0; i < m_frame_stride; i++) {
-					m_capture >> new_frame;
-				}
-
-				std::shared_ptr<cv::Mat> mat(new cv::Mat(new_frame));
-				this->set_current_frame(mat);
-				if (m_recording) {
-					if (vCoder) vCoder->add(mat);
+				// the capture thread skips the frames in between
+				m_cameraCapture->setStride(m_frame_stride);
+				CameraCapture::Frame frame;
+				if (!m_cameraCapture->pop(frame, std::chrono::milliseconds(CAMERAFRAMETIMEOUT)) || !frame.image) {
+					this->set_current_frame(std::make_shared<cv::Mat>());
+					return false;
 				}
-				return !mat->empty();
+				this->set_current_frame(frame.image, frame.captureTime, frame.sequence);
+				return true;
 			}
 
 			virtual bool setFrameNumber_impl(size_t) override {
@@ -435,6 +628,8 @@ namespace BioTracker {
 			double m_w;
 			double m_h;
 			bool m_recording;
+			// declared after m_capture so the capture thread is joined before the camera is released
+			std::unique_ptr<CameraCapture> m_cameraCapture;
 		};
 
 		/*********************************************************/
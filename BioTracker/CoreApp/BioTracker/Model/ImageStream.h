@@ -12,6 +12,7 @@
 #include <opencv2/opencv.hpp>           // cv::Mat
 #include <vector>                       // std::vector
 #include <string>                       // std::string
+#include <chrono>                       // std::chrono::system_clock
 #include <boost/filesystem.hpp>
 #include <QObject>
 #include "QSharedPointer"
@@ -78,6 +79,29 @@ class ImageStream : public QObject {
      */
     std::shared_ptr<cv::Mat> currentFrame() const;
 
+    /**
+     * @return the time the current frame was captured, or the epoch if the stream doesn't know it (files).
+     */
+    std::chrono::system_clock::time_point currentCaptureTime() const;
+
+    /**
+     * @return the capture sequence number of the current frame, 0 if the stream doesn't count frames.
+     * - gaps are frames the source dropped before they reached the player.
+     */
+    unsigned long long currentCaptureSequence() const;
+
+    /**
+     * @return the number of source frames nextFrame() advances by, i.e. how many frames the current one stands for.
+     */
+    size_t frameStride() const;
+
+    /**
+     * Adaptive stride: called once per played frame with the rate the player tries to hold, in frames per second.
+     * Raises the stride while the player falls behind that rate and lowers it back towards the configured stride
+     * once it catches up. Does nothing unless adaptive stride is enabled in the settings.
+     */
+    void adaptStride(double targetFps);
+
     /**
      * sets the current frame number and updates the current frame.
      * - if frame_number is invalid, the current frame is invalidated.
@@ -116,6 +140,12 @@ class ImageStream : public QObject {
      */
     void set_current_frame(std::shared_ptr<cv::Mat> img);
 
+    /**
+     * sets the image returned by this->currentFrame() along with when it was captured.
+     */
+    void set_current_frame(std::shared_ptr<cv::Mat> img, std::chrono::system_clock::time_point captureTime,
+                           unsigned long long sequence);
+
 	/**
 	* Sets the title of the current image stream.
 	* A title should represent the identity of a source stream as a string.
@@ -128,8 +158,9 @@ class ImageStream : public QObject {
 
 	/**
 	* The stride of the image stream. Think of it as "use only every n'th frame".
+	* Fixed unless adaptive stride is enabled, then it changes between frames.
 	*/
-	const size_t m_frame_stride;
+	size_t m_frame_stride;
 
   private:
     /**
@@ -157,6 +188,16 @@ class ImageStream : public QObject {
 
     std::shared_ptr<cv::Mat> m_current_frame;
 	size_t  m_current_frame_number;
+	std::chrono::system_clock::time_point m_current_capture_time;
+	unsigned long long m_current_capture_sequence;
+
+	// adaptive stride: the configured stride is the lower bound
+	const size_t m_base_stride;
+	size_t m_max_stride;
+	bool m_adaptive_stride;
+	std::chrono::steady_clock::time_point m_last_adapt;
+	// smoothed time between two played frames in seconds, 0 until measured
+	double m_frame_period;
 	std::string m_title;
 };
 
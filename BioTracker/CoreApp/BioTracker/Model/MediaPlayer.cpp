@@ -7,9 +7,15 @@
 #include "util/singleton.h"
 #include "settings/Settings.h"
 
+#include <algorithm>
+
+// scene captures the video coder may hold at a time
+#define CAPTUREPOOLSIZE 8
+
 MediaPlayer::MediaPlayer(QObject* parent) :
     IModel(parent) {
-	m_trackingDone = true;
+	m_framesInTracking = 0;
+	m_operationPending = false;
 	m_currentFPS = 0;
 	m_fpsOfSourceFile = 0;
 	_imagew = 0;
@@ -23,6 +29,11 @@ MediaPlayer::MediaPlayer(QObject* parent) :
     m_TrackingIsActive = false;
 	m_recd = false;
 	m_recordScaled = false;
+	m_droppedCaptures = 0;
+
+	BioTracker::Core::Settings *set = BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION);
+	m_pipelineDepth = std::max(1, set->getValueOrDefault<int>(CFG_PIPELINE_DEPTH, CFG_PIPELINE_DEPTH_VAL));
+
     // Initialize PlayerStateMachine and a Thread for the Player
     //    // Do not set a Parent for MediaPlayerStateMachine in order to run the Player in the QThread!
 
@@ -49,9 +60,8 @@ MediaPlayer::MediaPlayer(QObject* parent) :
 
 	QObject::connect(this, &MediaPlayer::toggleRecordImageStreamCommand, m_Player, &MediaPlayerStateMachine::receivetoggleRecordImageStream);
 
-    // Handel PlayerStateMachine results
-	QObject::connect(m_Player, &MediaPlayerStateMachine::emitPlayerParameters, this, &MediaPlayer::receivePlayerParameters, Qt::BlockingQueuedConnection);
-	QObject::connect(m_Player, &MediaPlayerStateMachine::emitPlayerParameters, this, &MediaPlayer::fwdPlayerParameters);
+    // Handel PlayerStateMachine results. The parameters are a copy, so the player thread does not have to wait for them to be processed.
+	QObject::connect(m_Player, &MediaPlayerStateMachine::emitPlayerParameters, this, &MediaPlayer::receivePlayerParameters, Qt::QueuedConnection);
 
     // Handle next state operation
     QObject::connect(m_Player, &MediaPlayerStateMachine::emitPlayerOperationDone, this, &MediaPlayer::receivePlayerOperationDone);
@@ -66,6 +76,8 @@ MediaPlayer::MediaPlayer(QObject* parent) :
 
 MediaPlayer::~MediaPlayer() {
     stopCommand();
+    // The player thread might be waiting for a free copy of the playerParameters
+    m_Player->releasePlayerParameters();
     m_PlayerThread->quit();
     if (!m_PlayerThread->wait(2000))
     {
@@ -80,6 +92,10 @@ void MediaPlayer::setTrackingActive() {
 
 void MediaPlayer::setTrackingDeactive() {
     m_TrackingIsActive = false;
+    if (m_operationPending) {
+        m_operationPending = false;
+        Q_EMIT runPlayerOperation();
+    }
 }
 
 bool MediaPlayer::getPlayState() {
@@ -188,29 +204,51 @@ int MediaPlayer::reopenVideoWriter() {
 }
 
 void MediaPlayer::takeScreenshot(GraphicsView *gv) {
-    //TODO duplicated code
     QRectF rscene = gv->sceneRect(); //0us
     QRectF rview = gv->rect(); //0us
-    QPixmap *pix;
-    if (!m_recordScaled)
-        pix = new QPixmap(rscene.size().toSize()); //17us
-    else
-        pix = new QPixmap(rview.size().toSize()); //17us
-
-    QPainter *paint = new QPainter(pix); //21us
+    QImage image(m_recordScaled ? rview.size().toSize() : rscene.size().toSize(), QImage::Format_RGB32);
+    image.fill(Qt::white);
+    {
+        QPainter paint(&image);
+        if (!m_recordScaled)
+            gv->scene()->render(&paint); //8544us
+        else
+            gv->render(&paint);
+    }
 
-    if (!m_recordScaled)
-        gv->scene()->render(paint); //8544us
-    else
-        gv->render(paint);
+    image.save(getTimeAndDate(CFG_DIR_SCREENSHOTS+std::string("/Screenshot"), ".png").c_str());
+}
 
-    QImage image = pix->toImage(); //8724us
+void MediaPlayer::captureScene() {
+	QSize size = m_recordScaled ? m_gv->rect().size() : m_gv->sceneRect().size().toSize();
+	if (!m_capturePool || !m_capturePool->matches(size.height(), size.width(), CV_8UC4))
+		m_capturePool = FramePool::create(size.height(), size.width(), CV_8UC4, CAPTUREPOOLSIZE);
+
+	std::shared_ptr<cv::Mat> mat = m_capturePool->acquire();
+	if (!mat) {
+		// the coder is behind, better lose a frame of the recording than hold up the player
+		if (m_droppedCaptures++ % 100 == 0)
+			std::cout << "Scene recording can't keep up, dropped " << m_droppedCaptures << " frames so far" << std::endl;
+		return;
+	}
 
-    image.save(getTimeAndDate(CFG_DIR_SCREENSHOTS+std::string("/Screenshot"), ".png").c_str());
+	// render straight into the pooled buffer, RGB32 is BGRA in memory (little endian)
+	QImage image(mat->data, mat->cols, mat->rows, static_cast<int>(mat->step), QImage::Format_RGB32);
+	if (!m_recordScaled)
+		image.fill(Qt::white);
+	{
+		QPainter paint(&image);
+		if (!m_recordScaled)
+			m_gv->scene()->render(&paint); //8544us
+		else
+			m_gv->render(&paint);
+	}
+	// the worker thread converts it to BGR
+	m_videoc->add(mat, 1);
 }
 
 void MediaPlayer::receiveTrackingPaused() {
-    m_trackingDone = true;
+    m_framesInTracking = 0;
 }
 
 void MediaPlayer::receivePlayerParameters(playerParameters* param) {
@@ -234,8 +272,9 @@ void MediaPlayer::receivePlayerParameters(playerParameters* param) {
     Q_EMIT renderCurrentImage(m_CurrentFrame, m_NameOfCvMat);
 
 	if (m_TrackingIsActive) {
-        m_trackingDone = false;
-		Q_EMIT trackCurrentImage(m_CurrentFrame, m_CurrentFrameNumber);
+        m_framesInTracking++;
+		qint64 captureTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(param->m_CaptureTime.time_since_epoch()).count();
+		Q_EMIT trackCurrentImage(m_CurrentFrame, m_CurrentFrameNumber, captureTimeUs, param->m_CaptureSequence);
 	}
 	else {
 		Q_EMIT signalVisualizeCurrentModel(m_CurrentFrameNumber);
@@ -243,32 +282,12 @@ void MediaPlayer::receivePlayerParameters(playerParameters* param) {
 	}
 
 	if (m_recd) {
-		//reopenVideoWriter(); //4us
-		QRectF rscene = m_gv->sceneRect(); //0us
-		QRectF rview = m_gv->rect(); //0us
-		QPixmap *pix;
-		if (!m_recordScaled)
-			pix = new QPixmap(rscene.size().toSize()); //17us
-		else
-			pix = new QPixmap(rview.size().toSize()); //17us
-
-		QPainter *paint = new QPainter(pix); //21us
-        
-		if(!m_recordScaled)
-			m_gv->scene()->render(paint); //8544us
-		else
-			m_gv->render(paint);// , m_gv->scene()->sceneRect(), QRect());// , Qt::AspectRatioMode::IgnoreAspectRatio);
-
-		QImage image = pix->toImage(); //8724us
-		int x = image.format(); //0us
-		std::shared_ptr<cv::Mat> mat = std::make_shared<cv::Mat>(image.height(), image.width(), CV_8UC(image.depth()/8), (uchar*)image.bits(), image.bytesPerLine()); //1us
-
-		cv::cvtColor(*mat, *mat, CV_BGR2RGB); //16898 us
-		cv::cvtColor(*mat, *mat, CV_BGR2RGB);
-		m_videoc->add(mat,1);
-		
+		captureScene();
 	}
 
+    Q_EMIT fwdPlayerParameters(param);
+    m_Player->releasePlayerParameters();
+
     Q_EMIT notifyView();
 }
 
@@ -292,8 +311,14 @@ void MediaPlayer::receivePlayerOperationDone() {
         m_currentFPS = 0;
     }
 
-    if(m_trackingDone == true || !m_TrackingIsActive)
+    // Decode the next frame while the previous ones are still being tracked, unless the pipeline is full
+    if (m_framesInTracking < m_pipelineDepth || !m_TrackingIsActive) {
+        m_operationPending = false;
 		Q_EMIT runPlayerOperation();
+    }
+    else {
+        m_operationPending = true;
+    }
 
 
 	start = std::chrono::system_clock::now();
@@ -302,7 +327,11 @@ void MediaPlayer::receivePlayerOperationDone() {
 void MediaPlayer::receiveTrackingOperationDone() {
     // Only emit this SIGNAL when tracking is active
     if (m_TrackingIsActive) {
-        m_trackingDone = true;
+        m_framesInTracking = std::max(0, m_framesInTracking - 1);
+        if (m_operationPending && m_framesInTracking < m_pipelineDepth) {
+            m_operationPending = false;
+            Q_EMIT runPlayerOperation();
+        }
     }
 }
 
@@ -18,6 +18,7 @@
 #include <chrono>
 #include "util/types.h"
 #include "util/VideoCoder.h"
+#include "util/FramePool.h"
 
 /**
  * The MediaPlayer class is an IModel class an part of the MediaPlayer component. This class creats a MediaPlayerStateMachine object and moves it to a QThread.
@@ -81,9 +82,10 @@ class MediaPlayer : public IModel {
      */
     void renderCurrentImage(std::shared_ptr<cv::Mat> mat, QString name);
     /**
-     * This SIGNAL is only emmited if Tracking Is Active. The PluginLoader component will receive the cv::Mat and the current frame number.
+     * This SIGNAL is only emmited if Tracking Is Active. The PluginLoader component will receive the cv::Mat and the current frame number,
+     * together with the capture time in microseconds since the epoch (0 if unknown) and the capture sequence number.
      */
-    void trackCurrentImage(std::shared_ptr<cv::Mat> mat, uint number);
+    void trackCurrentImage(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs, quint64 sequence);
 	/**
 	* This SIGNAL is only emmited if Tracking Is inactive. The core visualization controller will receive the framenumber and will try to visualize the tracking model.
 	*/
@@ -135,8 +137,8 @@ class MediaPlayer : public IModel {
     void receivePlayerOperationDone();
 
     /**
-     * If a BioTracker Plugin is done with executing its tracking algorithm this SLOT will be triggerd. As soon as this SLOT is triggered, the MediaPlayerStateMachine will be
-     * advised to execute the next state.
+     * If a BioTracker Plugin is done with executing its tracking algorithm this SLOT will be triggerd. If the MediaPlayerStateMachine was held back because
+     * too many frames were in flight, it will be advised to execute the next state.
      */
     void receiveTrackingOperationDone();
 
@@ -162,6 +164,11 @@ class MediaPlayer : public IModel {
 	  * helper function which opens a video. If video size has changed, a new video is opened. 
 	  */
 	int reopenVideoWriter();
+	/**
+	* Renders the graphics scene into a pooled buffer and hands it to the video coder. Drops the frame if the coder
+	* still holds all buffers.
+	*/
+	void captureScene();
 	int _imagew;
 	int _imageh;
 
@@ -192,13 +199,19 @@ class MediaPlayer : public IModel {
 
 	bool m_recd;
 	bool m_recordScaled;
-	bool m_trackingDone;
+	// Frames handed to the tracker but not reported back yet. Up to m_pipelineDepth of them may be in flight while
+	// the MediaPlayerStateMachine decodes the next one; m_operationPending remembers a deferred runPlayerOperation.
+	int m_framesInTracking;
+	int m_pipelineDepth;
+	bool m_operationPending;
     bool _paused = true;
 
 	bool m_useCuda;
 	GraphicsView *m_gv;
 	std::shared_ptr<cv::VideoWriter> m_videoWriter;
 	std::shared_ptr<VideoCoder> m_videoc;
+	std::shared_ptr<FramePool> m_capturePool;
+	unsigned long m_droppedCaptures;
 
     bool m_TrackingIsActive;
     QString m_NameOfCvMat = "Original";
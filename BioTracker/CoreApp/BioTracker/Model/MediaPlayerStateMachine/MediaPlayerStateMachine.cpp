@@ -10,10 +10,18 @@
 #include "PlayerStates/PStateGoToFrame.h"
 
 #include "util/types.h"
+#include "util/singleton.h"
+#include "settings/Settings.h"
+
+#include <algorithm>
 
 MediaPlayerStateMachine::MediaPlayerStateMachine(QObject* parent) :
 	IModel(parent),
-	m_ImageStream(BioTracker::Core::make_ImageStream3NoMedia()) {
+	m_ImageStream(BioTracker::Core::make_ImageStream3NoMedia()),
+	m_ParameterSnapshots(std::max(2, BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION)->
+		getValueOrDefault<int>(CFG_PIPELINE_DEPTH, CFG_PIPELINE_DEPTH_VAL) + 1)),
+	m_NextSnapshot(0),
+	m_FreeSnapshots(static_cast<int>(m_ParameterSnapshots.size())) {
 
 	m_PlayerParameters = new playerParameters();
 
@@ -142,12 +150,25 @@ void MediaPlayerStateMachine::updatePlayerParameter() {
 
 	m_PlayerParameters->m_CurrentFrame = m_CurrentPlayerState->getCurrentFrame();
 	m_PlayerParameters->m_CurrentFrameNumber = m_CurrentPlayerState->getCurrentFrameNumber();
+	m_PlayerParameters->m_CaptureTime = m_CurrentPlayerState->m_ImageStream->currentCaptureTime();
+	m_PlayerParameters->m_CaptureSequence = m_CurrentPlayerState->m_ImageStream->currentCaptureSequence();
+	m_PlayerParameters->m_FrameStride = m_CurrentPlayerState->m_ImageStream->frameStride();
 	m_PlayerParameters->m_fpsSourceVideo = m_CurrentPlayerState->m_ImageStream->fps();
 }
 
 void MediaPlayerStateMachine::emitSignals() {
 
-	Q_EMIT emitPlayerParameters(m_PlayerParameters);
+	//The MediaPlayer gets a copy, so the next state can already operate while this one is being displayed
+	m_FreeSnapshots.acquire();
+	playerParameters* parameters = &m_ParameterSnapshots[m_NextSnapshot];
+	m_NextSnapshot = (m_NextSnapshot + 1) % m_ParameterSnapshots.size();
+	*parameters = *m_PlayerParameters;
+
+	Q_EMIT emitPlayerParameters(parameters);
+}
+
+void MediaPlayerStateMachine::releasePlayerParameters() {
+	m_FreeSnapshots.release();
 }
 
 void MediaPlayerStateMachine::setNextState(IPlayerState::PLAYER_STATES state) {
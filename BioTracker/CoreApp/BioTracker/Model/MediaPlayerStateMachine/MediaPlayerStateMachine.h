@@ -16,7 +16,9 @@
 #include "QString"
 #include "QMap"
 #include "QThread"
+#include "QSemaphore"
 #include "opencv2/core/core.hpp"
+#include <vector>
 
 #include "View/VideoControllWidget.h"
 #include "View/GLVideoView.h"
@@ -43,6 +45,13 @@ class MediaPlayerStateMachine : public IModel {
 
 	IPlayerState::PLAYER_STATES getState();
 
+	/**
+	 * Called by the MediaPlayer once it is done with the playerParameters of a frame. Each emitPlayerParameters hands out
+	 * its own copy from a small ring, so decoding can go ahead while earlier frames are still displayed. If all copies
+	 * are in use, the next emission blocks until one is released.
+	 */
+	void releasePlayerParameters();
+
 	//IPlayerState::PLAYER_STATES getState();
 
   public Q_SLOTS:
@@ -89,6 +98,9 @@ class MediaPlayerStateMachine : public IModel {
     std::shared_ptr<BioTracker::Core::ImageStream> m_ImageStream;
 
     playerParameters* m_PlayerParameters;
+    std::vector<playerParameters> m_ParameterSnapshots;
+    size_t m_NextSnapshot;
+    QSemaphore m_FreeSnapshots;
 	std::shared_ptr<BioTracker::Core::ImageStream> m_stream;
 };
 
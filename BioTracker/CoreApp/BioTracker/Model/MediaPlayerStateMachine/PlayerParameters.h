@@ -8,6 +8,8 @@
 #ifndef PLAYERPARAMETERS_H
 #define PLAYERPARAMETERS_H
 
+#include <chrono>
+
 /**
  * The playerParameters struct holds all data types of the current MediaPlayer state.
  */
@@ -28,6 +30,11 @@ struct playerParameters {
 	std::string m_CurrentTitle;
     size_t m_CurrentFrameNumber;
     std::shared_ptr<cv::Mat> m_CurrentFrame;
+    // when the current frame was captured (the epoch if unknown, e.g. for files) and its capture sequence number
+    std::chrono::system_clock::time_point m_CaptureTime;
+    unsigned long long m_CaptureSequence;
+    // the stride the player stepped to the current frame with
+    size_t m_FrameStride;
     double m_fpsSourceVideo;
     double m_fpsTarget;
 };
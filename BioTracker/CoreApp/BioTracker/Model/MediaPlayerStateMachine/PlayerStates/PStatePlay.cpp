@@ -35,6 +35,8 @@ void PStatePlay::operate() {
     IPlayerState::PLAYER_STATES nextState = IPlayerState::STATE_INITIAL;
 
     if (!isLastFrame) {
+        // Skip more frames if playing falls behind the target rate, fewer once it catches up
+        m_ImageStream->adaptStride(_targetFps > 0 ? _targetFps : m_ImageStream->fps());
         m_ImageStream->nextFrame();
         m_Mat = m_ImageStream->currentFrame();
         m_FrameNumber = m_ImageStream->currentFrameNumber(); 
@@ -2,54 +2,102 @@
 
 TextureObject::TextureObject(QObject *parent, QString name) :
     IModel(parent),
-    m_Name(name)
+    m_Name(name),
+    m_active(false),
+    m_dirty(false)
 {
     // OpenCV's coordinate system originates in the upper left corner.
     // OpenGL originates in the lower left. Thus the image has to be flipped vertically
     m_texture = QImage(1, 1, QImage::Format_RGB888);
 }
 
-void TextureObject::set(const cv::Mat &img) {
+void TextureObject::set(std::shared_ptr<cv::Mat> img) {
 	//TODO Andi this cv::Mat is null sometimes when using the camera!?
-	if (&img == NULL)
+	if (!img)
 		return;
+
+    // only a reference, the pixels are not touched until the texture is shown
+    m_source = img;
+    m_dirty = true;
+    if (m_active) {
+        convert();
+        Q_EMIT notifyView();
+    }
+}
+
+void TextureObject::setActive(bool active) {
+    m_active = active;
+    if (m_active && m_dirty) {
+        convert();
+        Q_EMIT notifyView();
+    }
+}
+
+void TextureObject::convert() {
+    m_dirty = false;
+    if (!m_source || m_source->empty())
+        return;
+    // keeps the frame alive while the texture points to it, until the next one is converted
+    m_shown = m_source;
+    const cv::Mat &img = *m_shown;
+
+    QImage::Format format = QImage::Format_RGB888;
     if (img.channels() == 3) {
-        img.convertTo(img, CV_8UC3);
-        cv::cvtColor(img, m_img, CV_BGR2RGB);
+        const cv::Mat *bgr = &img;
+        if (img.depth() != CV_8U) {
+            img.convertTo(m_img8U, CV_8UC3);
+            bgr = &m_img8U;
+        }
+#if QT_VERSION >= 0x050E00
+        // Qt reads BGR as it is, no copy at all
+        m_img = *bgr;
+        format = QImage::Format_BGR888;
+#else
+        // m_img keeps its buffer as long as the frame size does not change
+        cv::cvtColor(*bgr, m_img, CV_BGR2RGB);
+#endif
     } else if (img.channels() == 1) {
-        // convert grayscale to "color"
-        cv::Mat img8U;
-
-        // we assume that the 1d image has more than 8bit per pixel
-        // (usually 64F) so we need to map a [HUGE range] to -> [0 .. 255]
-        double min, max;
-        cv::minMaxLoc(img, &min, &max);
-        if (min >= 0 && min < 255 && max > 0 && max <= 255) {
-            // do not refit if the range is actually inbetween [0 ... 255]
-            img.convertTo(img8U, CV_8U);
-        } else if (max > min) {
-            // otherwise: the range is outside of native [0 ... 255] so we
-            // actually need to do some refitting
-
-            // mapping 1-step out from [0 .. 255] range 1-step in the [min .. max] range
-            const double sizeRatio = 256.0/abs(static_cast<int>(max - min));
-            const double convertedMin = abs(static_cast<int>(min * sizeRatio));
-            img.convertTo(img8U, CV_8U, sizeRatio, convertedMin);
+        if (img.depth() == CV_8U) {
+            // already in range, shown as it is
+            m_img = img;
+        } else {
+            // we assume that the 1d image has more than 8bit per pixel
+            // (usually 64F) so we need to map a [HUGE range] to -> [0 .. 255]
+            double min, max;
+            cv::minMaxLoc(img, &min, &max);
+            if (min >= 0 && min < 255 && max > 0 && max <= 255) {
+                // do not refit if the range is actually inbetween [0 ... 255]
+                img.convertTo(m_img8U, CV_8U);
+            } else if (max > min) {
+                // otherwise: the range is outside of native [0 ... 255] so we
+                // actually need to do some refitting
+
+                // mapping 1-step out from [0 .. 255] range 1-step in the [min .. max] range
+                const double sizeRatio = 256.0/abs(static_cast<int>(max - min));
+                const double convertedMin = abs(static_cast<int>(min * sizeRatio));
+                img.convertTo(m_img8U, CV_8U, sizeRatio, convertedMin);
+            } else {
+                // a constant image
+                img.convertTo(m_img8U, CV_8U);
+            }
+            m_img = m_img8U;
         }
-        cv::cvtColor(img8U, m_img, CV_GRAY2RGB);
+        format = QImage::Format_Grayscale8;
     } else {
         m_img = img;
     }
 
-    m_texture = QImage(
-                    m_img.data,
-                    m_img.cols,
-                    m_img.rows,
-                    static_cast<int>(m_img.step),
-                    QImage::Format_RGB888
-                );
-
-    Q_EMIT notifyView();
+    // the QImage only points to m_img, so it is only rebuilt when the buffer or its layout changes
+    if (m_texture.constBits() != m_img.data || m_texture.width() != m_img.cols || m_texture.height() != m_img.rows
+            || m_texture.bytesPerLine() != static_cast<int>(m_img.step) || m_texture.format() != format) {
+        m_texture = QImage(
+                        m_img.data,
+                        m_img.cols,
+                        m_img.rows,
+                        static_cast<int>(m_img.step),
+                        format
+                    );
+    }
 }
 
 QString TextureObject::getName()
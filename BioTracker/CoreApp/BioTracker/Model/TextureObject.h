@@ -12,6 +12,7 @@
 #include "Interfaces/IModel/IModel.h"
 
 #include <opencv2/opencv.hpp>
+#include <memory>
 #include "QImage"
 #include "QString"
 
@@ -24,7 +25,17 @@ class TextureObject : public IModel {
   public:
     explicit TextureObject(QObject* parent = 0, QString name = "NoName");
 
-    void set(cv::Mat const& img);
+    /**
+     * Takes the image to display. It is only converted while the texture is active, otherwise it is kept until the
+     * texture gets selected. The texture holds on to the image as long as it may show its pixels, so producers
+     * reusing their buffers see it as in use.
+     */
+    void set(std::shared_ptr<cv::Mat> img);
+
+    /**
+     * Only the active texture, the one selected in the view combobox, converts the images it receives.
+     */
+    void setActive(bool active);
     QString getName();
 
     QImage const& get() const {
@@ -38,9 +49,19 @@ class TextureObject : public IModel {
     }
 
   private:
+    void convert();
+
     QString m_Name;
+    // the last image set, not yet converted if m_dirty
+    std::shared_ptr<cv::Mat> m_source;
+    // the image converted last, m_img may share its pixels
+    std::shared_ptr<cv::Mat> m_shown;
+    // the pixels m_texture points to, either those of m_shown or one of the reused buffers
     cv::Mat m_img;
+    cv::Mat m_img8U;
     QImage m_texture;
+    bool m_active;
+    bool m_dirty;
 };
 
 #endif // BIOTRACKER3TEXTUREOBJECT_H
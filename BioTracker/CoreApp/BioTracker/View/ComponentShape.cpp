@@ -1,4 +1,5 @@
 #include "ComponentShape.h"
+#include "TrackedComponentView.h"
 #include "QBrush"
 #include "QPainter"
 #include "QMenu"
@@ -21,6 +22,8 @@
 #include <QtWidgets/QHeaderView>
 #include <QLinkedList>
 #include <qpair.h>
+#include <QFontMetricsF>
+#include <cmath>
 
 
 ComponentShape::ComponentShape(QGraphicsObject* parent, IModelTrackedTrajectory* trajectory, int id):
@@ -43,8 +46,9 @@ ComponentShape::ComponentShape(QGraphicsObject* parent, IModelTrackedTrajectory*
 	m_currentFramenumber = 0;
 	m_rotation = 0;
 	m_trajectoryWasActiveOnce = false;
+	m_dots = false;
 
-	m_tracingLayer = new QGraphicsRectItem();
+	m_tracingLayer = new ComponentTrail();
 	this->scene()->addItem(m_tracingLayer);
 
 	m_rotationLine = QLineF();
@@ -127,6 +131,15 @@ void ComponentShape::paint(QPainter * painter, const QStyleOptionGraphicsItem *
 		qDebug() << "componentscene is null\n";
 	}
 
+	//level of detail: just a dot in the center
+	if (m_dots) {
+		int dim = m_w <= m_h ? m_w : m_h;
+		painter->setPen(Qt::NoPen);
+		painter->setBrush(QBrush(this->isSelected() ? m_penColor : m_brushColor));
+		painter->drawEllipse(QRectF(m_w / 2.0 - dim / 4.0, m_h / 2.0 - dim / 4.0, dim / 2.0, dim / 2.0));
+		return;
+	}
+
 	QPen pen = QPen(m_penColor, m_penWidth, m_penStyle);
 	QBrush brush = QBrush(m_brushColor);
 	painter->setPen(pen);
@@ -194,6 +207,8 @@ bool ComponentShape::updateAttributes(uint frameNumber)
 {
 	m_currentFramenumber = frameNumber;
 
+	QMutexLocker locker(trackingLock());
+
 	if (m_trajectory && m_trajectory->size() != 0 && m_trajectory->getValid() && m_trajectory->getChild(frameNumber)) {
 		m_id = m_trajectory->getId();
 		//update m_fixed
@@ -306,66 +321,72 @@ bool ComponentShape::updateAttributes(uint frameNumber)
 void ComponentShape::trace()
 {
 	//TRACING
+	QMutexLocker locker(trackingLock());
 
 	IModelTrackedPoint* currentChild = dynamic_cast<IModelTrackedPoint*>(m_trajectory->getChild(m_currentFramenumber));
 	//return if current entity is not existant
 	if (!currentChild)
 		return;
 
-	QPointF currentPoint = QPointF(currentChild->getXpx(), currentChild->getYpx());
+	//no tracing when drawn as dots
+	if (m_dots) {
+		m_tracingLayer->hide();
+		return;
+	}
 
-	//update the tracing layer
-	m_tracingLayer->setPos(this->pos());
-	m_tracingLayer->setFlag(QGraphicsItem::ItemHasNoContents);
+	//the tracers are collected into a few batched paths of the tracing layer, no items per tracer
 	m_tracingLayer->show();
-
-	// really unefficient to flush each time
-	//flush tracing shape history, open up the memory
-    while (m_tracingLayer->childItems().size() > 0) {
-		delete m_tracingLayer->childItems()[0];
-    }
-
-	//check if number of tracing children in tracing layer is correct
-	//delete/add the difference
-	int initialSize = m_tracingLayer->childItems().size();
-	while (m_tracingLayer->childItems().size() > 0) {
-		delete m_tracingLayer->childItems()[0];
-	}
+	m_tracingLayer->clearBatches();
 
 	if (m_trajectory->size() == 0 || m_tracingLength <= 0 || m_tracingStyle == "None") {
+		m_tracingLayer->commitBatches();
 		return;
 	}
 
-	QPointF lastPointDifference = QPointF(0, 0) + QPointF(m_h / 2, m_w / 2);
+	//only fetches the frames that are new since the last call
+	m_tracingLayer->updateHistory(m_trajectory, m_currentFramenumber, m_tracingLength);
+
+	//the tracing layer draws in scene coordinates
+	QPointF lastPoint = QPointF(currentChild->getXpx(), currentChild->getYpx());
+
+	QFont font = QFont();
+	QPointF textBaseline;
+	QPen textPen = QPen(Qt::black);
+	textPen.setWidth(0);
+	if (m_tracerFrameNumber) {
+		int fontPixelSize = (int)((m_w + m_h) / 2) * m_tracerProportions * 0.2;
+		font.setPixelSize(fontPixelSize);
+		textBaseline = QPointF(-m_w * m_tracerProportions / 3.5f, -m_h * m_tracerProportions / 7 + QFontMetricsF(font).ascent());
+	}
 
 	for (int i = 1; i <= m_tracingLength && i <= m_currentFramenumber; i += m_tracingSteps) {
 			
-		IModelTrackedPoint* historyChild = dynamic_cast<IModelTrackedPoint*>(m_trajectory->getChild(m_currentFramenumber - i));
-		if (historyChild && historyChild->getValid()) {
+		const ComponentTrail::Sample* historyChild = m_tracingLayer->sample(i);
+		if (historyChild) {
 
 			//positioning
-			QPointF historyPoint = QPointF(historyChild->getXpx(), historyChild->getYpx());
-			QPointF historyPointDifference = historyPoint - currentPoint;
-			QPointF adjustedHistoryPointDifference = historyPointDifference + QPointF(m_w / 2, m_h / 2);
+			QPointF historyPoint = historyChild->pos;
 
 			//time degradation colors
+			//alpha and hue go in steps of 8, so that tracers of a similar age share a batch
 			QPen timeDegradationPen = QPen(m_penColor, m_penWidth, m_penStyle);
 			QBrush timeDegradationBrush = QBrush(m_brushColor);
 			QColor timeDegradationBrushColor;
 			QColor timeDegradationPenColor;
 
 			if (m_tracingTimeDegradation == "Transparency") {
-				timeDegradationPenColor = QColor(m_penColor.red(), m_penColor.green(), m_penColor.blue(), (200.0f - (200.0f / (float)m_tracingLength) * i) + 30);
+				int alpha = (int)((200.0f - (200.0f / (float)m_tracingLength) * i) + 30) & ~7;
+				timeDegradationPenColor = QColor(m_penColor.red(), m_penColor.green(), m_penColor.blue(), alpha);
 				timeDegradationPen = QPen(timeDegradationPenColor, m_penWidth, Qt::SolidLine);
 
-				timeDegradationBrushColor = QColor(m_brushColor.red(), m_brushColor.green(), m_brushColor.blue(), (200.0f - (200.0f / (float)m_tracingLength) * i) + 30);
+				timeDegradationBrushColor = QColor(m_brushColor.red(), m_brushColor.green(), m_brushColor.blue(), alpha);
 				timeDegradationBrush = QBrush(timeDegradationBrushColor);
 
 			}
 			else if (m_tracingTimeDegradation == "False color") {
-				float hue = (240.0f - ((240.0f / (float)m_tracingLength) * i));
-				timeDegradationPenColor = QColor::fromHsv((int)hue, 255.0f, 255.0f);
-				timeDegradationBrushColor = QColor::fromHsv((int)hue, 255.0f, 255.0f);
+				int hue = (int)(240.0f - ((240.0f / (float)m_tracingLength) * i)) & ~7;
+				timeDegradationPenColor = QColor::fromHsv(hue, 255, 255);
+				timeDegradationBrushColor = QColor::fromHsv(hue, 255, 255);
 				timeDegradationPen = QPen(m_penColor, m_penWidth, m_penStyle);
 				timeDegradationBrush = QBrush(timeDegradationBrushColor);
 			}
@@ -376,30 +397,28 @@ void ComponentShape::trace()
 				//orientation line
 				if (m_tracingOrientationLine) {
 					QLineF orientationLine = QLineF();
-					orientationLine.setP1(adjustedHistoryPointDifference);
-					orientationLine.setAngle(historyChild->getDeg());
-					qreal length = (m_w + m_h) / 2 / m_tracerProportions * 3;
+					orientationLine.setP1(historyPoint);
+					orientationLine.setAngle(historyChild->deg);
 					orientationLine.setLength(15);
 
-					QGraphicsLineItem* orientationItem = new QGraphicsLineItem(orientationLine, m_tracingLayer);
+					m_tracingLayer->batch(QPen()).lines.append(orientationLine);
 				}
 
-				createShapeTracer(this->data(1), historyChild, adjustedHistoryPointDifference, timeDegradationPen, timeDegradationBrush);
+				createShapeTracer(historyChild->deg, historyPoint, timeDegradationPen, timeDegradationBrush);
 
 			}
 
 			//PATH
 			else if (m_tracingStyle == "Path") {
 
-				QLineF base = QLineF(lastPointDifference, adjustedHistoryPointDifference);
-				QGraphicsLineItem* lineItem = new QGraphicsLineItem(base, m_tracingLayer);
-				lineItem->setPen(QPen(timeDegradationBrushColor, m_penWidth, m_penStyle));
+				QLineF base = QLineF(lastPoint, historyPoint);
+				m_tracingLayer->batch(QPen(timeDegradationBrushColor, m_penWidth, m_penStyle)).lines.append(base);
 
-				lastPointDifference = adjustedHistoryPointDifference;
+				lastPoint = historyPoint;
 			}
 			//ARROWPATH
 			else if (m_tracingStyle == "ArrowPath") {
-				QLineF base = QLineF(lastPointDifference, adjustedHistoryPointDifference);
+				QLineF base = QLineF(lastPoint, historyPoint);
 
 				int armLength = std::floor(base.length() / 9) + 2;
 
@@ -411,33 +430,47 @@ void ComponentShape::trace()
 				arm1.setLength(armLength);
 				arm1.setAngle(base.angle() - 20);
 
-				QGraphicsLineItem* baseItem = new QGraphicsLineItem(base, m_tracingLayer);
-				baseItem->setPen(QPen(timeDegradationBrushColor, m_penWidth, m_penStyle));
-				QGraphicsLineItem* arm0Item = new QGraphicsLineItem(arm0, m_tracingLayer);
-				arm0Item->setPen(QPen(m_penColor, m_penWidth, m_penStyle));
-				QGraphicsLineItem* arm1Item = new QGraphicsLineItem(arm1, m_tracingLayer);
-				arm1Item->setPen(QPen(m_penColor, m_penWidth, m_penStyle));
+				m_tracingLayer->batch(QPen(timeDegradationBrushColor, m_penWidth, m_penStyle)).lines.append(base);
+				QVector<QLineF>& arms = m_tracingLayer->batch(QPen(m_penColor, m_penWidth, m_penStyle)).lines;
+				arms.append(arm0);
+				arms.append(arm1);
 
-				lastPointDifference = adjustedHistoryPointDifference;
+				lastPoint = historyPoint;
 			}
 
 			//add framenumber to each tracer
 			if (m_tracerFrameNumber) {
 				uint tracerNumber = m_currentFramenumber - i;
-				QFont font = QFont();
-				int fontPixelSize = (int)((m_w + m_h) / 2) * m_tracerProportions * 0.2;
-				font.setPixelSize(fontPixelSize);
-				//font.setBold(true);
-				QGraphicsSimpleTextItem* tracerNumberText = new QGraphicsSimpleTextItem(QString::number(tracerNumber), m_tracingLayer);
-				tracerNumberText->setFont(font);
-				tracerNumberText->setBrush(QBrush(Qt::white)); //sloooow
-				QPen pen = QPen(Qt::black);
-				pen.setWidth(0);
-				tracerNumberText->setPen(pen); //sloooow
-				tracerNumberText->setPos(adjustedHistoryPointDifference + QPointF(-m_w * m_tracerProportions / 3.5f, -m_h * m_tracerProportions / 7));
+				//one outlined text path for all numbers
+				m_tracingLayer->batch(textPen, QBrush(Qt::white)).path.addText(historyPoint + textBaseline, font, QString::number(tracerNumber));
 			}
 		}
 	}
+
+	m_tracingLayer->commitBatches();
+}
+
+void ComponentShape::setLevelOfDetail(bool dots)
+{
+	if (dots == m_dots)
+		return;
+	m_dots = dots;
+	m_rotationHandleLayer->setVisible(!m_dots && m_pRotatable && m_orientationLine);
+	trace();
+	update();
+}
+
+void ComponentShape::cull(uint framenumber)
+{
+	m_currentFramenumber = framenumber;
+	this->hide();
+	m_tracingLayer->hide();
+}
+
+QMutex *ComponentShape::trackingLock()
+{
+	TrackedComponentView *view = dynamic_cast<TrackedComponentView*>(m_parent);
+	return view ? view->getTrackingLock() : nullptr;
 }
 
 IModelTrackedTrajectory * ComponentShape::getTrajectory()
@@ -664,53 +697,33 @@ void ComponentShape::contextMenuEvent(QGraphicsSceneContextMenuEvent * event)
 	QAction *selectedAction = menu.exec(event->screenPos());
 }
 
-void ComponentShape::createShapeTracer(QVariant type, IModelTrackedPoint * historyChild, QPointF pos, QPen pen, QBrush brush)
+void ComponentShape::createShapeTracer(float deg, QPointF pos, QPen pen, QBrush brush)
 {
+	//tracer orientation
+	float tracerOrientation;
+	if (m_h > m_w) { tracerOrientation = -90 - deg; }
+	else { tracerOrientation = -deg; }
+	QTransform transform;
+	transform.translate(pos.x(), pos.y());
+	transform.rotate(tracerOrientation);
+
+	QPainterPath tracer;
 	if (this->data(1) == "point") {
-		QGraphicsEllipseItem* tracePoint = new QGraphicsEllipseItem(m_tracingLayer);
-		tracePoint->setPos(pos);
 		int dim = m_w <= m_h? m_w : m_h;
-
-		tracePoint->setRect(QRect(-dim * m_tracerProportions / 2, -dim * m_tracerProportions / 2, dim * m_tracerProportions, dim * m_tracerProportions));
-		//tracer orientation
-		float tracerOrientation;
-		if (m_h > m_w) { tracerOrientation = -90 - historyChild->getDeg(); }
-		else { tracerOrientation = -historyChild->getDeg(); }
-		tracePoint->setRotation(tracerOrientation);
-		//set colors
-		tracePoint->setPen(pen);
-		tracePoint->setBrush(brush);
-
-		qDebug() << m_tracingLayer->childItems().size();
-
+		tracer.addEllipse(QRect(-dim * m_tracerProportions / 2, -dim * m_tracerProportions / 2, dim * m_tracerProportions, dim * m_tracerProportions));
 	}
 	else if (this->data(1) == "ellipse") {
-		QGraphicsEllipseItem* traceEllipse = new QGraphicsEllipseItem(m_tracingLayer);
-		traceEllipse->setPos(pos);
-		traceEllipse->setRect(QRect(-m_w * m_tracerProportions / 2, -m_h * m_tracerProportions / 2, m_w * m_tracerProportions, m_h * m_tracerProportions));
-		//set orientation
-		float tracerOrientation;
-		if (m_h > m_w) { tracerOrientation = -90 - historyChild->getDeg(); }
-		else { tracerOrientation = -historyChild->getDeg(); }
-		traceEllipse->setRotation(tracerOrientation);
-		//set colors
-		traceEllipse->setPen(pen);
-		traceEllipse->setBrush(brush);
+		tracer.addEllipse(QRect(-m_w * m_tracerProportions / 2, -m_h * m_tracerProportions / 2, m_w * m_tracerProportions, m_h * m_tracerProportions));
 	}
 	else if (this->data(1) == "rectangle") {
-		QGraphicsRectItem* traceRect = new QGraphicsRectItem(m_tracingLayer);
-		traceRect->setPos(pos);
-		traceRect->setRect(QRect(-m_w * m_tracerProportions / 2, -m_h * m_tracerProportions / 2, m_w * m_tracerProportions, m_h * m_tracerProportions));
-		//set orientation
-		float tracerOrientation;
-		if (m_h > m_w) { tracerOrientation = -90 - historyChild->getDeg(); }
-		else { tracerOrientation = -historyChild->getDeg(); }
-		traceRect->setRotation(tracerOrientation);
-		//set colors
-		traceRect->setPen(pen);
-		traceRect->setBrush(brush);
+		tracer.addRect(QRect(-m_w * m_tracerProportions / 2, -m_h * m_tracerProportions / 2, m_w * m_tracerProportions, m_h * m_tracerProportions));
 	}
 	//TODO polygons
+	else {
+		return;
+	}
+
+	m_tracingLayer->batch(pen, brush).path.addPath(transform.map(tracer));
 }
 
 //SLOTS
@@ -838,7 +851,12 @@ void ComponentShape::createInfoWindow()
 	QLinkedList<QPair<QString, QString>> infoList;
 	infoList.append(QPair<QString,QString>("ID", QString::number(m_id)));
 	infoList.append(QPair<QString,QString>("Framenumber", QString::number(m_currentFramenumber)));
-	infoList.append(QPair<QString,QString>("Seen for frames", QString::number(m_trajectory->validCount())));
+	int seen;
+	{
+		QMutexLocker locker(trackingLock());
+		seen = m_trajectory->validCount();
+	}
+	infoList.append(QPair<QString,QString>("Seen for frames", QString::number(seen)));
 	infoList.append(QPair<QString,QString>("Width", QString::number(m_w)));
 	infoList.append(QPair<QString,QString>("Height", QString::number(m_h)));
 	infoList.append(QPair<QString,QString>("Orientation (in Degrees)", QString::number(m_rotation)));
@@ -946,6 +964,7 @@ void ComponentShape::receiveAntialiasing(bool toggle)
 {
 	m_antialiasing = toggle;
 	m_rotationHandle->setAntialiasing(toggle);
+	m_tracingLayer->setAntialiasing(toggle);
 	trace();
 	update();
 }
@@ -1085,6 +1104,7 @@ void ComponentShape::setMembers(CoreParameter* coreParams)
 
 	m_rotationHandle = new RotationHandle(QPoint(m_w / 2, m_h / 2), m_rotationHandleLayer);
 	m_rotationHandle->setAntialiasing(m_antialiasing);
+	m_tracingLayer->setAntialiasing(m_antialiasing);
 	QObject::connect(m_rotationHandle, &RotationHandle::emitShapeRotation, this, &ComponentShape::receiveShapeRotation);
 
 	if (m_pRotatable) {
@@ -9,7 +9,9 @@
 #include "Interfaces/IModel/IModelTrackedTrajectory.h"
 #include "Model/CoreParameter.h"
 #include "QTime"
+#include "QMutex"
 #include "View/Utility/RotationHandle.h"
+#include "View/Utility/ComponentTrail.h"
 
 class ComponentShape : public QGraphicsObject
 {
@@ -35,6 +37,14 @@ class ComponentShape : public QGraphicsObject
 		QPoint getOldPos();
 		void trace();
 		void setMembers(CoreParameter* coreParams);
+		/**
+		 * Draws the shape as a plain dot without orientation line, id and tracing.
+		 */
+		void setLevelOfDetail(bool dots);
+		/**
+		 * Hides a shape outside of the visible area, it is brought up to date once it gets visible again.
+		 */
+		void cull(uint framenumber);
 
 		//public member
 		int m_currentFramenumber;
@@ -42,7 +52,7 @@ class ComponentShape : public QGraphicsObject
 		int m_w;
 		int m_h;
 
-		QGraphicsRectItem* m_tracingLayer;
+		ComponentTrail* m_tracingLayer;
 
 
 	signals:
@@ -100,8 +110,9 @@ class ComponentShape : public QGraphicsObject
 		void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
 		void contextMenuEvent(QGraphicsSceneContextMenuEvent *event) override;
 
-		void createShapeTracer(QVariant type, IModelTrackedPoint* historyChild, QPointF pos, QPen pen, QBrush brush);
+		void createShapeTracer(float deg, QPointF pos, QPen pen, QBrush brush);
 		double constrainAngle(double x);
+		QMutex *trackingLock();
 
 
 	private:
@@ -150,6 +161,7 @@ class ComponentShape : public QGraphicsObject
 		bool m_showId;
 		bool m_trajectoryWasActiveOnce;
 		QPoint m_oldPos;
+		bool m_dots;
 };
 
 
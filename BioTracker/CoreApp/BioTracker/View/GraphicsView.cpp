@@ -16,6 +16,8 @@ GraphicsView::GraphicsView(QWidget *parent, IController *controller, IModel *mod
 	IViewGraphicsView(parent, controller, model)
 {
 	m_GraphicsScene = new QGraphicsScene();
+	//the tracks move every frame, keeping a BSP tree of them up to date costs more than it saves
+	m_GraphicsScene->setItemIndexMethod(QGraphicsScene::NoIndex);
 	m_BackgroundImage = NULL; 
 
 	this->setScene(m_GraphicsScene);
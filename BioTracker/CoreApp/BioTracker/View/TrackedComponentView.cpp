@@ -6,6 +6,8 @@
 #include <QGraphicsSceneHoverEvent>
 #include "QGraphicsScene"
 #include "QGraphicsEllipseItem"
+#include "QGraphicsView"
+#include "QScrollBar"
 
 #include "ComponentShape.h"
 #include "Model/CoreParameter.h"
@@ -30,6 +32,10 @@ TrackedComponentView::TrackedComponentView(QGraphicsItem *parent, IController *c
 	setAcceptDrops(true);
 	_watchingDrag = 0;
 
+	m_scrollUpdate.setSingleShot(true);
+	m_scrollUpdate.setInterval(15);
+	QObject::connect(&m_scrollUpdate, &QTimer::timeout, this, &TrackedComponentView::getNotified);
+
 	m_permissions.insert(std::pair<ENUMS::COREPERMISSIONS, bool>(ENUMS::COREPERMISSIONS::COMPONENTVIEW, true));
 	m_permissions.insert(std::pair<ENUMS::COREPERMISSIONS, bool>(ENUMS::COREPERMISSIONS::COMPONENTADD, true));
 	m_permissions.insert(std::pair<ENUMS::COREPERMISSIONS, bool>(ENUMS::COREPERMISSIONS::COMPONENTMOVE, true));
@@ -59,12 +65,25 @@ void TrackedComponentView::paint(QPainter *painter, const QStyleOptionGraphicsIt
 	}
 }
 
+QMutex *TrackedComponentView::getTrackingLock()
+{
+	ControllerTrackedComponentCore *ctr = dynamic_cast<ControllerTrackedComponentCore*>(getController());
+	return ctr ? ctr->getTrackingLock() : nullptr;
+}
+
 void TrackedComponentView::getNotified()
 {
 	updateShapes(m_currentFrameNumber);
 	update();
 }
 
+void TrackedComponentView::scheduleShapeUpdate()
+{
+	//at most one update per interval while the view is scrolled or zoomed
+	if (!m_scrollUpdate.isActive())
+		m_scrollUpdate.start();
+}
+
 bool TrackedComponentView::sceneEventFilter(QGraphicsItem *watched, QEvent *event) {
 	return true;
 }
@@ -86,6 +105,14 @@ QVariant TrackedComponentView::itemChange(GraphicsItemChange change, const QVari
 {
 	if (change == ItemSceneHasChanged && this->scene()) {
 		createChildShapesAtStart();
+
+		//panning and zooming uncovers culled shapes
+		foreach(QGraphicsView* view, this->scene()->views()) {
+			QObject::connect(view->horizontalScrollBar(), &QScrollBar::valueChanged, this, &TrackedComponentView::scheduleShapeUpdate, Qt::UniqueConnection);
+			QObject::connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &TrackedComponentView::scheduleShapeUpdate, Qt::UniqueConnection);
+			QObject::connect(view->horizontalScrollBar(), &QScrollBar::rangeChanged, this, &TrackedComponentView::scheduleShapeUpdate, Qt::UniqueConnection);
+			QObject::connect(view->verticalScrollBar(), &QScrollBar::rangeChanged, this, &TrackedComponentView::scheduleShapeUpdate, Qt::UniqueConnection);
+		}
 	}
 	return QGraphicsItem::itemChange(change, value);
 }
@@ -131,6 +158,7 @@ void TrackedComponentView::createChildShapesAtStart() {
     assert(this->scene());
 	
 	// create a shape for each model-component upon plugin-init
+	QMutexLocker locker(getTrackingLock());
 	IModelTrackedTrajectory *all = dynamic_cast<IModelTrackedTrajectory *>(getModel());
 	if (all) {
 		for (int i = 0; i < all->size(); i++) {
@@ -167,18 +195,48 @@ void TrackedComponentView::createChildShapesAtStart() {
 void TrackedComponentView::updateShapes(uint framenumber) {
 	m_currentFrameNumber = framenumber;
 
+	QMutexLocker locker(getTrackingLock());
+
 	IModelTrackedTrajectory *all = dynamic_cast<IModelTrackedTrajectory *>(getModel());
 	if (!all)
 		return;
     
+	//the part of the scene that is shown, with a margin so that shapes don't pop up at the border
+	QRectF visibleRect;
+	qreal zoom = 1;
+	if (this->scene()) {
+		foreach(QGraphicsView* view, this->scene()->views()) {
+			visibleRect |= view->mapToScene(view->viewport()->rect()).boundingRect();
+			zoom = view->transform().m11();
+		}
+	}
+	bool cull = !visibleRect.isEmpty();
+	visibleRect = this->mapRectFromScene(visibleRect).marginsAdded(QMarginsF(visibleRect.width() / 10 + 50, visibleRect.height() / 10 + 50, visibleRect.width() / 10 + 50, visibleRect.height() / 10 + 50));
+
+	//level of detail
+	CoreParameter* coreParams = dynamic_cast<CoreParameter*>(dynamic_cast<ControllerTrackedComponentCore*>(getController())->getCoreParameter());
+	bool dots = coreParams && (all->validCount() > coreParams->m_lodTrackCount || zoom < coreParams->m_lodZoom);
+
 	//update each shape; shape deletes itself if trajectory is empty or not existant
-	for (int i = 0; i < this->childItems().size(); i++) {
-		ComponentShape* shape = dynamic_cast<ComponentShape*>(this->childItems()[i]);
-		if (shape) {
-			if (!(shape->updateAttributes(framenumber))) {
-				i--;
+	//iterate over a copy, as shapes may delete themselves
+	QList<QGraphicsItem*> children = this->childItems();
+	foreach(QGraphicsItem* child, children) {
+		ComponentShape* shape = dynamic_cast<ComponentShape*>(child);
+		if (!shape)
+			continue;
+
+		//shapes outside of the view are only hidden, they're updated as soon as they get into view again
+		IModelTrackedTrajectory* trajectory = shape->getTrajectory();
+		if (cull && !shape->isSelected() && trajectory && trajectory->getValid() && trajectory->size() != 0) {
+			IModelTrackedPoint* current = dynamic_cast<IModelTrackedPoint*>(trajectory->getChild(framenumber));
+			if (current && current->getValid() && !visibleRect.contains(QPointF(current->getXpx(), current->getYpx()))) {
+				shape->cull(framenumber);
+				continue;
 			}
 		}
+
+		shape->setLevelOfDetail(dots);
+		shape->updateAttributes(framenumber);
 	}
 	// check for new trajectories; for each create a new shape
 
@@ -482,6 +540,7 @@ void TrackedComponentView::contextMenuEvent(QGraphicsSceneContextMenuEvent * eve
 
 void TrackedComponentView::addTrajectory()
 {
+	QMutexLocker locker(getTrackingLock());
 	IModelTrackedTrajectory *all = dynamic_cast<IModelTrackedTrajectory *>(getModel());
 	int id = -1;
 	if (all) {
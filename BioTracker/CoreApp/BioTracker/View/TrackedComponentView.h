@@ -7,6 +7,7 @@
 #include "Interfaces/ENUMS.h"
 #include "QPoint"
 #include "QSignalMapper"
+#include "QTimer"
 #include "Interfaces/IModel/IModelTrackedTrajectory.h"
 #include "View/ComponentShape.h"
 
@@ -27,6 +28,8 @@ public:
 	void createChildShapesAtStart();
 	void connectShape(ComponentShape* shape);
 	bool checkTrajectory(IModelTrackedTrajectory* trajectory);
+	//held while the shapes read the tracked components; null without a plugin
+	QMutex *getTrackingLock();
 	
 	// IView interface
 	void setPermission(std::pair<ENUMS::COREPERMISSIONS, bool> permission);
@@ -39,6 +42,7 @@ signals:
 	// IViewTrackedComponent interface
 public slots:
 	void getNotified() override;
+	void scheduleShapeUpdate();
 	void rcvDimensionUpdate(int x, int y);
 	// contextmenu actions
 	void addTrajectory();
@@ -113,6 +117,8 @@ protected:
 	bool permissionSwap;
 
 	int m_currentFrameNumber = 0;
+	//collects the scroll and zoom steps into one shape update
+	QTimer m_scrollUpdate;
 	//QGraphicsTextItem* _cursorPosText;
 };
 
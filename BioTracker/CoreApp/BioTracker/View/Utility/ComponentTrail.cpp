@@ -0,0 +1,131 @@
+#include "ComponentTrail.h"
+#include "QPainter"
+#include "Interfaces/IModel/IModelTrackedTrajectory.h"
+#include <algorithm>
+
+
+ComponentTrail::ComponentTrail(QGraphicsItem* parent) :
+	QGraphicsItem(parent),
+	m_trajectory(0),
+	m_newest(-1),
+	m_usedBatches(0),
+	m_antialiasing(false)
+{
+	//clicks go to the shapes below
+	setAcceptedMouseButtons(0);
+}
+
+QRectF ComponentTrail::boundingRect() const
+{
+	return m_bounds;
+}
+
+void ComponentTrail::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
+{
+	Q_UNUSED(option);
+	Q_UNUSED(widget);
+
+	if (m_antialiasing) {
+		painter->setRenderHint(QPainter::Antialiasing);
+	}
+
+	for (size_t i = 0; i < m_usedBatches; i++) {
+		const Batch& b = m_batches[i];
+		painter->setPen(b.pen);
+		painter->setBrush(b.brush);
+		if (!b.lines.isEmpty())
+			painter->drawLines(b.lines);
+		if (!b.path.isEmpty())
+			painter->drawPath(b.path);
+	}
+}
+
+void ComponentTrail::updateHistory(IModelTrackedTrajectory* trajectory, int frame, int length)
+{
+	const int newest = frame - 1;
+	if (length <= 0 || !trajectory) {
+		m_samples.clear();
+		m_trajectory = trajectory;
+		m_newest = newest;
+		return;
+	}
+
+	int first = m_newest + 1;
+	if (trajectory != m_trajectory || length != (int)m_samples.size() || newest <= m_newest || newest - m_newest >= length) {
+		m_samples.assign(length, Sample());
+		first = newest - length + 1;
+	}
+
+	for (int f = std::max(first, 0); f <= newest; f++) {
+		Sample& s = m_samples[f % length];
+		IModelTrackedPoint* child = dynamic_cast<IModelTrackedPoint*>(trajectory->getChild(f));
+		s.valid = child && child->getValid();
+		if (s.valid) {
+			s.pos = QPointF(child->getXpx(), child->getYpx());
+			s.deg = child->getDeg();
+		}
+	}
+	m_trajectory = trajectory;
+	m_newest = newest;
+}
+
+const ComponentTrail::Sample* ComponentTrail::sample(int age) const
+{
+	const int frame = m_newest + 1 - age;
+	if (age < 1 || age > (int)m_samples.size() || frame < 0)
+		return 0;
+	const Sample& s = m_samples[frame % m_samples.size()];
+	return s.valid ? &s : 0;
+}
+
+void ComponentTrail::clearBatches()
+{
+	// keep the batches, so their containers are reused
+	for (size_t i = 0; i < m_usedBatches; i++) {
+		m_batches[i].lines.clear();
+		m_batches[i].path = QPainterPath();
+	}
+	m_usedBatches = 0;
+}
+
+ComponentTrail::Batch& ComponentTrail::batch(const QPen& pen, const QBrush& brush)
+{
+	for (size_t i = 0; i < m_usedBatches; i++) {
+		if (m_batches[i].pen == pen && m_batches[i].brush == brush)
+			return m_batches[i];
+	}
+	if (m_usedBatches == m_batches.size())
+		m_batches.push_back(Batch());
+	Batch& b = m_batches[m_usedBatches++];
+	b.pen = pen;
+	b.brush = brush;
+	//overlapping tracers must not cut holes into each other
+	b.path.setFillRule(Qt::WindingFill);
+	return b;
+}
+
+void ComponentTrail::commitBatches()
+{
+	QRectF bounds;
+	for (size_t i = 0; i < m_usedBatches; i++) {
+		const Batch& b = m_batches[i];
+		QRectF r = b.path.controlPointRect();
+		foreach(const QLineF& l, b.lines) {
+			r |= QRectF(l.p1(), l.p2()).normalized();
+		}
+		const qreal margin = b.pen.widthF() / 2 + 1;
+		bounds |= r.adjusted(-margin, -margin, margin, margin);
+	}
+
+	if (bounds != m_bounds) {
+		prepareGeometryChange();
+		m_bounds = bounds;
+	}
+	update();
+}
+
+void ComponentTrail::setAntialiasing(bool toggle)
+{
+	m_antialiasing = toggle;
+	update();
+}
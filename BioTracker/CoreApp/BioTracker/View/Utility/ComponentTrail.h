@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef COMPONENTTRAIL_H
+#define COMPONENTTRAIL_H
+
+#include "QGraphicsItem"
+#include "QPainterPath"
+#include "QPen"
+#include "QBrush"
+#include "QVector"
+#include <vector>
+
+class IModelTrackedTrajectory;
+
+/**
+ * The tracing of a ComponentShape, drawn as one item in scene coordinates.
+ * The history positions are kept in a ring which only fetches the frames that are new since the last update.
+ * The tracers are collected in batches of equal pen and brush, each painted with one drawLines and one drawPath call.
+ */
+class ComponentTrail : public QGraphicsItem
+{
+	public:
+		struct Sample {
+			QPointF pos;
+			float deg;
+			bool valid;
+			Sample() : deg(0), valid(false) {}
+		};
+
+		struct Batch {
+			QPen pen;
+			QBrush brush;
+			QVector<QLineF> lines;
+			QPainterPath path;
+		};
+
+		ComponentTrail(QGraphicsItem* parent = 0);
+
+		QRectF boundingRect() const override;
+		void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+		/**
+		 * Brings the history up to the given current frame, keeping the length frames before it.
+		 * Moving on by a few frames only fetches those, everything else (the same frame again after an edit,
+		 * seeking, another trajectory or length) fetches all of them.
+		 */
+		void updateHistory(IModelTrackedTrajectory* trajectory, int frame, int length);
+
+		/**
+		 * The sample age frames before the current one, null if outside of the history or not valid.
+		 */
+		const Sample* sample(int age) const;
+
+		/**
+		 * Starts collecting a new set of tracers.
+		 */
+		void clearBatches();
+
+		/**
+		 * The batch for the pen and brush, created if there is none yet.
+		 */
+		Batch& batch(const QPen& pen, const QBrush& brush = QBrush());
+
+		/**
+		 * Done collecting, updates the bounds and repaints.
+		 */
+		void commitBatches();
+
+		void setAntialiasing(bool toggle);
+
+	private:
+		IModelTrackedTrajectory* m_trajectory;
+		std::vector<Sample> m_samples;
+		int m_newest;
+
+		std::vector<Batch> m_batches;
+		size_t m_usedBatches;
+		QRectF m_bounds;
+		bool m_antialiasing;
+};
+
+#endif // COMPONENTTRAIL_H
@@ -1,6 +1,7 @@
 #include <QApplication>
 #include "BioTracker3App.h"
 #include "GuiContext.h"
+#include "BatchTracker.h"
 #include "opencv2/core/core.hpp"
 #include <boost/filesystem.hpp>
 #include "QVector"
@@ -17,8 +18,14 @@
 #endif
 
 int main(int argc, char* argv[]) {
+    //Plugins still build their parameter widgets, so batch runs need a QApplication, but no display
+    bool batch = CLI::isBatchRun(argc, argv);
+    if (batch && qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication app(argc, argv);
-	CLI::optionParser(argc, argv);
+	if (CLI::optionParser(argc, argv) != 0)
+		return 1;
 
     qRegisterMetaType<cv::Mat>("cv::Mat");
     qRegisterMetaType<std::shared_ptr<cv::Mat>>("std::shared_ptr<cv::Mat>");
@@ -36,6 +43,19 @@ int main(int argc, char* argv[]) {
     boost::filesystem::create_directory(boost::filesystem::path(CFG_DIR_TRACKS));
     boost::filesystem::create_directory(boost::filesystem::path(CFG_DIR_SCREENSHOTS));
 
+    if (batch) {
+        boost::filesystem::create_directory(boost::filesystem::path(CFG_DIR_TEMP));
+        BioTracker::Core::Settings *set = BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION);
+        std::string *plugin = (std::string*)(set->readValue("usePlugins"));
+        std::string *video = (std::string*)(set->readValue("video"));
+        if (!plugin || !video) {
+            std::cout << "--batch needs --usePlugin and --video" << std::endl;
+            return 1;
+        }
+        BatchTracker tracker(&app);
+        return tracker.run(*plugin, *video);
+    }
+
     BioTracker3App bioTracker3(&app);
     GuiContext context(&bioTracker3);
     bioTracker3.setBioTrackerContext(&context);
@@ -19,6 +19,26 @@
 
 class CLI {
 public:
+	/**
+	* Checks for --batch before the QApplication is created, as batch runs need the offscreen platform.
+	*/
+	static bool isBatchRun(int ac, char* av[])
+	{
+		for (int i = 1; i < ac; i++) {
+			const std::string arg(av[i]);
+			if (arg == "--batch")
+				return true;
+			//Skip the value of the options taking one, it might read --batch
+			if (arg == "--usePlugin" || arg == "--video")
+				i++;
+		}
+		return false;
+	}
+
+	/**
+	* Parses the options into the settings.
+	* @return 0 on success, 1 if the command line is invalid, the reason is printed
+	*/
 	static int optionParser(int ac, char* av[])
 	{
 
@@ -34,6 +54,7 @@ public:
 				("help", "Produce this help message")
 				("usePlugin", value<std::string>(), "Uses plugin from given filepath")
 				("video", value<std::string>(), "Loads a video from given filepath")
+				("batch", "Tracks the --video (a video file or a directory of images) with the --usePlugin plugin without GUI, writes the tracks and exits")
 				;
 
 			options_description gui("GUI options");
@@ -69,9 +90,17 @@ public:
 				std::string *video = new std::string(s);
 				set->storeValue("video", (void*)video);
 			}
+			if (vm.count("batch")) {
+				if (!vm.count("usePlugin") || !vm.count("video")) {
+					std::cout << "--batch needs --usePlugin and --video" << std::endl;
+					return 1;
+				}
+			}
 		}
 		catch (std::exception& e) {
 			std::cout << e.what() << "\n";
+			return 1;
 		}
+		return 0;
 	}
 };
@@ -0,0 +1,57 @@
+#include "FramePool.h"
+
+std::shared_ptr<FramePool> FramePool::create(int rows, int cols, int type, size_t capacity) {
+	return std::shared_ptr<FramePool>(new FramePool(rows, cols, type, capacity));
+}
+
+FramePool::FramePool(int rows, int cols, int type, size_t capacity) :
+	_created(0),
+	_capacity(capacity > 0 ? capacity : 1),
+	_rows(rows),
+	_cols(cols),
+	_type(type)
+{
+	_free.reserve(_capacity);
+}
+
+FramePool::~FramePool() {
+	for (cv::Mat *m : _free)
+		delete m;
+}
+
+std::shared_ptr<cv::Mat> FramePool::acquire() {
+	cv::Mat *m = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_free.empty()) {
+			m = _free.back();
+			_free.pop_back();
+		}
+		else if (_created < _capacity) {
+			_created++;
+		}
+		else {
+			return nullptr;
+		}
+	}
+	// allocated outside of the lock, this happens only until the pool is filled
+	if (!m)
+		m = new cv::Mat(_rows, _cols, _type);
+
+	std::weak_ptr<FramePool> pool = shared_from_this();
+	return std::shared_ptr<cv::Mat>(m, [pool](cv::Mat *m) {
+		std::shared_ptr<FramePool> p = pool.lock();
+		if (p)
+			p->release(m);
+		else
+			delete m;
+	});
+}
+
+void FramePool::release(cv::Mat *m) {
+	// in case a user replaced the buffer
+	if (!matches(m->rows, m->cols, m->type()))
+		m->create(_rows, _cols, _type);
+	std::lock_guard<std::mutex> lock(_mutex);
+	_free.push_back(m);
+}
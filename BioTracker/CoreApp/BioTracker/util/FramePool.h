@@ -0,0 +1,45 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * A fixed number of equally sized cv::Mat buffers, handed out as shared_ptrs which return their buffer to the pool
+ * when the last user lets go of it. Once all buffers exist acquire() neither allocates nor blocks, and the number
+ * of buffers bounds the memory a slow consumer can pile up.
+ * Buffers still in use when the pool is destroyed are freed by their last user.
+ */
+class FramePool : public std::enable_shared_from_this<FramePool>
+{
+public:
+	static std::shared_ptr<FramePool> create(int rows, int cols, int type, size_t capacity);
+	~FramePool();
+
+	/**
+	 * A free buffer, or nullptr if all of them are in use. The contents are whatever was written last.
+	 */
+	std::shared_ptr<cv::Mat> acquire();
+
+	bool matches(int rows, int cols, int type) const {
+		return rows == _rows && cols == _cols && type == _type;
+	}
+
+	size_t capacity() const {
+		return _capacity;
+	}
+
+private:
+	FramePool(int rows, int cols, int type, size_t capacity);
+	void release(cv::Mat *m);
+
+	std::mutex _mutex;
+	std::vector<cv::Mat *> _free;
+	size_t _created;
+	size_t _capacity;
+	int _rows;
+	int _cols;
+	int _type;
+};
@@ -0,0 +1,273 @@
+#include "PipeEncoder.h"
+
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace {
+#ifdef _WIN32
+	/**
+	 * Quotes an argument the way the C runtime of the started process splits its command line again.
+	 */
+	std::string quoteArgument(const std::string &arg) {
+		if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos)
+			return arg;
+
+		std::string quoted = "\"";
+		size_t backslashes = 0;
+		for (char c : arg) {
+			if (c == '\\') {
+				backslashes++;
+				continue;
+			}
+			// backslashes are only special in front of a quote
+			quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+			backslashes = 0;
+			quoted += c;
+		}
+		// the closing quote must not be escaped
+		quoted.append(backslashes * 2, '\\');
+		quoted += '"';
+		return quoted;
+	}
+#endif
+
+	template<typename T>
+	std::string toString(T value) {
+		std::stringstream ss;
+		ss << value;
+		return ss.str();
+	}
+}
+
+PipeEncoder::PipeEncoder() :
+	_running(false),
+#ifdef _WIN32
+	_stdin(nullptr),
+	_process(nullptr),
+#else
+	_stdin(-1),
+	_pid(-1),
+#endif
+	_width(0),
+	_height(0),
+	_sizeWarned(false)
+{
+}
+
+PipeEncoder::~PipeEncoder() {
+	close();
+}
+
+bool PipeEncoder::open(const std::string &path, int width, int height, double fps, const Config &config) {
+	close();
+
+	_width = width & ~1;
+	_height = height & ~1;
+	_sizeWarned = false;
+	if (_width <= 0 || _height <= 0 || fps <= 0)
+		return false;
+
+	std::vector<std::string> args = {
+		config.executable, "-hide_banner", "-loglevel", "error", "-y",
+		"-f", "rawvideo", "-pix_fmt", "yuv420p", "-s", toString(_width) + "x" + toString(_height),
+		"-framerate", toString(fps), "-i", "-",
+		"-c:v", "libx264", "-preset", config.preset, "-crf", toString(config.crf),
+		"-threads", toString(config.threads)
+	};
+	if (config.segmentSeconds > 0) {
+		const std::string seconds = toString(config.segmentSeconds);
+		args.insert(args.end(), {
+			"-force_key_frames", "expr:gte(t,n_forced*" + seconds + ")",
+			"-f", "segment", "-segment_time", seconds, "-reset_timestamps", "1",
+			path + "_%03d.mkv"
+		});
+	}
+	else {
+		args.push_back(path + ".mkv");
+	}
+
+	if (!startProcess(args)) {
+		std::cout << "Could not start the encoder " << config.executable << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool PipeEncoder::startProcess(const std::vector<std::string> &args) {
+#ifdef _WIN32
+	SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+	HANDLE readEnd;
+	HANDLE writeEnd;
+	if (!CreatePipe(&readEnd, &writeEnd, &sa, 0))
+		return false;
+	// the encoder must not inherit the write end, or it never sees the end of its input
+	SetHandleInformation(writeEnd, HANDLE_FLAG_INHERIT, 0);
+
+	std::string commandLine;
+	for (const std::string &arg : args)
+		commandLine += (commandLine.empty() ? "" : " ") + quoteArgument(arg);
+	std::vector<char> buffer(commandLine.begin(), commandLine.end());
+	buffer.push_back('\0');
+
+	STARTUPINFOA si;
+	ZeroMemory(&si, sizeof(si));
+	si.cb = sizeof(si);
+	si.dwFlags = STARTF_USESTDHANDLES;
+	si.hStdInput = readEnd;
+	si.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+	si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+	PROCESS_INFORMATION pi;
+	const BOOL started = CreateProcessA(nullptr, buffer.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+		nullptr, nullptr, &si, &pi);
+	CloseHandle(readEnd);
+	if (!started) {
+		CloseHandle(writeEnd);
+		return false;
+	}
+	CloseHandle(pi.hThread);
+	_stdin = writeEnd;
+	_process = pi.hProcess;
+#else
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+	// the encoder must not inherit the write end, or it never sees the end of its input
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+	if (fds[0] != STDIN_FILENO)
+		posix_spawn_file_actions_addclose(&actions, fds[0]);
+
+	std::vector<char *> argv;
+	for (const std::string &arg : args)
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	pid_t pid;
+	const int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	::close(fds[0]);
+	if (error != 0) {
+		::close(fds[1]);
+		return false;
+	}
+	_stdin = fds[1];
+	_pid = pid;
+#endif
+	_running = true;
+	return true;
+}
+
+bool PipeEncoder::write(const cv::Mat &frame, int needsConversion) {
+	if (!_running)
+		return false;
+	if (frame.cols < _width || frame.rows < _height) {
+		if (!_sizeWarned) {
+			std::cout << "Frames of " << frame.cols << "x" << frame.rows << " don't fit the recording size of "
+				<< _width << "x" << _height << ", they are not recorded" << std::endl;
+			_sizeWarned = true;
+		}
+		return false;
+	}
+
+	cv::Mat roi = frame(cv::Rect(0, 0, _width, _height));
+	cv::cvtColor(roi, _yuv, needsConversion ? CV_BGRA2YUV_I420 : CV_BGR2YUV_I420);
+
+	if (!writeBytes(reinterpret_cast<const char *>(_yuv.data), _yuv.total() * _yuv.elemSize())) {
+		std::cout << "The encoder process stopped, recording ends here" << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool PipeEncoder::writeBytes(const char *data, size_t size) {
+#ifdef _WIN32
+	while (size > 0) {
+		DWORD written = 0;
+		const DWORD chunk = size > (1u << 30) ? DWORD(1u << 30) : DWORD(size);
+		if (!WriteFile(_stdin, data, chunk, &written, nullptr))
+			return false;
+		data += written;
+		size -= written;
+	}
+	return true;
+#else
+	// A dying encoder must show up as a failed write, not kill the whole application. SIGPIPE is only blocked for
+	// this thread while it writes, and one raised meanwhile is taken before the old mask is restored.
+	sigset_t pipeSignal;
+	sigset_t oldMask;
+	sigemptyset(&pipeSignal);
+	sigaddset(&pipeSignal, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &pipeSignal, &oldMask);
+
+	bool ok = true;
+	while (size > 0) {
+		const ssize_t written = ::write(_stdin, data, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			ok = false;
+			break;
+		}
+		data += written;
+		size -= size_t(written);
+	}
+
+	if (!ok && !sigismember(&oldMask, SIGPIPE)) {
+		sigset_t pending;
+		sigpending(&pending);
+		if (sigismember(&pending, SIGPIPE)) {
+			int sig;
+			sigwait(&pipeSignal, &sig);
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+	return ok;
+#endif
+}
+
+void PipeEncoder::close() {
+	if (!_running)
+		return;
+	_running = false;
+
+	// closing stdin ends the encoder's input, then wait for it to write the trailer
+#ifdef _WIN32
+	CloseHandle(_stdin);
+	WaitForSingleObject(_process, INFINITE);
+	DWORD status = 0;
+	GetExitCodeProcess(_process, &status);
+	CloseHandle(_process);
+	_stdin = nullptr;
+	_process = nullptr;
+#else
+	::close(_stdin);
+	int status = 0;
+	while (waitpid(_pid, &status, 0) < 0 && errno == EINTR) {
+	}
+	_stdin = -1;
+	_pid = -1;
+#endif
+	if (status != 0)
+		std::cout << "The encoder process exited with status " << status << std::endl;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Streams raw frames into an external encoder process (ffmpeg) through a pipe.
+ *
+ * The frames are converted to planar YUV 4:2:0 before writing. That is the encoder's input format anyway and only
+ * half the bytes of BGR, and the conversion runs on OpenCV's vectorized, multi-threaded path while the encoder process
+ * compresses the previous frames on its own threads.
+ * With a segment length set, the encoder starts a new file every that many seconds, each beginning with a keyframe.
+ *
+ * The encoder is started directly with an argument list, no shell is involved, so paths and settings are passed
+ * on as they are.
+ */
+class PipeEncoder
+{
+public:
+	struct Config {
+		std::string executable;
+		std::string preset;
+		int crf;
+		// 0: let the encoder decide
+		int threads;
+		// 0: one file for the whole recording
+		int segmentSeconds;
+	};
+
+	PipeEncoder();
+	~PipeEncoder();
+
+	/**
+	 * Starts the encoder process writing to path, which gets a segment number appended when segments are enabled.
+	 * Odd frame sizes are cropped by one pixel, 4:2:0 needs even ones.
+	 */
+	bool open(const std::string &path, int width, int height, double fps, const Config &config);
+
+	/**
+	 * Writes one BGR (needsConversion 0) or BGRA (needsConversion 1) frame of the size given to open.
+	 * Returns false if the frame was not written: it is smaller than that size, or the encoder process has gone
+	 * away, then isOpened() turns false.
+	 */
+	bool write(const cv::Mat &frame, int needsConversion);
+
+	/**
+	 * Closes the pipe and waits for the encoder to finish the file.
+	 */
+	void close();
+
+	bool isOpened() const {
+		return _running;
+	}
+
+private:
+	bool startProcess(const std::vector<std::string> &args);
+	bool writeBytes(const char *data, size_t size);
+
+	bool _running;
+#ifdef _WIN32
+	// HANDLEs, so windows.h stays out of the header
+	void *_stdin;
+	void *_process;
+#else
+	int _stdin;
+	int _pid;
+#endif
+	int _width;
+	int _height;
+	bool _sizeWarned;
+	cv::Mat _yuv;
+};
@@ -7,62 +7,80 @@
 #include <windows.h>
 #endif
 
-#define mySleep(x) std::this_thread::sleep_for(std::chrono::milliseconds(x));
+FrameQueue::FrameQueue(size_t capacity, Policy policy)
+	: _slots(capacity > 0 ? capacity : 1)
+	, _head(0)
+	, _count(0)
+	, _closed(false)
+	, _policy(policy)
+	, _pushed(0)
+	, _dropped(0) {
+}
 
-void MutexLinkedList::push(std::shared_ptr<ImageBuffer> imbuffer, bool dropFrames) {
+bool FrameQueue::push(const std::shared_ptr<cv::Mat> &img, int needsConversion) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_closed)
+		return false;
+	_pushed++;
 
-	if (dropFrames) {
-		while (images.size() > MAXIMUMQUEUE)
-			pop();
-	}
-	else {
-		while (images.size() > MAXIMUMQUEUE)
-			mySleep(10);
+	bool dropped = false;
+	if (_count == _slots.size()) {
+		if (_policy == DROP_NEWEST) {
+			_dropped++;
+			return false;
+		}
+		else if (_policy == DROP_OLDEST) {
+			_head = (_head + 1) % _slots.size();
+			_count--;
+			_dropped++;
+			dropped = true;
+		}
+		else {
+			_notFull.wait(lock, [this] { return _closed || _count < _slots.size(); });
+			if (_closed)
+				return false;
+		}
 	}
 
-	_Access.lock();
-
-	images.push_back(imbuffer);
-	unsigned long s = images.size();
-	unsigned long w = imbuffer->getWidth();
-	unsigned long h = imbuffer->getHeight();
-	//if (s*w*h / 1024 / 1024 > BUFFER_HARDLIMIT) {
-	//	std::cout << "ERROR: Buffer exceeds hardlimit (" << BUFFER_HARDLIMIT << " MB). Exiting. " << std::endl;
-	//	std::exit(1);
-	//}
-	_Access.unlock();
+	// assigning releases whatever the slot still held, e.g. a dropped frame
+	ImageBuffer &slot = _slots[(_head + _count) % _slots.size()];
+	slot._img = img;
+	slot._needsConversion = needsConversion;
+	_count++;
+	lock.unlock();
+	_notEmpty.notify_one();
+	return !dropped;
 }
 
-std::shared_ptr<ImageBuffer> MutexLinkedList::pop() {
-	_Access.lock();
-	if (images.size()>0) {
-		std::shared_ptr<ImageBuffer> img = images.front();
-		images.pop_front();
-		_Access.unlock();
-		return img;
-	}
-	_Access.unlock();
+bool FrameQueue::pop(ImageBuffer &out) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_notEmpty.wait(lock, [this] { return _closed || _count > 0; });
+	if (_count == 0)
+		return false;
 
-	return std::make_shared<ImageBuffer>();
+	// moved out, so the queue holds no reference to frames the encoder is done with
+	ImageBuffer &slot = _slots[_head];
+	out._img = std::move(slot._img);
+	out._needsConversion = slot._needsConversion;
+	_head = (_head + 1) % _slots.size();
+	_count--;
+	lock.unlock();
+	_notFull.notify_one();
+	return true;
 }
 
-void MutexLinkedList::MutexLinkedList::clear() {
-	_Access.lock();
-	while (images.size()>0) {
-		images.pop_front();
+void FrameQueue::close() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closed = true;
 	}
-	_Access.unlock();
+	_notEmpty.notify_all();
+	_notFull.notify_all();
 }
 
-
-//Simple function to get the current size of the buffer in elements.
-//Locks the data structure.
-int MutexLinkedList::size() {
-	int tsize = 0;
-	_Access.lock();
-	tsize = images.size();
-	_Access.unlock();
-	return tsize;
+size_t FrameQueue::size() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _count;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -71,25 +89,13 @@ void YuvConverter::convert()
 {
 	int w = inImg.size().width;
 	int h = inImg.size().height;
-	unsigned char *prtM = inImg.data;
-	unsigned int stride = 1;
-	//Y
-	int x, y;
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			//This works but is horribly slow!
-			//out0[y * w + x] = inImg.at<cv::Vec3b>(y, x)[0];
-			//out1[y * w + x] = inImg.at<cv::Vec3b>(y, x)[1];
-			//out2[y * w + x] = inImg.at<cv::Vec3b>(y, x)[2];
-			//This works and is quite a bunch faster
-			out0[y * w + x] = (uint8_t)(*prtM);
-			prtM++;
-			out1[y * w + x] = (uint8_t)(*prtM);
-			prtM++;
-			out2[y * w + x] = (uint8_t)(*prtM);
-			prtM++;
-		}
-	}
+	//Deinterleaves the three channels into the planes, split is vectorized
+	cv::Mat planes[3] = {
+		cv::Mat(h, w, CV_8UC1, out0),
+		cv::Mat(h, w, CV_8UC1, out1),
+		cv::Mat(h, w, CV_8UC1, out2)
+	};
+	cv::split(inImg, planes);
 }
 
 void YuvConverter::convert420()
@@ -97,25 +103,17 @@ void YuvConverter::convert420()
 	int w = inImg.size().width;
 	int h = inImg.size().height;
 	unsigned char *prtM = inImg.data;
-	unsigned int stride = 1;
 	//Y
-	int x, y;
-	for (y = 0; y < (h / 3 * 2); y++) {
-		for (x = 0; x < w; x++) {
-			unsigned char ch = (uint8_t)(*prtM);
-			out0[y * w + x] = ch;
-			prtM++;
-		}
-	}
-	
-	for (y = 0; y < (h / 3 * 1); y++) {
-		for (x = 0; x < w/2; x++) {
-			out2[y * w + x] = (uint8_t)(*prtM);
-			prtM++;
-			out1[y * w + x] = (uint8_t)(*prtM);
-			prtM++;
-		}
-	}
+	int yRows = h / 3 * 2;
+	cv::Mat(yRows, w, CV_8UC1, prtM).copyTo(cv::Mat(yRows, w, CV_8UC1, out0));
+	prtM += yRows * w;
+
+	//The chroma bytes alternate between out2 and out1, w / 2 of each per row of w bytes
+	cv::Mat planes[2] = {
+		cv::Mat(h / 3, w / 2, CV_8UC1, out2, w),
+		cv::Mat(h / 3, w / 2, CV_8UC1, out1, w)
+	};
+	cv::split(cv::Mat(h / 3, w / 2, CV_8UC2, prtM), planes);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,34 +125,49 @@ void Worker::run() {
 		unsigned char *o0 = m_nvEncoder->getYuvChannel(0);
 		unsigned char *o1 = m_nvEncoder->getYuvChannel(1);
 		unsigned char *o2 = m_nvEncoder->getYuvChannel(2);
-		std::shared_ptr<ImageBuffer> mat;
-		while (1) {
-			while ((mat = ll.pop())->getWidth() == -1) {
-				mySleep(10);
-				if (m_abort) return;
-			}
-			if (m_abort) return;
-
-			cv::Mat writeMat;
-			cv::cvtColor(*(mat->_img), writeMat, CV_BGR2YUV_I420);//CV_BGR2YUV_I420 //CV_BGR2YUV
-			int chans = writeMat.channels();
+		ImageBuffer mat;
+		cv::Mat writeMat;
+		while (ll.pop(mat)) {
+			cv::cvtColor(*mat._img, writeMat, mat._needsConversion ? CV_BGRA2YUV_I420 : CV_BGR2YUV_I420);//CV_BGR2YUV_I420 //CV_BGR2YUV
+			mat._img.reset();
 			YuvConverter yc(writeMat, o0, o1, o2);
 			yc.convert420();
 			m_nvEncoder->encodeNext();
+			m_encoded++;
 		}
 	}
 	else
 #endif
-	{
-		std::shared_ptr<ImageBuffer> mat;
-		while (1) {
-			while ((mat = ll.pop())->getWidth() == -1) {
-				mySleep(10);
-				if (m_abort) return;
+	if (m_pipeEncoder) {
+		ImageBuffer mat;
+		while (ll.pop(mat)) {
+			bool ok = m_pipeEncoder->write(*mat._img, mat._needsConversion);
+			mat._img.reset();
+			if (ok)
+				m_encoded++;
+			// a frame of the wrong size is only skipped, a failed encoder ends the recording
+			else if (!m_pipeEncoder->isOpened())
+				break;
+		}
+		// nothing takes the frames anymore, release what is still queued
+		ll.close();
+		while (ll.pop(mat))
+			mat._img.reset();
+	}
+	else {
+		ImageBuffer mat;
+		cv::Mat bgr;
+		while (ll.pop(mat)) {
+			if (mat._needsConversion) {
+				cv::cvtColor(*mat._img, bgr, CV_BGRA2BGR);
+				m_vWriter->write(bgr);
 			}
-			if (m_abort) return;
-
-			m_vWriter->write(*mat->_img);
+			else {
+				m_vWriter->write(*mat._img);
+			}
+			// back to its pool right away rather than when the next frame comes in
+			mat._img.reset();
+			m_encoded++;
 		}
 		
 	}
@@ -166,6 +179,9 @@ int VideoCoder::toggle(int w, int h, double fps) {
 	BioTracker::Core::Settings *set = BioTracker::Util::TypedSingleton<BioTracker::Core::Settings>::getInstance(CORE_CONFIGURATION);
 	std::string codecStr = codecList[set->getValueOrDefault<int>(CFG_CODEC, 0)].second;
 	m_dropFrames = set->getValueOrDefault<bool>(CFG_DROPFRAMES, CFG_DROPFRAMES_VAL);
+	m_queueSize = set->getValueOrDefault<int>(CFG_RECORD_QUEUE, CFG_RECORD_QUEUE_VAL);
+	if (m_queueSize < 1)
+		m_queueSize = 1;
 	m_qp = set->getValueOrDefault<int>(CFG_GPU_QP, CFG_GPU_QP_VAL);
     if (fps == -1) {
         fps = m_fps;
@@ -174,7 +190,7 @@ int VideoCoder::toggle(int w, int h, double fps) {
 
 	if (!m_recording)
 	{
-		worker = std::make_shared<Worker>();
+		worker = std::make_shared<Worker>(size_t(m_queueSize), m_dropFrames ? FrameQueue::DROP_OLDEST : FrameQueue::BLOCK);
 
 		//Check which one to use
 		if (codecStr == "X264") {
@@ -205,6 +221,20 @@ int VideoCoder::toggle(int w, int h, double fps) {
 			std::cout << "Video is open:" << m_recording << std::endl;
 #endif
 		}
+		else if (codecStr == "FFMPEG") {
+			PipeEncoder::Config cfg;
+			cfg.executable = set->getValueOrDefault<std::string>(CFG_ENCODER_PATH, CFG_ENCODER_PATH_VAL);
+			cfg.preset = set->getValueOrDefault<std::string>(CFG_ENCODER_PRESET, CFG_ENCODER_PRESET_VAL);
+			cfg.crf = set->getValueOrDefault<int>(CFG_ENCODER_CRF, CFG_ENCODER_CRF_VAL);
+			cfg.threads = set->getValueOrDefault<int>(CFG_ENCODER_THREADS, CFG_ENCODER_THREADS_VAL);
+			cfg.segmentSeconds = 60 * set->getValueOrDefault<int>(CFG_ENCODER_SEGMENT_MINUTES, CFG_ENCODER_SEGMENT_MINUTES_VAL);
+			pipeEncoder = std::make_shared<PipeEncoder>();
+			m_recording = pipeEncoder->open(getTimeAndDate(std::string(CFG_DIR_VIDEOS) + "CameraCapture", ""), w, h, fps, cfg);
+			std::cout << "Video is open:" << m_recording << std::endl;
+			m_recType = 3;
+			int ok = start();
+			m_recording = m_recording && ok == 0;
+		}
 	}
 	else {
 		m_recording = false;
@@ -212,7 +242,10 @@ int VideoCoder::toggle(int w, int h, double fps) {
 			stop();
 		if (m_recType == 2)
 			stop();//vWriter->release();
+		if (m_recType == 3)
+			stop();
 		vWriter = 0;
+		pipeEncoder = 0;
 	}
 	if (!m_recording)
 		m_recType = 0;
@@ -220,7 +253,29 @@ int VideoCoder::toggle(int w, int h, double fps) {
 }
 
 void VideoCoder::add(std::shared_ptr<cv::Mat> m, int needsConversion) {
-	worker->ll.push(std::make_shared<ImageBuffer>(m, needsConversion), m_dropFrames);
+	if (!worker || !m_recording)
+		return;
+	if (!worker->ll.push(m, needsConversion)) {
+		unsigned long long dropped = worker->ll.dropped();
+		if (dropped > 0 && dropped % 100 == 1)
+			std::cout << "VideoCoder: encoder is behind, dropped " << dropped << " frames so far" << std::endl;
+	}
+}
+
+unsigned long long VideoCoder::addedFrames() const {
+	return worker ? worker->ll.pushed() : 0;
+}
+
+unsigned long long VideoCoder::droppedFrames() const {
+	return worker ? worker->ll.dropped() : 0;
+}
+
+size_t VideoCoder::queuedFrames() const {
+	return worker ? worker->ll.size() : 0;
+}
+
+unsigned long long VideoCoder::encodedFrames() const {
+	return worker ? worker->m_encoded.load() : 0;
 }
 
 int VideoCoder::start() {
@@ -238,13 +293,20 @@ int VideoCoder::start() {
 			worker->m_vWriter = vWriter;
 			worker->start();
 		}
+		else if (m_recType == 3) {
+			if (!pipeEncoder->isOpened())
+				return 1;
+			worker->m_pipeEncoder = pipeEncoder;
+			worker->start();
+		}
 
 	return 0;
 }
 
 void VideoCoder::stop() {
 	if (m_recType > 0) {
-		worker->m_abort = true;
+		// the encoder finishes the frames queued so far, then returns
+		worker->ll.close();
 		worker->wait();
 #ifdef WITH_CUDA
 		if (m_nvEncoder)
@@ -252,7 +314,10 @@ void VideoCoder::stop() {
 #endif
 		if (vWriter)
 			vWriter->release();
-		worker->ll.clear();
+		if (pipeEncoder)
+			pipeEncoder->close();
+		std::cout << "Recording stopped: " << encodedFrames() << " frames written, "
+			<< droppedFrames() << " dropped" << std::endl;
 	}
 }
 
@@ -4,9 +4,13 @@
 #include <opencv2/opencv.hpp>
 
 #include <qthread.h>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <vector>
 
 #include "util/misc.h"
+#include "util/PipeEncoder.h"
 #ifdef WITH_CUDA
 #include "EncoderInterface.h"
 #endif
@@ -14,8 +18,6 @@
 #include "settings/Settings.h"
 #include "util/types.h"
 
-#define MAXIMUMQUEUE 30
-
 class YuvConverter
 {
 private:
@@ -37,6 +39,7 @@ public:
 class ImageBuffer {
 public:
 	std::shared_ptr<cv::Mat> _img;
+	// 0: BGR, 1: BGRA (scene captures), converted by the worker thread
 	int _needsConversion;
 
 	ImageBuffer(std::shared_ptr<cv::Mat> pimg, int ncv) : _img(pimg), _needsConversion(ncv) {
@@ -57,24 +60,58 @@ public:
 	}
 };
 
-class MutexLinkedList {
+/**
+ * Bounded ring of frames between one producer (the player or capture thread) and the encoder thread.
+ * The slots are allocated once, so queueing a frame neither allocates nor sleeps; the encoder is woken
+ * through a condition variable instead of polling.
+ *
+ * What happens when the encoder falls behind and the ring is full depends on the policy:
+ * BLOCK waits for a free slot (backpressure on the producer, no frame is lost),
+ * DROP_OLDEST replaces the oldest queued frame and DROP_NEWEST discards the frame being pushed.
+ */
+class FrameQueue {
 public:
-	std::list<std::shared_ptr<ImageBuffer>> images;
-	std::mutex _Access;
+	enum Policy {
+		BLOCK = 0,
+		DROP_OLDEST = 1,
+		DROP_NEWEST = 2
+	};
 
-    void push(std::shared_ptr<ImageBuffer> imbuffer, bool dropFrames = false);
+	FrameQueue(size_t capacity, Policy policy);
 
-    std::shared_ptr<ImageBuffer> pop();
+	/**
+	 * Producer: queues a frame. Returns false if a frame was dropped or the queue is closed.
+	 */
+	bool push(const std::shared_ptr<cv::Mat> &img, int needsConversion);
 
-    void clear();
+	/**
+	 * Consumer: blocks until a frame is queued and moves it into out.
+	 * Returns false once the queue is closed and all frames before that are taken.
+	 */
+	bool pop(ImageBuffer &out);
 
+	/**
+	 * Wakes both sides. push refuses further frames, pop still hands out what is queued.
+	 */
+	void close();
 
-	//Simple function to get the current size of the buffer in elements.
-	//Locks the data structure.
-	virtual int size();
+	size_t size();
+	unsigned long long pushed() const { return _pushed; }
+	unsigned long long dropped() const { return _dropped; }
 
-    MutexLinkedList() {}
-    ~MutexLinkedList() {}
+private:
+	std::vector<ImageBuffer> _slots;
+	size_t _head;
+	size_t _count;
+	bool _closed;
+	Policy _policy;
+
+	std::mutex _mutex;
+	std::condition_variable _notEmpty;
+	std::condition_variable _notFull;
+
+	std::atomic<unsigned long long> _pushed;
+	std::atomic<unsigned long long> _dropped;
 };
 
 class Worker : public QThread
@@ -82,15 +119,15 @@ class Worker : public QThread
 	Q_OBJECT
 
 public:
-	MutexLinkedList ll;
-	bool m_abort;
+	FrameQueue ll;
+	std::atomic<unsigned long long> m_encoded;
 #ifdef WITH_CUDA
 	std::shared_ptr<EncoderInterface> m_nvEncoder;
 #endif
 	std::shared_ptr<cv::VideoWriter> m_vWriter;
+	std::shared_ptr<PipeEncoder> m_pipeEncoder;
 
-	Worker() {
-		m_abort = false;
+	Worker(size_t queueSize, FrameQueue::Policy policy) : ll(queueSize, policy), m_encoded(0) {
 	};
 	void run();
 
@@ -112,6 +149,7 @@ public:
 		m_recType = 0;
 		m_recording = false;
 		m_dropFrames = false;
+		m_queueSize = CFG_RECORD_QUEUE_VAL;
         m_fps = fps;
 	}
 
@@ -124,8 +162,19 @@ public:
 
 	int toggle(int w, int h, double fps = -1);
 
+	/**
+	 * Queues a frame for the encoder thread, see FrameQueue for what happens when it is behind.
+	 * The frame must not be written to afterwards; the queue only keeps a reference.
+	 */
 	void add(std::shared_ptr<cv::Mat> m, int needsConversion = 0);
 
+	//Counters of the current recording: frames handed to add(), dropped because the encoder was behind,
+	//waiting in the queue, and written to the file.
+	unsigned long long addedFrames() const;
+	unsigned long long droppedFrames() const;
+	size_t queuedFrames() const;
+	unsigned long long encodedFrames() const;
+
 	int start();
 	void stop();
 #ifdef WITH_CUDA
@@ -136,9 +185,11 @@ private:
 
 	std::shared_ptr<Worker> worker;
 	std::shared_ptr<cv::VideoWriter> vWriter;
+	std::shared_ptr<PipeEncoder> pipeEncoder;
 	int m_recType;
 	int m_recording;
 	bool m_dropFrames;
+	int m_queueSize;
 	int m_qp;
     double m_fps;
 signals:
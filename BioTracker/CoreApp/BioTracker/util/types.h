@@ -8,6 +8,8 @@
 #define CFG_CODEC							"BiotrackerCore/CodecUsed"
 #define CFG_DROPFRAMES						"BiotrackerCore/DropFrames"
 #define CFG_DROPFRAMES_VAL					false
+#define CFG_RECORD_QUEUE					"BiotrackerCore/RecordQueueFrames"
+#define CFG_RECORD_QUEUE_VAL				30
 #define CFG_RECORDSCALEDOUT					"BiotrackerCore/RecordScaledOutput"
 #define CFG_EXPORTER						"BiotrackerCore/DataExporter"
 #define CFG_RECORD_FPS						"BiotrackerCore/Record_FPS"
@@ -16,10 +18,38 @@
 #define CFG_CAMERA_DEFAULT_W_VAL			-1
 #define CFG_CAMERA_DEFAULT_H				"BiotrackerCore/CameraHeight"
 #define CFG_CAMERA_DEFAULT_H_VAL			-1
+#define CFG_CAMERA_QUEUE					"BiotrackerCore/CameraQueueFrames"
+#define CFG_CAMERA_QUEUE_VAL				1
+#define CFG_CAMERA_DROP_POLICY				"BiotrackerCore/CameraDropPolicy"
+#define CFG_CAMERA_DROP_POLICY_VAL			0
 #define CFG_INPUT_FRAME_STRIDE				"BiotrackerCore/FrameStride"
 #define CFG_INPUT_FRAME_STRIDE_VAL			1
+#define CFG_ADAPTIVE_STRIDE					"BiotrackerCore/AdaptiveStride"
+#define CFG_ADAPTIVE_STRIDE_VAL				false
+#define CFG_ADAPTIVE_STRIDE_MAX				"BiotrackerCore/AdaptiveStrideMax"
+#define CFG_ADAPTIVE_STRIDE_MAX_VAL			8
+#define CFG_DECODE_AHEAD					"BiotrackerCore/DecodeAheadFrames"
+#define CFG_DECODE_AHEAD_VAL				0
+#define CFG_SEEK_CACHE						"BiotrackerCore/SeekCacheFrames"
+#define CFG_SEEK_CACHE_VAL					16
+#define CFG_PREFETCH_THREADS				"BiotrackerCore/ImagePrefetchThreads"
+#define CFG_PREFETCH_THREADS_VAL			0
+#define CFG_PREFETCH_FRAMES					"BiotrackerCore/ImagePrefetchFrames"
+#define CFG_PREFETCH_FRAMES_VAL				8
+#define CFG_PIPELINE_DEPTH					"BiotrackerCore/PipelineDepth"
+#define CFG_PIPELINE_DEPTH_VAL				2
 #define CFG_GPU_QP							"BiotrackerCore/GPU_QP"
 #define CFG_GPU_QP_VAL						15
+#define CFG_ENCODER_PATH					"BiotrackerCore/EncoderExecutable"
+#define CFG_ENCODER_PATH_VAL				"ffmpeg"
+#define CFG_ENCODER_PRESET					"BiotrackerCore/EncoderPreset"
+#define CFG_ENCODER_PRESET_VAL				"veryfast"
+#define CFG_ENCODER_CRF						"BiotrackerCore/EncoderCRF"
+#define CFG_ENCODER_CRF_VAL					20
+#define CFG_ENCODER_THREADS					"BiotrackerCore/EncoderThreads"
+#define CFG_ENCODER_THREADS_VAL				0
+#define CFG_ENCODER_SEGMENT_MINUTES			"BiotrackerCore/EncoderSegmentMinutes"
+#define CFG_ENCODER_SEGMENT_MINUTES_VAL		0
 #define CFG_SER_CSVSEP						"Serializers/CSV_SEPARATOR"
 #define CFG_SER_CSVSEP_VAL					";"
 
@@ -59,8 +89,9 @@ namespace AREADESCRIPTOR
 const std::vector<std::pair<std::string, std::string>> codecList = {
 	std::pair<std::string, std::string>("X264 (CPU)", "X264"),
 #ifdef WITH_CUDA
-	std::pair<std::string, std::string>("X264 (GPU)", "X264GPU")
+	std::pair<std::string, std::string>("X264 (GPU)", "X264GPU"),
 #endif
+	std::pair<std::string, std::string>("X264 (ffmpeg process)", "FFMPEG")
 };
 
 const std::vector<std::string> exporterList = {
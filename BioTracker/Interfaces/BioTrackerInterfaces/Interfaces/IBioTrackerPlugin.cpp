@@ -6,4 +6,7 @@ IModel *IBioTrackerPlugin::getTrackerComponentModel() { return nullptr; };
 void IBioTrackerPlugin::sendCorePermissions() { return; };
 IModelTrackedComponentFactory *IBioTrackerPlugin::getComponentFactory() { return nullptr; };
 void IBioTrackerPlugin::connectInterfaces() { return; };
-void IBioTrackerPlugin::receiveAreaDescriptor(IModelAreaDescriptor *areaDescr) { return; };
\ No newline at end of file
+void IBioTrackerPlugin::receiveAreaDescriptor(IModelAreaDescriptor *areaDescr) { return; };
+void IBioTrackerPlugin::receiveCapturedFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber, qint64 captureTimeUs, quint64 sequence) {
+	receiveCurrentFrameFromMainApp(mat, frameNumber);
+};
\ No newline at end of file
@@ -36,6 +36,12 @@ Q_SIGNALS:
 
 public Q_SLOTS:
     virtual void receiveCurrentFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber) = 0;
+    /**
+     * Like receiveCurrentFrameFromMainApp, with the time the frame was captured in microseconds since the epoch (0 if
+     * unknown, e.g. for files) and its capture sequence number (gaps are frames dropped before tracking).
+     * The default ignores both and calls receiveCurrentFrameFromMainApp.
+     */
+    virtual void receiveCapturedFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber, qint64 captureTimeUs, quint64 sequence);
 	virtual void receiveAreaDescriptor(IModelAreaDescriptor *areaDescr);
 
 //private Q_SLOTS:
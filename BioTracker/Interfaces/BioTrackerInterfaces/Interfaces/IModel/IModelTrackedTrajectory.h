@@ -2,6 +2,28 @@
 #define ITRACKEDOTRAJECTORY_H
 
 #include "Interfaces/IModel/IModelTrackedComponent.h"
+#include <memory>
+
+/**
+ * Storage of the elements of one trajectory, e.g. a track of a memory-mapped file, which a trajectory can read
+ * its elements from on demand instead of getting them all added on load.
+ */
+class IModelTrackedElementSource
+{
+public:
+	virtual ~IModelTrackedElementSource() {}
+
+	/**
+	 * One past the highest frame the source may have an element for.
+	 */
+	virtual int frameEnd() = 0;
+
+	/**
+	 * Copies the stored properties of the element at the frame into comp.
+	 * @return false if there is no element at the frame.
+	 */
+	virtual bool readElement(int frame, IModelTrackedComponent *comp) = 0;
+};
 
 /**
  * This interface class derives from IModelTrackedComponent.
@@ -51,6 +73,12 @@ public:
 
 	virtual int validCount() = 0;
 
+	/**
+	 * Lets the trajectory read its elements from the source when they are first accessed.
+	 * The default doesn't support this and returns false, the caller has to add the elements then.
+	 */
+	virtual bool setElementSource(std::shared_ptr<IModelTrackedElementSource> source) { return false; };
+
 
 	/**
 	* This shoudd simply return a last child object (highest index).
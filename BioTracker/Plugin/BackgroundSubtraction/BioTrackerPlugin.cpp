@@ -81,7 +81,11 @@ void BioTrackerPlugin::receiveAreaDescriptor(IModelAreaDescriptor *areaDescr) {
 }
 
 void BioTrackerPlugin::receiveCurrentFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber) {
-	qobject_cast<ControllerTrackingAlgorithm*> (m_TrackerController)->doTracking(mat, frameNumber);
+	receiveCapturedFrameFromMainApp(mat, frameNumber, 0, 0);
+}
+
+void BioTrackerPlugin::receiveCapturedFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber, qint64 captureTimeUs, quint64 sequence) {
+	qobject_cast<ControllerTrackingAlgorithm*> (m_TrackerController)->doTracking(mat, frameNumber, captureTimeUs, sequence);
 
 	Q_EMIT emitCurrentFrameNumber(frameNumber);
 }
@@ -29,6 +29,7 @@ class BIOTRACKERPLUGINSHARED_EXPORT BioTrackerPlugin : public IBioTrackerPlugin
   public:
 	void createPlugin();
 	void receiveCurrentFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber);
+	void receiveCapturedFrameFromMainApp(std::shared_ptr<cv::Mat> mat, uint frameNumber, qint64 captureTimeUs, quint64 sequence);
 	void sendCorePermissions();
 
   private:
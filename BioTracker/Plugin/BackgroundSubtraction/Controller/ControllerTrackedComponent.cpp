@@ -86,19 +86,14 @@ void ControllerTrackedComponent::receiveAddTrajectory(QPoint position)
 	cv::Point2f newPosCm = m_areaDescr->pxToCm(newPosPx);
 
 	TrackedTrajectory* newTraj = new TrackedTrajectory();
-	TrackedElement* firstElem = new TrackedElement(newTraj, "n.a.", newTraj->getId());
 
 	FishPose newPose = FishPose(newPosCm, newPosPx, 0, 0, 20, 20, 0.0);
 
-	firstElem->setFishPose(newPose);
-
-
-	firstElem->setTime(start);
-	newTraj->add(firstElem, m_currentFrameNumber);
+	newTraj->addPose(newPose, start, m_currentFrameNumber);
 	TrackedTrajectory* allTraj = qobject_cast<TrackedTrajectory*>(m_Model);
 	if (allTraj) {
 		allTraj->add(newTraj);
-		qDebug() << "TRACKER: Trajectory added at" << firstElem->getXpx() << "," << firstElem->getYpx();
+		qDebug() << "TRACKER: Trajectory added at" << newPosPx.x << "," << newPosPx.y;
 	}
 }
 
@@ -19,9 +19,11 @@ void ControllerTrackingAlgorithm::connectControllerToController()
 	m_TrackedTrajectoryMajor = ctrComponent->getModel();
 }
 
-void ControllerTrackingAlgorithm::doTracking(std::shared_ptr<cv::Mat> mat, uint number)
+void ControllerTrackingAlgorithm::doTracking(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs, quint64 sequence)
 {
-    qobject_cast<BioTrackerTrackingAlgorithm *>(m_Model)->doTracking(mat, number);
+    BioTrackerTrackingAlgorithm *algorithm = qobject_cast<BioTrackerTrackingAlgorithm *>(m_Model);
+    algorithm->setCaptureTime(captureTimeUs, sequence);
+    algorithm->doTracking(mat, number);
 }
 
 IView *ControllerTrackingAlgorithm::getTrackingParameterWidget()
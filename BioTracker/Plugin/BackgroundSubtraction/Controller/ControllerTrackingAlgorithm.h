@@ -17,7 +17,7 @@ public:
 public:
     void connectControllerToController() override;
 
-    void doTracking(std::shared_ptr<cv::Mat> mat, uint number);
+    void doTracking(std::shared_ptr<cv::Mat> mat, uint number, qint64 captureTimeUs = 0, quint64 sequence = 0);
 
     IView *getTrackingParameterWidget();
 
@@ -14,25 +14,48 @@ BioTrackerTrackingAlgorithm::BioTrackerTrackingAlgorithm(IModel *parameter, IMod
 	 
 	_noFish = -1;
 
+	_listener = nullptr;
+	_networkThread = nullptr;
 	if (set->getValueOrDefault<bool>(FISHTANKPARAM::FISHTANK_ENABLE_NETWORKING, false)) {
-		_listener = new TcpListener(this);
-		_listener->listen(QHostAddress::Any, set->getValueOrDefault<int>(FISHTANKPARAM::FISHTANK_NETWORKING_PORT, 54444));
-		QObject::connect(_listener, SIGNAL(newConnection()), _listener, SLOT(acceptConnection()));
+		TcpListener::Protocol protocol = TcpListener::Protocol(set->getValueOrDefault<int>(FISHTANKPARAM::FISHTANK_NETWORKING_PROTOCOL, TcpListener::PROTOCOL_TEXT));
+		int port = set->getValueOrDefault<int>(FISHTANKPARAM::FISHTANK_NETWORKING_PORT, 54444);
+
+		//The listener lives in a thread of its own, so clients never hold up tracking
+		_networkThread = new QThread(this);
+		_listener = new TcpListener(nullptr, protocol);
+		_listener->moveToThread(_networkThread);
+		QObject::connect(_networkThread, &QThread::finished, _listener, &QObject::deleteLater);
+		_networkThread->start();
+		QMetaObject::invokeMethod(_listener, "startListening", Qt::QueuedConnection, Q_ARG(int, port));
+	}
+
+	if (set->getValueOrDefault<bool>(FISHTANKPARAM::FISHTANK_ENABLE_SHAREDMEMORY, false)) {
+		std::string name = set->getValueOrDefault<std::string>(FISHTANKPARAM::FISHTANK_SHAREDMEMORY_NAME, "biotracker");
+		_sharedMemory.reset(new SharedMemoryPublisher(name));
 	}
 
 
     _lastImage = nullptr;
     _lastFramenumber = -1;
+	_captureTimeUs = 0;
+	_captureSequence = 0;
+	_skippedCaptures = 0;
 }
 
 
 void BioTrackerTrackingAlgorithm::receiveAreaDescriptorUpdate(IModelAreaDescriptor *areaDescr) {
 	_AreaInfo = areaDescr;
 	_bd.setAreaInfo(_AreaInfo);
+	_sbd.setAreaInfo(_AreaInfo);
+	_cbd.setAreaInfo(_AreaInfo);
 }
 
 BioTrackerTrackingAlgorithm::~BioTrackerTrackingAlgorithm()
 {
+	if (_networkThread) {
+		_networkThread->quit();
+		_networkThread->wait();
+	}
 }
 
 std::vector<FishPose> BioTrackerTrackingAlgorithm::getLastPositionsAsPose() {
@@ -44,8 +67,7 @@ std::vector<FishPose> BioTrackerTrackingAlgorithm::getLastPositionsAsPose() {
 	for (int i = 0; i < _TrackedTrajectoryMajor->size(); i++) {
 		TrackedTrajectory *t = dynamic_cast<TrackedTrajectory *>(_TrackedTrajectoryMajor->getChild(i));
 		if (t && t->getValid() && !t->getFixed()) {
-			TrackedElement *e = (TrackedElement *)t->getLastChild();
-			last.push_back(e->getFishPose());
+			last.push_back(t->getFishPose(t->size() - 1));
 		}
 	}
 	return last;
@@ -61,42 +83,47 @@ void BioTrackerTrackingAlgorithm::receiveParametersChanged() {
     }
 }
 
-void BioTrackerTrackingAlgorithm::sendSelectedImage(std::map<std::string, std::shared_ptr<cv::Mat>> *images) {
+void BioTrackerTrackingAlgorithm::sendSelectedImage(int selection, std::shared_ptr<cv::Mat> image) {
 
-    std::shared_ptr<cv::Mat> sendImage;
+    QString name;
     //Send forth whatever the user selected
-    switch (_TrackingParameter->getSendImage()) {
-    case 0: //Send none
-            //sendImage = images.find(std::string("Original"))->second;
-            //Q_EMIT emitCvMatA(sendImage, QString("Original"));
+    switch (selection) {
+    case ImagePreProcessor::IMAGE_NONE:
         Q_EMIT emitChangeDisplayImage("Original");
+        return;
+    case ImagePreProcessor::IMAGE_BINARIZED:
+        name = QString("Binarized");
         break;
-    case 1:
-        sendImage = images->find(std::string("Binarized"))->second;
-        Q_EMIT emitCvMatA(sendImage, QString("Binarized"));
-        Q_EMIT emitChangeDisplayImage(QString("Binarized"));
+    case ImagePreProcessor::IMAGE_ERODED:
+        name = QString("Eroded");
         break;
-    case 2:
-        sendImage = images->find(std::string("Eroded"))->second;
-        Q_EMIT emitCvMatA(sendImage, QString("Eroded"));
-        Q_EMIT emitChangeDisplayImage(QString("Eroded"));
+    case ImagePreProcessor::IMAGE_DILATED:
+        name = QString("Dilated");
         break;
-    case 3:
-        sendImage = images->find(std::string("Dilated"))->second;
-        Q_EMIT emitCvMatA(sendImage, QString("Dilated"));
-        Q_EMIT emitChangeDisplayImage(QString("Dilated"));
+    case ImagePreProcessor::IMAGE_DIFFERENCE:
+        name = QString("Difference");
         break;
-    case 4:
-        sendImage = images->find(std::string("Difference"))->second;
-        Q_EMIT emitCvMatA(sendImage, QString("Difference"));
-        Q_EMIT emitChangeDisplayImage(QString("Difference"));
-        break;
-    case 5:
-        sendImage = images->find(std::string("Background"))->second;
-        Q_EMIT emitCvMatA(sendImage, QString("Background"));
-        Q_EMIT emitChangeDisplayImage(QString("Background"));
+    case ImagePreProcessor::IMAGE_BACKGROUND:
+        name = QString("Background");
         break;
+    default:
+        return;
     }
+    if (image)
+        Q_EMIT emitCvMatA(image, name);
+    Q_EMIT emitChangeDisplayImage(name);
+}
+
+void BioTrackerTrackingAlgorithm::setCaptureTime(qint64 captureTimeUs, quint64 sequence)
+{
+	if (sequence > 0 && _captureSequence > 0 && sequence > _captureSequence + 1) {
+		const quint64 before = _skippedCaptures;
+		_skippedCaptures += sequence - _captureSequence - 1;
+		if (before / 100 != _skippedCaptures / 100)
+			qWarning() << "Tracking is behind the camera, skipped" << _skippedCaptures << "frames so far";
+	}
+	_captureTimeUs = captureTimeUs;
+	_captureSequence = sequence;
 }
 
 void BioTrackerTrackingAlgorithm::doTracking(std::shared_ptr<cv::Mat> p_image, uint framenumber)
@@ -116,7 +143,10 @@ void BioTrackerTrackingAlgorithm::doTracking(std::shared_ptr<cv::Mat> p_image, u
 		Q_EMIT emitDimensionUpdate(_imageX, _imageY);
 	}
 
-	std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+	//Camera frames carry the time they were grabbed, everything else is stamped with the time of tracking
+	std::chrono::system_clock::time_point start = _captureTimeUs > 0
+		? std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(_captureTimeUs)))
+		: std::chrono::system_clock::now();
 
 	//Refuse to run tracking if we have no area info...
 	if (_AreaInfo == nullptr) {
@@ -136,21 +166,38 @@ void BioTrackerTrackingAlgorithm::doTracking(std::shared_ptr<cv::Mat> p_image, u
         _ipp.resetBackgroundImage();
     }
 
-	//Do the preprocessing
-	std::map<std::string, std::shared_ptr<cv::Mat>> images = _ipp.preProcess(p_image);
-	std::shared_ptr<cv::Mat> dilated = images.find(std::string("Dilated"))->second;
-	std::shared_ptr<cv::Mat> greyMat = images.find(std::string("Greyscale"))->second;
+	//Do the preprocessing, only materializing the intermediate image the user wants to see
+	int sendImage = _TrackingParameter->getSendImage();
+	ImagePreProcessor::PreProcessedImages images = _ipp.preProcess(p_image, sendImage);
+	std::shared_ptr<cv::Mat> dilated = images.foreground;
+	std::shared_ptr<cv::Mat> greyMat = images.greyscale;
 
 	//Find blobs via ellipsefitting
-	_bd.setMaxBlobSize(_TrackingParameter->getMaxBlobSize());
-	_bd.setMinBlobSize(_TrackingParameter->getMinBlobSize());
-	std::vector<BlobPose> blobs = _bd.getPoses(*dilated, *greyMat);
+	std::vector<BlobPose> blobs;
+	switch (_TrackingParameter->getBlobDetector()) {
+	case TrackerParameter::BLOB_DETECTOR_SIMPLE:
+		_sbd.setDouble("1", _TrackingParameter->getMinBlobSize());
+		_sbd.setDouble("999999", _TrackingParameter->getMaxBlobSize());
+		blobs = _sbd.getPoses(*dilated, *greyMat);
+		break;
+	case TrackerParameter::BLOB_DETECTOR_COMPONENTS:
+		_cbd.setMaxBlobSize(_TrackingParameter->getMaxBlobSize());
+		_cbd.setMinBlobSize(_TrackingParameter->getMinBlobSize());
+		blobs = _cbd.getPoses(*dilated, *greyMat);
+		break;
+	default:
+		_bd.setMaxBlobSize(_TrackingParameter->getMaxBlobSize());
+		_bd.setMinBlobSize(_TrackingParameter->getMinBlobSize());
+		blobs = _bd.getPoses(*dilated, *greyMat);
+		break;
+	}
 
 	// Never switch the position of the trajectories. The NN2d mapper relies on this!
 	// If you mess up the order, add or remove some t, then create a new mapper. 
 	std::vector<FishPose> fish = getLastPositionsAsPose();
 	
 	//Find new positions using 2D nearest neighbour
+	_nn2d->setMaxDistance(_TrackingParameter->getMaxAssignmentDistance());
 	std::tuple<std::vector<FishPose>, std::vector<float>> poses = _nn2d->getNewPoses(_TrackedTrajectoryMajor, framenumber, blobs);
 
 	//Insert new poses into data structure
@@ -158,22 +205,23 @@ void BioTrackerTrackingAlgorithm::doTracking(std::shared_ptr<cv::Mat> p_image, u
 	for (int i = 0; i < _TrackedTrajectoryMajor->size(); i++) {
 		TrackedTrajectory *t = dynamic_cast<TrackedTrajectory *>(_TrackedTrajectoryMajor->getChild(i));
 		if (t && t->getValid() && !t->getFixed()) {
-			TrackedElement *e = new TrackedElement(t, "n.a.", t->getId());
-
-			e->setFishPose(std::get<0>(poses)[trajNumber]);
-			e->setTime(start);
-			t->add(e, framenumber);
+			t->addPose(std::get<0>(poses)[trajNumber], start, framenumber);
 			trajNumber++;
 		}
 	}
 
 	//Send forth new positions to the robotracker, if networking is enabled
-	if (_TrackingParameter->getDoNetwork()){ 
+	if (_TrackingParameter->getDoNetwork() && _listener){ 
 		std::vector<FishPose> ps = std::get<0>(poses);
 		_listener->sendPositions(framenumber, ps, std::vector<cv::Point2f>(), start);
 	}
 
-    sendSelectedImage(&images);
+	//Publish the frame and positions to processes on this host
+	if (_sharedMemory) {
+		_sharedMemory->publish(framenumber, *p_image, std::get<0>(poses), start);
+	}
+
+    sendSelectedImage(sendImage, images.selected);
 
 	//First the user still wants to see the original image, right?
 	if (framenumber==1) {
@@ -12,12 +12,15 @@
 #include "Model/TrackedComponents/TrackedElement.h"
 #include "Model/TrackedComponents/TrackedTrajectory.h"
 #include "Model/TrackingAlgorithm/imageProcessor/detector/blob/cvBlob/BlobsDetector.h"
+#include "Model/TrackingAlgorithm/imageProcessor/detector/blob/simpleBlob/SimpleBlobsDetector.h"
+#include "Model/TrackingAlgorithm/imageProcessor/detector/blob/componentBlob/ComponentBlobsDetector.h"
 #include "Model/TrackingAlgorithm/imageProcessor/preprocessor/ImagePreProcessor.h"
 #include "Model/TrackingAlgorithm/NN2dMapper.h"
 #include "Interfaces/IModel/IModelAreaDescriptor.h"
 #include <iostream>
 
 #include "Model/Network/TcpListener.h"
+#include "Model/Network/SharedMemoryPublisher.h"
 
 class BioTrackerTrackingAlgorithm : public IModelTrackingAlgorithm
 {
@@ -34,12 +37,17 @@ Q_SIGNALS:
     // ITrackingAlgorithm interface
 public Q_SLOTS:
 	void doTracking(std::shared_ptr<cv::Mat> image, uint framenumber) override;
+	/**
+	 * Sets when the next image to track was captured, in us since the epoch (0: unknown) and its capture sequence number.
+	 * Tracked poses get the capture time instead of the time of tracking.
+	 */
+	void setCaptureTime(qint64 captureTimeUs, quint64 sequence);
 	void receiveAreaDescriptorUpdate(IModelAreaDescriptor *areaDescr);
     void receiveParametersChanged();
 
 private:
 	void refreshPolygon();
-    void sendSelectedImage(std::map<std::string, std::shared_ptr<cv::Mat>>* images);
+    void sendSelectedImage(int selection, std::shared_ptr<cv::Mat> image);
 
 	std::vector<FishPose> getLastPositionsAsPose();
 
@@ -48,9 +56,13 @@ private:
 	IModelAreaDescriptor* _AreaInfo;
 
 	TcpListener* _listener;
+	QThread* _networkThread;
+	std::unique_ptr<SharedMemoryPublisher> _sharedMemory;
 
 	ImagePreProcessor _ipp;
 	BlobsDetector _bd;
+	SimpleBlobsDetector _sbd;
+	ComponentBlobsDetector _cbd;
 	std::shared_ptr<NN2dMapper> _nn2d;
 
 	// background subtraction
@@ -65,6 +77,11 @@ private:
 
     std::shared_ptr<cv::Mat> _lastImage;
     uint _lastFramenumber;
+
+	qint64 _captureTimeUs;
+	quint64 _captureSequence;
+	// camera frames that never reached tracking, counted from the gaps in the sequence numbers
+	quint64 _skippedCaptures;
 };
 
 #endif // BIOTRACKERTRACKINGALGORITHM_H
@@ -0,0 +1,45 @@
+#include "PositionQueue.h"
+
+namespace {
+	size_t roundUpToPowerOfTwo(size_t v)
+	{
+		size_t p = 1;
+		while (p < v)
+			p <<= 1;
+		return p;
+	}
+}
+
+PositionQueue::PositionQueue(size_t capacity) :
+	_slots(roundUpToPowerOfTwo(capacity > 0 ? capacity : 1)),
+	_mask(_slots.size() - 1),
+	_head(0),
+	_tail(0)
+{
+}
+
+PositionFrame* PositionQueue::beginPush()
+{
+	const size_t tail = _tail.load(std::memory_order_relaxed);
+	if (tail - _head.load(std::memory_order_acquire) >= _slots.size())
+		return nullptr;
+	return &_slots[tail & _mask];
+}
+
+void PositionQueue::endPush()
+{
+	_tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+PositionFrame* PositionQueue::front()
+{
+	const size_t head = _head.load(std::memory_order_relaxed);
+	if (head == _tail.load(std::memory_order_acquire))
+		return nullptr;
+	return &_slots[head & _mask];
+}
+
+void PositionQueue::pop()
+{
+	_head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <vector>
+
+/**
+ * The positions of one tracked frame, as handed from the tracking thread to the network thread.
+ */
+struct PositionFrame
+{
+	struct Pose
+	{
+		float xCm;
+		float yCm;
+		float rad;
+		float deg;
+		float width;
+		float height;
+		float score;
+	};
+
+	struct Vertex
+	{
+		float x;
+		float y;
+	};
+
+	quint32 sequence;
+	qint32 frameNo;
+	// capture time in microseconds since the epoch
+	qint64 timestampUs;
+	std::vector<Pose> poses;
+	std::vector<Vertex> polygon;
+};
+
+/**
+ * Lock-free ring of PositionFrames for exactly one producer and one consumer thread.
+ * The slots are reused, so once their vectors have grown to the number of fish no more memory is allocated.
+ */
+class PositionQueue
+{
+public:
+	/**
+	 * @param capacity: the number of slots, rounded up to a power of two.
+	 */
+	explicit PositionQueue(size_t capacity = 64);
+
+	/**
+	 * Producer: the slot to fill next, or nullptr if the queue is full.
+	 */
+	PositionFrame* beginPush();
+
+	/**
+	 * Producer: publishes the slot returned by beginPush.
+	 */
+	void endPush();
+
+	/**
+	 * Consumer: the oldest frame, or nullptr if the queue is empty.
+	 */
+	PositionFrame* front();
+
+	/**
+	 * Consumer: releases the frame returned by front.
+	 */
+	void pop();
+
+private:
+	std::vector<PositionFrame> _slots;
+	size_t _mask;
+
+	// both only ever grow, the difference is the number of queued frames
+	std::atomic<size_t> _head;
+	std::atomic<size_t> _tail;
+};
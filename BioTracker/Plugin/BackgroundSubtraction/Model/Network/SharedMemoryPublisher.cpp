@@ -0,0 +1,264 @@
+#include "SharedMemoryPublisher.h"
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
+#endif
+
+namespace {
+	// header offsets
+	const size_t H_MAGIC = 0;
+	const size_t H_VERSION = 8;
+	const size_t H_HEADER_SIZE = 12;
+	const size_t H_SLOT_COUNT = 16;
+	const size_t H_SLOT_SIZE = 20;
+	const size_t H_MAX_FISH = 24;
+	const size_t H_PIXEL_CAPACITY = 28;
+	const size_t H_SEQUENCE = 32;
+	const size_t H_CLOSED = 36;
+	const size_t H_WAITERS = 40;
+
+	// slot offsets
+	const size_t S_LOCK = 0;
+	const size_t S_SEQUENCE = 4;
+	const size_t S_FRAME = 8;
+	const size_t S_FISH_COUNT = 12;
+	const size_t S_TIMESTAMP = 16;
+	const size_t S_WIDTH = 24;
+	const size_t S_HEIGHT = 28;
+	const size_t S_TYPE = 32;
+	const size_t S_STEP = 36;
+	const size_t S_PIXEL_OFFSET = 40;
+	const size_t S_PIXEL_BYTES = 44;
+
+	static_assert(sizeof(std::atomic<quint32>) == sizeof(quint32), "the shared counters must be plain 32 bit words");
+
+	std::atomic<quint32> &word(uchar *p)
+	{
+		return *reinterpret_cast<std::atomic<quint32> *>(p);
+	}
+
+	template<typename T>
+	void put(uchar *p, T v)
+	{
+		std::memcpy(p, &v, sizeof(v));
+	}
+
+	size_t align64(size_t v)
+	{
+		return (v + 63) & ~size_t(63);
+	}
+}
+
+SharedMemoryPublisher::SharedMemoryPublisher(const std::string &name, int slotCount) :
+	_slotCount(slotCount > 1 ? size_t(slotCount) : 2),
+	_slotSize(0),
+	_pixelCapacity(0),
+	_maxFish(0),
+	_sequence(0),
+	_failed(false),
+	_data(nullptr),
+	_size(0)
+#ifdef _WIN32
+	, _mapping(nullptr)
+#endif
+{
+#ifdef _WIN32
+	_name = "Local\\" + (!name.empty() && name[0] == '/' ? name.substr(1) : name);
+#else
+	_name = (!name.empty() && name[0] == '/') ? name : "/" + name;
+#endif
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher()
+{
+	close();
+}
+
+bool SharedMemoryPublisher::create(size_t pixelCapacity, size_t maxFish)
+{
+	close();
+
+	const size_t slotSize = align64(SlotHeaderSize + maxFish * FishRecordSize) + align64(pixelCapacity);
+	const size_t size = HeaderSize + _slotCount * slotSize;
+	if (slotSize > 0xFFFFFFFFu) {
+		qWarning() << "SharedMemoryPublisher: frames are too large to publish";
+		return false;
+	}
+
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		DWORD(quint64(size) >> 32), DWORD(size & 0xFFFFFFFFu), _name.c_str());
+	if (!mapping) {
+		qWarning() << "SharedMemoryPublisher: cannot create" << QString::fromStdString(_name);
+		return false;
+	}
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		// a reader still holds the previous segment, which can't be resized
+		CloseHandle(mapping);
+		qWarning() << "SharedMemoryPublisher:" << QString::fromStdString(_name) << "is still in use";
+		return false;
+	}
+	void *data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!data) {
+		CloseHandle(mapping);
+		qWarning() << "SharedMemoryPublisher: cannot map" << QString::fromStdString(_name);
+		return false;
+	}
+	_mapping = mapping;
+#else
+	// a segment left behind by a crashed run is replaced, its readers see a stale sequence and time out
+	shm_unlink(_name.c_str());
+	int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+	if (fd < 0) {
+		qWarning() << "SharedMemoryPublisher: cannot create" << QString::fromStdString(_name);
+		return false;
+	}
+	if (ftruncate(fd, off_t(size)) != 0) {
+		::close(fd);
+		shm_unlink(_name.c_str());
+		qWarning() << "SharedMemoryPublisher: cannot allocate" << size << "bytes for" << QString::fromStdString(_name);
+		return false;
+	}
+	void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		shm_unlink(_name.c_str());
+		qWarning() << "SharedMemoryPublisher: cannot map" << QString::fromStdString(_name);
+		return false;
+	}
+#endif
+
+	_data = static_cast<uchar *>(data);
+	_size = size;
+	_slotSize = slotSize;
+	_pixelCapacity = pixelCapacity;
+	_maxFish = maxFish;
+
+	// fresh pages are zeroed, so every lock starts even and the sequence says nothing is published yet
+	std::memcpy(_data + H_MAGIC, "BTSHM\0\0\0", 8);
+	put<quint32>(_data + H_VERSION, Version);
+	put<quint32>(_data + H_HEADER_SIZE, quint32(HeaderSize));
+	put<quint32>(_data + H_SLOT_COUNT, quint32(_slotCount));
+	put<quint32>(_data + H_SLOT_SIZE, quint32(_slotSize));
+	put<quint32>(_data + H_MAX_FISH, quint32(_maxFish));
+	put<quint32>(_data + H_PIXEL_CAPACITY, quint32(_pixelCapacity));
+	word(_data + H_SEQUENCE).store(0, std::memory_order_release);
+	return true;
+}
+
+void SharedMemoryPublisher::close()
+{
+	if (!_data)
+		return;
+
+	word(_data + H_CLOSED).store(1, std::memory_order_release);
+	// bump the sequence too, so that waiting readers wake up and notice
+	word(_data + H_SEQUENCE).fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+	syscall(SYS_futex, _data + H_SEQUENCE, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(static_cast<HANDLE>(_mapping));
+	_mapping = nullptr;
+#else
+	munmap(_data, _size);
+	// readers keep their mapping until they let go of it
+	shm_unlink(_name.c_str());
+#endif
+	_data = nullptr;
+	_size = 0;
+}
+
+void SharedMemoryPublisher::publish(
+	int frameNo,
+	const cv::Mat &frame,
+	const std::vector<FishPose> &poses,
+	std::chrono::system_clock::time_point ts)
+{
+	if (_failed)
+		return;
+
+	const size_t rowBytes = frame.cols * frame.elemSize();
+	const size_t pixelBytes = rowBytes * frame.rows;
+	if (!_data || pixelBytes > _pixelCapacity || poses.size() > _maxFish) {
+		// room for plenty of fish, so that the segment is only replaced when the frames grow
+		const size_t maxFish = std::max(std::max(_maxFish, poses.size() * 2), size_t(256));
+		if (!create(std::max(_pixelCapacity, pixelBytes), maxFish)) {
+			_failed = true;
+			return;
+		}
+	}
+
+	const quint32 sequence = _sequence++;
+	uchar *slot = _data + HeaderSize + (sequence % _slotCount) * _slotSize;
+
+	// seqlock: odd while the slot is written
+	std::atomic<quint32> &lock = word(slot + S_LOCK);
+	const quint32 l = lock.load(std::memory_order_relaxed);
+	lock.store(l + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const size_t pixelOffset = align64(SlotHeaderSize + _maxFish * FishRecordSize);
+	put<quint32>(slot + S_SEQUENCE, sequence + 1);
+	put<qint32>(slot + S_FRAME, qint32(frameNo));
+	put<quint32>(slot + S_FISH_COUNT, quint32(poses.size()));
+	put<qint64>(slot + S_TIMESTAMP,
+		qint64(std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count()));
+	put<qint32>(slot + S_WIDTH, qint32(frame.cols));
+	put<qint32>(slot + S_HEIGHT, qint32(frame.rows));
+	put<qint32>(slot + S_TYPE, qint32(frame.type()));
+	put<quint32>(slot + S_STEP, quint32(rowBytes));
+	put<quint32>(slot + S_PIXEL_OFFSET, quint32(pixelOffset));
+	put<quint32>(slot + S_PIXEL_BYTES, quint32(pixelBytes));
+
+	uchar *fish = slot + SlotHeaderSize;
+	for (size_t i = 0; i < poses.size(); i++, fish += FishRecordSize) {
+		const FishPose &pose = poses[i];
+		put<quint32>(fish + 0, quint32(i + 1));
+		put<float>(fish + 4, pose.position_cm().x);
+		put<float>(fish + 8, pose.position_cm().y);
+		put<qint32>(fish + 12, qint32(pose.position_px().x));
+		put<qint32>(fish + 16, qint32(pose.position_px().y));
+		put<float>(fish + 20, pose.orientation_rad());
+		put<float>(fish + 24, pose.orientation_deg());
+		put<float>(fish + 28, pose.width());
+		put<float>(fish + 32, pose.height());
+		put<float>(fish + 36, pose.getScore());
+	}
+
+	uchar *pixels = slot + pixelOffset;
+	if (frame.isContinuous()) {
+		std::memcpy(pixels, frame.data, pixelBytes);
+	}
+	else {
+		for (int y = 0; y < frame.rows; y++)
+			std::memcpy(pixels + y * rowBytes, frame.ptr(y), rowBytes);
+	}
+
+	lock.store(l + 2, std::memory_order_release);
+	word(_data + H_SEQUENCE).store(sequence + 1, std::memory_order_release);
+
+#if defined(__linux__)
+	// the syscall is only paid for when somebody sleeps on the sequence
+	if (word(_data + H_WAITERS).load(std::memory_order_acquire) > 0)
+		syscall(SYS_futex, _data + H_SEQUENCE, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
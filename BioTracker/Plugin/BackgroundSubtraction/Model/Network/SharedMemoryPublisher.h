@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include "Model/TrackedComponents/pose/FishPose.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+/**
+ * Publishes the current frame and the tracked poses to other processes on the same host through a named shared
+ * memory ring, so co-located consumers neither go through a socket nor parse text and can use the pixels in place.
+ *
+ * The segment is named by the setting FISHTANK_SHAREDMEMORY_NAME, a POSIX shared memory object (shm_open) on unix
+ * and a "Local\" file mapping on Windows. All fields are in host byte order. Layout:
+ *   header (64 bytes): char magic[8] "BTSHM", uint32 version, uint32 header size (offset of the first slot),
+ *                      uint32 slot count, uint32 slot size, uint32 max fish, uint32 pixel capacity,
+ *                      uint32 sequence, uint32 closed, uint32 waiters, 20 bytes reserved
+ *   slot (slot size bytes, 64 byte aligned, slot count times):
+ *                      uint32 lock, uint32 sequence, int32 frame, uint32 fish count, int64 capture time in us
+ *                      since the epoch, int32 width, int32 height, int32 OpenCV type, uint32 row step,
+ *                      uint32 pixel offset (from the slot start), uint32 pixel bytes, 16 bytes reserved,
+ *                      then max fish records, then the pixels
+ *   fish record (48 bytes): uint32 id, float x_cm, y_cm, int32 x_px, y_px, float rad, deg, width, height, score,
+ *                      8 bytes reserved
+ *
+ * Reading: the header sequence is the number of published frames, frame s (counting from 1) is in slot
+ * (s - 1) % slot count. A slot's lock is odd while it is written and changes with every write, so a reader copies
+ * or uses the slot and then checks that the lock still has the even value it saw before. With the default of
+ * three slots a reader has two frame intervals until its slot is reused.
+ * Waiting: on Linux, readers increment waiters and FUTEX_WAIT on the header sequence (the segment is shared, so
+ * no FUTEX_PRIVATE_FLAG), the publisher wakes them on every frame. Elsewhere readers poll the sequence.
+ * If closed becomes non-zero the publisher has replaced the segment (the frame grew) or quit, reopen it by name.
+ */
+class SharedMemoryPublisher
+{
+public:
+	static const quint32 Version = 1;
+	static const size_t HeaderSize = 64;
+	static const size_t SlotHeaderSize = 64;
+	static const size_t FishRecordSize = 48;
+
+	/**
+	 * @param name: the name of the segment, with or without a leading '/'.
+	 * @param slotCount: the number of frames in the ring.
+	 */
+	SharedMemoryPublisher(const std::string &name, int slotCount = 3);
+	~SharedMemoryPublisher();
+
+	/**
+	 * Copies the frame and the poses into the next slot and wakes the readers.
+	 * Called from the tracking thread only.
+	 */
+	void publish(int frameNo,
+		const cv::Mat &frame,
+		const std::vector<FishPose> &poses,
+		std::chrono::system_clock::time_point ts);
+
+private:
+	/**
+	 * (Re)creates the segment, so that every slot holds the given number of pixel bytes and fish.
+	 */
+	bool create(size_t pixelCapacity, size_t maxFish);
+	void close();
+
+	std::string _name;
+	size_t _slotCount;
+	size_t _slotSize;
+	size_t _pixelCapacity;
+	size_t _maxFish;
+	quint32 _sequence;
+	bool _failed;
+
+	uchar *_data;
+	size_t _size;
+#ifdef _WIN32
+	void *_mapping;
+#endif
+};
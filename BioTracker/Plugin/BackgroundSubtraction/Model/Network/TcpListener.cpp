@@ -1,9 +1,36 @@
 #include "TcpListener.h"
 
+#include <QtCore/QtEndian>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
-TcpListener::TcpListener(QObject *parent) : QTcpServer(parent)
+namespace {
+	void put16(uchar *&p, quint16 v) { qToLittleEndian(v, p); p += 2; }
+	void put32(uchar *&p, quint32 v) { qToLittleEndian(v, p); p += 4; }
+	void put64(uchar *&p, quint64 v) { qToLittleEndian(v, p); p += 8; }
+	void putFloat(uchar *&p, float v)
+	{
+		quint32 bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		put32(p, bits);
+	}
+}
+
+TcpListener::TcpListener(QObject *parent, Protocol protocol) :
+	QTcpServer(parent),
+	_protocol(protocol),
+	_wakePending(false),
+	_sequence(0),
+	_droppedFrames(0)
 {
+	QObject::connect(this, &QTcpServer::newConnection, this, &TcpListener::acceptConnection);
+}
+
+void TcpListener::startListening(int port)
+{
+	if (!listen(QHostAddress::Any, quint16(port)))
+		qWarning() << "TcpListener: cannot listen on port" << port << ":" << errorString();
 }
 
 void TcpListener::acceptConnection()
@@ -11,57 +38,174 @@ void TcpListener::acceptConnection()
 	while (this->hasPendingConnections())
 	{
 		QTcpSocket *socket = this->nextPendingConnection();
+		// no Nagle delay, every frame goes out right away
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+			_sockets.erase(std::remove(_sockets.begin(), _sockets.end(), socket), _sockets.end());
+			socket->deleteLater();
+		});
 		_sockets.push_back(socket);
 	}
 }
 
-void TcpListener::sendPositionsToSocket(std::string packet)
+void TcpListener::sendPositions(
+	int frameNo,
+	const std::vector<FishPose>& poses,
+	const std::vector<cv::Point2f>& polygon,
+	std::chrono::system_clock::time_point ts)
 {
+	const quint32 sequence = _sequence++;
+	PositionFrame *frame = _queue.beginPush();
+	if (!frame) {
+		if (_droppedFrames++ % 100 == 0)
+			qWarning() << "TcpListener: the network thread is behind, dropped" << _droppedFrames << "frames so far";
+		return;
+	}
+
+	frame->sequence = sequence;
+	frame->frameNo = frameNo;
+	frame->timestampUs = qint64(std::chrono::duration_cast<std::chrono::microseconds>(ts.time_since_epoch()).count());
+	frame->poses.resize(poses.size());
+	for (size_t i = 0; i < poses.size(); i++) {
+		PositionFrame::Pose &p = frame->poses[i];
+		p.xCm = poses[i].position_cm().x;
+		p.yCm = poses[i].position_cm().y;
+		p.rad = poses[i].orientation_rad();
+		p.deg = poses[i].orientation_deg();
+		p.width = poses[i].width();
+		p.height = poses[i].height();
+		p.score = poses[i].getScore();
+	}
+	frame->polygon.resize(polygon.size());
+	for (size_t i = 0; i < polygon.size(); i++) {
+		frame->polygon[i].x = polygon[i].x;
+		frame->polygon[i].y = polygon[i].y;
+	}
+	_queue.endPush();
 
-	std::vector<QTcpSocket *>::iterator sock_it = _sockets.begin();
-	for (sock_it = _sockets.begin(); sock_it != _sockets.end(); ++sock_it)
-		(*sock_it)->write(packet.c_str());
+	// Only the frame that finds the network thread idle posts a wake up. While one is queued or publish is
+	// running, the frame is taken along with the others, so the frames of a burst go out together.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!_wakePending.exchange(true))
+		QMetaObject::invokeMethod(this, "publish", Qt::QueuedConnection);
 }
 
-std::string TcpListener::sendPositions(
-	int frameNo,  
-	const std::vector<FishPose>& poses,
-	const std::vector<cv::Point2f>& polygon,
-	std::chrono::system_clock::time_point ts)
+void TcpListener::publish()
+{
+	while (true) {
+		PositionFrame *frame;
+		while ((frame = _queue.front()) != nullptr) {
+			if (!_sockets.empty()) {
+				if (_protocol == PROTOCOL_BINARY)
+					encodeBinary(*frame, _packet);
+				else
+					encodeText(*frame, _packet);
+				_queue.pop();
+				sendPositionsToSocket(_packet, _queue.front() == nullptr);
+			}
+			else {
+				_queue.pop();
+			}
+		}
+
+		// Idle from here on, frames pushed now post a new wake up. One pushed between emptying the queue and
+		// clearing the flag didn't, so look again and take it right away.
+		_wakePending = false;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_queue.front() == nullptr || _wakePending.exchange(true))
+			return;
+	}
+}
+
+void TcpListener::sendPositionsToSocket(const QByteArray &packet, bool newest)
+{
+	std::vector<QTcpSocket *> stalled;
+	for (QTcpSocket *socket : _sockets) {
+		const qint64 pending = socket->bytesToWrite();
+		if (pending >= DropBytes) {
+			stalled.push_back(socket);
+			continue;
+		}
+		// coalesce: a client that is behind only gets the newest frame
+		if (pending >= CoalesceBytes && !newest)
+			continue;
+		socket->write(packet);
+	}
+
+	for (QTcpSocket *socket : stalled) {
+		qWarning() << "TcpListener: dropping stalled client" << socket->peerAddress().toString();
+		// emits disconnected, which removes the socket
+		socket->abort();
+	}
+}
+
+void TcpListener::encodeText(const PositionFrame &frame, QByteArray &packet)
 {
 	std::stringstream str;
-	str << "frame:" << frameNo << ";";
+	str << "frame:" << frame.frameNo << ";";
 
-	str << "polygon:" << polygon.size() << ";";
-	for (auto vertex = polygon.cbegin(); vertex != polygon.cend(); ++vertex)
+	str << "polygon:" << frame.polygon.size() << ";";
+	for (auto vertex = frame.polygon.cbegin(); vertex != frame.polygon.cend(); ++vertex)
 	{
 		str << vertex->x << "x" << vertex->y << ";";
 	}
 
-	int fishCount = poses.size();
-	int fi = 0;
+	int fishCount = frame.poses.size();
 	str << "fishcount:" << fishCount << ";";
 
-	for (int i=0; i < poses.size(); i++)
+	const long ms = long(frame.timestampUs / 1000);
+	for (int i=0; i < fishCount; i++)
 	{
-
+		const PositionFrame::Pose &pose = frame.poses[i];
 		str << i+1 << "," // the id of the fish
-			<< poses[i].position_cm().x << "," // real position in cm - x-coordinate
-			<< poses[i].position_cm().y << "," // real position in cm - y-coordinate
-			<< poses[i].orientation_rad() << "," // orientation in radian
-			<< poses[i].orientation_deg() << "," // orientation in degree
-			<< poses[i].width() << ","	// size of the fish blob: width
-			<< poses[i].height() << "," // size of the fish blob: height
-			<< long(std::chrono::duration_cast<std::chrono::milliseconds>(ts.time_since_epoch()).count()) << "," // the time stamp
-			<< "F" << (((i + 1) == poses.size()) ? ";" : "&"); // F: obsolete "isRobofish" flag (F: not a robofish)
+			<< pose.xCm << "," // real position in cm - x-coordinate
+			<< pose.yCm << "," // real position in cm - y-coordinate
+			<< pose.rad << "," // orientation in radian
+			<< pose.deg << "," // orientation in degree
+			<< pose.width << ","	// size of the fish blob: width
+			<< pose.height << "," // size of the fish blob: height
+			<< ms << "," // the time stamp
+			<< "F" << (((i + 1) == fishCount) ? ";" : "&"); // F: obsolete "isRobofish" flag (F: not a robofish)
 	}
 	str << "end\n";
 
-	//std::cout << str.str() << std::endl;
+	const std::string s = str.str();
+	packet.resize(int(s.size()));
+	std::memcpy(packet.data(), s.data(), s.size());
+}
+
+void TcpListener::encodeBinary(const PositionFrame &frame, QByteArray &packet)
+{
+	const int fishCount = int(std::min<size_t>(frame.poses.size(), 0xFFFF));
+	const int vertexCount = int(std::min<size_t>(frame.polygon.size(), 0xFFFF));
+	packet.resize(BinaryHeaderSize + fishCount * BinaryFishSize + vertexCount * BinaryVertexSize);
+
+	uchar *p = reinterpret_cast<uchar *>(packet.data());
+	std::memcpy(p, "BTPF", 4);
+	p += 4;
+	put16(p, BinaryVersion);
+	put16(p, BinaryHeaderSize);
+	put32(p, frame.sequence);
+	put32(p, quint32(frame.frameNo));
+	put64(p, quint64(frame.timestampUs));
+	put16(p, quint16(fishCount));
+	put16(p, quint16(vertexCount));
+	put16(p, BinaryFishSize);
+	put16(p, 0);
 
-#ifdef SAVETRACKINGPACKAGES
-	_trackingInfoOutputFile4Simulation << str.str();
-#endif
-	sendPositionsToSocket(str.str());
-	return str.str();
+	for (int i = 0; i < fishCount; i++) {
+		const PositionFrame::Pose &pose = frame.poses[i];
+		put32(p, quint32(i + 1));
+		putFloat(p, pose.xCm);
+		putFloat(p, pose.yCm);
+		putFloat(p, pose.rad);
+		putFloat(p, pose.deg);
+		putFloat(p, pose.width);
+		putFloat(p, pose.height);
+		putFloat(p, pose.score);
+	}
+	for (int i = 0; i < vertexCount; i++) {
+		putFloat(p, frame.polygon[i].x);
+		putFloat(p, frame.polygon[i].y);
+	}
 }
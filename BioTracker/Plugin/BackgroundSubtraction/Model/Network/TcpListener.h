@@ -7,25 +7,81 @@
 #include <QtNetwork/QNetworkInterface>
 
 #include "Model/TrackedComponents/pose/FishPose.h"
+#include "Model/Network/PositionQueue.h"
 
 #include <vector>
 #include <chrono>
+#include <atomic>
 
+/**
+ * Streams the tracked positions to all connected clients.
+ *
+ * The listener is meant to live in a network thread of its own. sendPositions is called from the tracking thread
+ * and only copies the frame into a lock-free queue, all formatting and socket I/O happens in the network thread.
+ * Clients which can't keep up are sent only the newest frames, and dropped if they stall entirely, so they
+ * never delay tracking.
+ *
+ * PROTOCOL_TEXT is the original line based format. PROTOCOL_BINARY sends little endian records:
+ *   header (32 bytes): char magic[4] "BTPF", uint16 version, uint16 header size, uint32 sequence,
+ *                      int32 frame, int64 capture time in us since the epoch, uint16 fish count,
+ *                      uint16 polygon vertex count, uint16 fish record size, uint16 reserved
+ *   per fish (32 bytes): uint32 id, float x_cm, y_cm, rad, deg, width, height, score
+ *   per polygon vertex (8 bytes): float x, y
+ * The sequence number counts every frame passed to sendPositions, so gaps tell the frames a client missed.
+ */
 class TcpListener : public QTcpServer
 {
 	Q_OBJECT
 
 public:
-	TcpListener(QObject *parent = 0);
+	enum Protocol
+	{
+		PROTOCOL_TEXT = 0,
+		PROTOCOL_BINARY = 1
+	};
 
-public slots:
-	void acceptConnection();
-	void sendPositionsToSocket(std::string packet);
-	std::string sendPositions(int frameNo,
+	static const quint16 BinaryVersion = 1;
+	static const int BinaryHeaderSize = 32;
+	static const int BinaryFishSize = 32;
+	static const int BinaryVertexSize = 8;
+
+	TcpListener(QObject *parent = 0, Protocol protocol = PROTOCOL_TEXT);
+
+	/**
+	 * Queues the positions of a frame for sending. Never blocks, if the network thread is too far behind the
+	 * frame is dropped. Call from one thread only.
+	 */
+	void sendPositions(int frameNo,
 		const std::vector<FishPose>& poses,
 		const std::vector<cv::Point2f>& polygon,
 		std::chrono::system_clock::time_point ts);
 
+public slots:
+	void startListening(int port);
+	void acceptConnection();
+
+	/**
+	 * Sends all queued frames, runs in the network thread.
+	 */
+	void publish();
+
 private:
+	void encodeText(const PositionFrame &frame, QByteArray &packet);
+	void encodeBinary(const PositionFrame &frame, QByteArray &packet);
+	void sendPositionsToSocket(const QByteArray &packet, bool newest);
+
+	// pending output of a client above which it only gets the newest frame, and at which it is dropped
+	static const qint64 CoalesceBytes = 64 * 1024;
+	static const qint64 DropBytes = 4 * 1024 * 1024;
+
 	std::vector<QTcpSocket *> _sockets;
+	Protocol _protocol;
+
+	PositionQueue _queue;
+	// set while a publish is queued or running
+	std::atomic<bool> _wakePending;
+	quint32 _sequence;
+	quint64 _droppedFrames;
+
+	QByteArray _packet;
 };
@@ -11,23 +11,68 @@ TrackedElement::TrackedElement(QObject *parent, QString name, int id) :
 {
 	_x = 0;
 	_y = 0;
+	_xpx = 0;
+	_ypx = 0;
+	_w = 0;
+	_h = 0;
     _id = id;
 	_deg = 0;
 	_rad = 0;
+	_time = 0;
+	_score = 0;
 	_valid = false;
 	_fixed = false;
+	_track = nullptr;
+	_frame = -1;
 }
 
-void  TrackedElement::setValid(bool v) 
-{ 
-    _valid = v;
-    if (_parentNode) {
-        TrackedTrajectory* n = dynamic_cast<TrackedTrajectory*>(_parentNode);
-        if (n)
-            n->triggerRecalcValid();
-    }
+void TrackedElement::bind(TrackedTrajectory *track, int frame)
+{
+	_track = track;
+	_frame = frame;
+	setParent(track);
+}
+
+float TrackedElement::value(TrajectoryColumns::Column column, float own)
+{
+	return _track ? _track->columns().value(column, _frame) : own;
+}
+
+void TrackedElement::setValue(TrajectoryColumns::Column column, float &own, float val)
+{
+	if (_track)
+		_track->columns().setValue(column, _frame, val);
+	else
+		own = val;
+}
+
+void  TrackedElement::setValid(bool v)
+{
+	if (_track) {
+		_track->columns().setValid(_frame, v);
+		_track->triggerRecalcValid();
+	}
+	else {
+		_valid = v;
+	}
+}
+
+bool TrackedElement::getValid()
+{
+	return _track ? _track->columns().valid(_frame) : _valid;
+}
+
+void TrackedElement::setId(int val)
+{
+	// a proxy has the id of its trajectory
+	if (!_track)
+		_id = val;
 }
 
+int TrackedElement::getId()
+{
+	return _track ? _track->getId() : _id;
+}
 
 QString TrackedElement::getName()
 {
@@ -36,99 +81,83 @@ QString TrackedElement::getName()
 
 void TrackedElement::setFishPose(FishPose p)
 {
-	_pose = p;
-	_x = p.position_cm().x;
-	_y = p.position_cm().y;
-	_deg = p.orientation_deg();
-	_rad = p.orientation_rad();
-    _ypx = p.position_px().y;
-    _xpx = p.position_px().x;
-	_valid = true;
+	if (_track) {
+		_track->setPose(_frame, p);
+	}
+	else {
+		_x = p.position_cm().x;
+		_y = p.position_cm().y;
+		_deg = p.orientation_deg();
+		_rad = p.orientation_rad();
+		_ypx = p.position_px().y;
+		_xpx = p.position_px().x;
+		_w = p.width();
+		_h = p.height();
+		_score = p.getScore();
+		_valid = true;
+	}
 	Q_EMIT notifyView();
 }
 
 void TrackedElement::setTime(std::chrono::system_clock::time_point t) {
-    _timeSysclck = t;
+    setTime(qint64(std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count()));
 };
 
 void TrackedElement::setTime(qint64 t) {
-    _time = t;
-    std::string::size_type sz = 0;
-    long long ll = t / 1000;
-    long long remainder = t % 1000;
-    std::time_t tm(ll);
-
-    _timeSysclck = std::chrono::system_clock::from_time_t(tm); 
-    std::chrono::duration<long long, std::milli> dur(remainder);
-    _timeSysclck += dur;
+	if (_track)
+		_track->columns().setTime(_frame, t);
+	else
+		_time = t;
 };
 
 qint64 TrackedElement::getTime() {
-    qint64 q(std::chrono::duration_cast<std::chrono::milliseconds>(_timeSysclck.time_since_epoch()).count());
-    return q;
+	return _track ? _track->columns().time(_frame) : _time;
 };
 
 QString TrackedElement::getTimeString() {
-    std::time_t t = std::chrono::system_clock::to_time_t(_timeSysclck);
     QDateTime dt;
-    dt.setTime_t(t);
+    dt.setTime_t(uint(getTime() / 1000));
     _timeString = dt.toString();
     return _timeString;
 };
 
 FishPose TrackedElement::getFishPose()
 {
-	return _pose;
+	return FishPose(cv::Point2f(getX(), getY()), cv::Point(int(getXpx()), int(getYpx())), getRad(), getDeg(), getW(), getH(),
+		value(TrajectoryColumns::COLUMN_SCORE, _score));
 }
 
 void  TrackedElement::setX(float val) {
-	_x = val;
-	FishPose pnew(cv::Point2f(_x, _pose.position_cm().y), cv::Point2f(-1, -1), _rad, _deg, _pose.width(), _pose.height(), _pose.getScore());
-    _ypx = _pose.position_px().y;
-    _xpx = _pose.position_px().x;
-	_pose = pnew;
+	setValue(TrajectoryColumns::COLUMN_X, _x, val);
 };
 
 void  TrackedElement::setY(float val) {
-	_y = val;
-	FishPose pnew(cv::Point2f(_pose.position_cm().x, _y), cv::Point2f(-1, -1), _rad, _deg, _pose.width(), _pose.height(), _pose.getScore());
-    _ypx = _pose.position_px().y;
-    _xpx = _pose.position_px().x;
-	_pose = pnew;
+	setValue(TrajectoryColumns::COLUMN_Y, _y, val);
 };
 
 void  TrackedElement::setRad(float r) {
-	_rad = r;
-	FishPose pnew(_pose.position_cm(), _pose.position_px(), _rad, _deg, _pose.width(), _pose.height(), _pose.getScore());
-    _pose = pnew;
+	setValue(TrajectoryColumns::COLUMN_RAD, _rad, r);
 };
 
 void  TrackedElement::setDeg(float d) {
-	_deg = d;
-	FishPose pnew(_pose.position_cm(), _pose.position_px(), _rad, _deg, _pose.width(), _pose.height(), _pose.getScore());
-    _pose = pnew;
-
+	setValue(TrajectoryColumns::COLUMN_DEG, _deg, d);
 };
 
 void  TrackedElement::setW(float w) {
-	_w = w;
-	FishPose pnew(_pose.position_cm(), _pose.position_px(), _rad, _deg, _w, _pose.height(), _pose.getScore());
-    _pose = pnew;
+	setValue(TrajectoryColumns::COLUMN_W, _w, w);
 }
 
 void TrackedElement::setH(float h) {
-	_h = h;
-	FishPose pnew(_pose.position_cm(), _pose.position_px(), _rad, _deg, _pose.width(), _h, _pose.getScore());
-    _pose = pnew;
+	setValue(TrajectoryColumns::COLUMN_H, _h, h);
 }
 
 
 void TrackedElement::setXpx(float val) {
-    _xpx = val;
+	setValue(TrajectoryColumns::COLUMN_XPX, _xpx, val);
 }
 
 void TrackedElement::setYpx(float val) {
-    _ypx = val;
+	setValue(TrajectoryColumns::COLUMN_YPX, _ypx, val);
 }
 
 void TrackedElement::setWpx(float w) {
@@ -140,23 +169,35 @@ void TrackedElement::setHpx(float h) {
 }
 
 float TrackedElement::getX() {
-	return _pose.position_cm().x;
+	return value(TrajectoryColumns::COLUMN_X, _x);
 }
 
 float TrackedElement::getY() {
-	return _pose.position_cm().y;
+	return value(TrajectoryColumns::COLUMN_Y, _y);
 }
 
 float TrackedElement::getXpx() {
-    return _xpx;// _pose.position_px().x;
+	return value(TrajectoryColumns::COLUMN_XPX, _xpx);
 }
 
 float TrackedElement::getYpx() {
-    return _ypx;// _pose.position_px().y;
+	return value(TrajectoryColumns::COLUMN_YPX, _ypx);
+}
+
+float TrackedElement::getW() {
+	return value(TrajectoryColumns::COLUMN_W, _w);
+}
+
+float TrackedElement::getH() {
+	return value(TrajectoryColumns::COLUMN_H, _h);
+}
+
+float TrackedElement::getRad() {
+	return value(TrajectoryColumns::COLUMN_RAD, _rad);
 }
 
 float TrackedElement::getDeg() {
-	return _pose.orientation_deg();
+	return value(TrajectoryColumns::COLUMN_DEG, _deg);
 }
 
 void TrackedElement::operate()
@@ -179,6 +220,3 @@ bool TrackedElement::getPressedStatus()
 {
 	return false;
 }
-
-
-
@@ -5,17 +5,23 @@
 #include "Interfaces/IModel/IModelTrackedComponent.h"
 #include "QString"
 #include "Model/TrackedComponents/pose/FishPose.h"
+#include "Model/TrackedComponents/TrajectoryColumns.h"
 #include <qdatetime.h>
 
+class TrackedTrajectory;
+
 /**
 * This class is an example of how a TrackedComponent could be defined.
 * This class inherits from the IModelTrackedComponent class and is therefor part of the Composite Pattern.
 * This class represents the Leaf class in the Composite Pattern.
 * Objects of this class have a QObject as parent.
+* A standalone element holds its values itself. The elements handed out by TrackedTrajectory::getChild are
+* proxies, which read and write the columns of their trajectory at their frame instead.
 */
 class TrackedElement : public IModelTrackedPoint
 {
 	Q_OBJECT
+	friend class TrackedTrajectory;
 
 public:
 	TrackedElement(QObject *parent = 0, QString name = "n.a.", int id = 0);
@@ -34,7 +40,7 @@ public:
 	void  setHpx(float h);
 	void  setRad(float r);
 	void  setDeg(float d);
-	void  setId(int val) { _id = val; };
+	void  setId(int val);
     void  setTime(std::chrono::system_clock::time_point t);
     void  setTime(qint64 t);
     void  setTimeString(QString t) { _timeString = t; };
@@ -46,16 +52,16 @@ public:
     float getY();
     float getXpx();
     float getYpx();
-    float getW() { return _w; };
-    float getH() { return _h; };
-    float getWpx() { return _w; };
-    float getHpx() { return _h; };
-	float getRad() { return _rad; };
+    float getW();
+    float getH();
+    float getWpx() { return getW(); };
+    float getHpx() { return getH(); };
+	float getRad();
 	float getDeg();
-	int   getId() { return _id; };
+	int   getId();
     qint64  getTime();
     QString getTimeString();
-	bool  getValid() { return _valid; };
+	bool  getValid();
 	bool  getFixed() { return _fixed; };
 
 	bool hasX() { return true; };
@@ -78,14 +84,29 @@ public:
 	void setFishPose(FishPose p);
 	FishPose getFishPose();
 
+	/**
+	 * @return: whether this element is a proxy of a trajectory.
+	 */
+	bool isProxy() { return _track != nullptr; };
+
 	// ITrackedPoint interface
 public:
 	void operate();
 
 private:
-    std::chrono::system_clock::time_point _timeSysclck;
+	/**
+	 * Makes this element a proxy of the frame of the trajectory.
+	 */
+	void bind(TrackedTrajectory *track, int frame);
+
+	float value(TrajectoryColumns::Column column, float own);
+	void setValue(TrajectoryColumns::Column column, float &own, float val);
+
 	QString _unit = "cm";
-	FishPose _pose;
+	float _score;
+
+	TrackedTrajectory *_track;
+	int _frame;
 };
 
 #endif // TRACKEDELEMENT_H
@@ -1,6 +1,7 @@
 #include "TrackedTrajectory.h"
 #include "QDebug"
 #include "TrackedElement.h"
+#include <algorithm>
 
 void TrackedTrajectory::triggerRecalcValid() {
     g_calcValid = 1;
@@ -21,45 +22,202 @@ TrackedTrajectory::TrackedTrajectory(QObject *parent, QString name) :
 {
 	setFixed(false);
     g_calcValid = 1;
-    g_validCount = 0;
-    _size = 0;
     _valid = true;
 }
 
+TrackedTrajectory::~TrackedTrajectory()
+{
+	deleteProxies();
+}
+
 void TrackedTrajectory::operate()
 {
 	qDebug() << "Printing all TrackedElements in TrackedObject " <<  name;
 	qDebug() << "========================= Begin ==========================";
 	for (int i = 0; i < _TrackedComponents.size(); ++i) {
-		dynamic_cast<TrackedElement *>(_TrackedComponents.at(i))->operate();
+		if (_TrackedComponents.at(i))
+			_TrackedComponents.at(i)->operate();
 	}
+	qDebug() << _columns.size() << "frames," << _columns.validCount() << "valid";
 	qDebug() << "========================   End   =========================";
 }
 
 void TrackedTrajectory::add(IModelTrackedComponent *comp, int pos)
 {
+	IModelTrackedPoint *point = dynamic_cast<IModelTrackedPoint *>(comp);
+	if (point) {
+		if (pos < 0)
+			pos = size();
+
+		// the frame must not be overwritten by reading its chunk later
+		load(pos);
+		storePoint(point, pos);
+
+		TrackedElement *element = dynamic_cast<TrackedElement *>(point);
+		if (!element || !element->isProxy())
+			delete point;
+		return;
+	}
 
     comp->setParent(this);
+    g_calcValid = 1;
 
 	if (pos < 0) {
 		_TrackedComponents.append(comp);
-        _size++;
-        g_validCount++;
 	}
-	else if (_size <= pos) {
-        while (_size < pos)
-        {
+	else {
+        while (_TrackedComponents.size() < pos)
             _TrackedComponents.append(nullptr);
-            _size++;
-        }
 
-		_TrackedComponents.append(comp);
-        _size++;
-        g_validCount++;
+		if (_TrackedComponents.size() == pos)
+			_TrackedComponents.append(comp);
+		else
+			_TrackedComponents[pos] = comp;
+	}
+}
+
+void TrackedTrajectory::storePoint(IModelTrackedPoint *point, int pos)
+{
+	// read everything first, point might be a proxy of this very frame
+	float values[TrajectoryColumns::COLUMN_COUNT];
+	values[TrajectoryColumns::COLUMN_X] = point->getX();
+	values[TrajectoryColumns::COLUMN_Y] = point->getY();
+	values[TrajectoryColumns::COLUMN_XPX] = point->getXpx();
+	values[TrajectoryColumns::COLUMN_YPX] = point->getYpx();
+	values[TrajectoryColumns::COLUMN_RAD] = point->getRad();
+	values[TrajectoryColumns::COLUMN_DEG] = point->getDeg();
+	values[TrajectoryColumns::COLUMN_W] = point->getW();
+	values[TrajectoryColumns::COLUMN_H] = point->getH();
+	values[TrajectoryColumns::COLUMN_SCORE] = 0;
+	const qint64 time = point->getTime();
+	const bool valid = point->getValid();
+
+	TrackedElement *element = dynamic_cast<TrackedElement *>(point);
+	if (element)
+		values[TrajectoryColumns::COLUMN_SCORE] = element->getFishPose().getScore();
+
+	_columns.insert(pos);
+	for (int column = 0; column < TrajectoryColumns::COLUMN_COUNT; column++)
+		_columns.setValue(TrajectoryColumns::Column(column), pos, values[column]);
+	_columns.setTime(pos, time);
+	_columns.setValid(pos, valid);
+}
+
+bool TrackedTrajectory::setElementSource(std::shared_ptr<IModelTrackedElementSource> source)
+{
+	_source = source;
+	const int end = source ? source->frameEnd() : 0;
+	_sourceChunksLeft = end > 0 ? ((end - 1) >> TrajectoryColumns::ChunkBits) + 1 : 0;
+	_sourceChunks.assign(size_t(_sourceChunksLeft), false);
+	if (_sourceChunksLeft == 0)
+		_source.reset();
+	return true;
+}
+
+void TrackedTrajectory::load(int frame)
+{
+	if (!_source || frame < 0)
+		return;
+	const size_t chunk = size_t(frame) >> TrajectoryColumns::ChunkBits;
+	if (chunk >= _sourceChunks.size() || _sourceChunks[chunk])
+		return;
+	_sourceChunks[chunk] = true;
+
+	// one element to read into, the values are copied into the columns anyway
+	TrackedElement element(nullptr, "n.a.", getId());
+	const int first = int(chunk) << TrajectoryColumns::ChunkBits;
+	const int end = std::min(first + TrajectoryColumns::ChunkSize, _source->frameEnd());
+	for (int f = first; f < end; f++) {
+		if (_source->readElement(f, &element))
+			storePoint(&element, f);
+	}
+
+	// everything is in the columns, the file can be unmapped
+	if (--_sourceChunksLeft == 0) {
+		_source.reset();
+		_sourceChunks.clear();
+	}
+}
+
+void TrackedTrajectory::loadAll()
+{
+	for (size_t chunk = 0; _source && chunk < _sourceChunks.size(); chunk++)
+		load(int(chunk) << TrajectoryColumns::ChunkBits);
+}
+
+void TrackedTrajectory::addPose(const FishPose &pose, std::chrono::system_clock::time_point time, int pos)
+{
+	load(pos);
+	_columns.insert(pos);
+	_columns.setTime(pos, qint64(std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count()));
+	setPose(pos, pose);
+}
+
+void TrackedTrajectory::setPose(int pos, const FishPose &pose)
+{
+	load(pos);
+	_columns.setValue(TrajectoryColumns::COLUMN_X, pos, pose.position_cm().x);
+	_columns.setValue(TrajectoryColumns::COLUMN_Y, pos, pose.position_cm().y);
+	_columns.setValue(TrajectoryColumns::COLUMN_XPX, pos, float(pose.position_px().x));
+	_columns.setValue(TrajectoryColumns::COLUMN_YPX, pos, float(pose.position_px().y));
+	_columns.setValue(TrajectoryColumns::COLUMN_RAD, pos, pose.orientation_rad());
+	_columns.setValue(TrajectoryColumns::COLUMN_DEG, pos, pose.orientation_deg());
+	_columns.setValue(TrajectoryColumns::COLUMN_W, pos, pose.width());
+	_columns.setValue(TrajectoryColumns::COLUMN_H, pos, pose.height());
+	_columns.setValue(TrajectoryColumns::COLUMN_SCORE, pos, pose.getScore());
+	_columns.setValid(pos, true);
+}
+
+FishPose TrackedTrajectory::getFishPose(int pos)
+{
+	load(pos);
+	if (!_columns.contains(pos))
+		return FishPose();
+
+	return FishPose(
+		cv::Point2f(_columns.value(TrajectoryColumns::COLUMN_X, pos), _columns.value(TrajectoryColumns::COLUMN_Y, pos)),
+		cv::Point(int(_columns.value(TrajectoryColumns::COLUMN_XPX, pos)), int(_columns.value(TrajectoryColumns::COLUMN_YPX, pos))),
+		_columns.value(TrajectoryColumns::COLUMN_RAD, pos),
+		_columns.value(TrajectoryColumns::COLUMN_DEG, pos),
+		_columns.value(TrajectoryColumns::COLUMN_W, pos),
+		_columns.value(TrajectoryColumns::COLUMN_H, pos),
+		_columns.value(TrajectoryColumns::COLUMN_SCORE, pos));
+}
+
+TrackedElement *TrackedTrajectory::proxy(int frame)
+{
+	QMutexLocker locker(&_lookupMutex);
+	load(frame);
+	if (!_columns.contains(frame))
+		return nullptr;
+
+	auto bound = _proxyFrames.find(frame);
+	if (bound != _proxyFrames.end())
+		return bound.value();
+
+	TrackedElement *element;
+	if (int(_proxies.size()) < PROXY_COUNT) {
+		// no QObject parent, the lookup may run in another thread than this object
+		element = new TrackedElement(nullptr, "n.a.", getId());
+		_proxies.push_back(element);
 	}
 	else {
-		_TrackedComponents[pos] = comp;
+		element = _proxies[_nextProxy];
+		_nextProxy = (_nextProxy + 1) % PROXY_COUNT;
+		_proxyFrames.remove(element->_frame);
 	}
+	element->bind(this, frame);
+	_proxyFrames.insert(frame, element);
+	return element;
+}
+
+void TrackedTrajectory::deleteProxies()
+{
+	for (TrackedElement *element : _proxies)
+		delete element;
+	_proxies.clear();
+	_proxyFrames.clear();
+	_nextProxy = 0;
 }
 
 bool TrackedTrajectory::remove(IModelTrackedComponent *comp)
@@ -77,7 +235,13 @@ void TrackedTrajectory::clear()
             dynamic_cast<IModelTrackedTrajectory*>(el)->clear();
     }
     _TrackedComponents.clear();
-    _size = 0;
+
+	QMutexLocker locker(&_lookupMutex);
+	_columns.clear();
+	_source.reset();
+	_sourceChunks.clear();
+	_sourceChunksLeft = 0;
+	deleteProxies();
 }
 
 IModelTrackedComponent* TrackedTrajectory::getChild(int index)
@@ -85,53 +249,59 @@ IModelTrackedComponent* TrackedTrajectory::getChild(int index)
     if (index < 0)
         return nullptr;
 
-    if (index == _size - 1) {
-        return _TrackedComponents.back();
-    }
+	if (index < _TrackedComponents.size() && _TrackedComponents.at(index))
+		return _TrackedComponents.at(index);
 
-	return (_size > index ? _TrackedComponents.at(index) : nullptr);
+	return proxy(index);
 }
 
-IModelTrackedComponent* TrackedTrajectory::getValidChild(int index)
+void TrackedTrajectory::updateValidChildren()
 {
-    int c = 0;
-    foreach(IModelTrackedComponent* el, _TrackedComponents) {
-        if (el){
-            if (c == index && el->getValid())
-                return el;
-            c += el->getValid() ? 1 : 0;
-        }
+    if (g_calcValid == 0)
+        return;
+
+    _validChildren.clear();
+    for (int i = 0; i < _TrackedComponents.size(); i++) {
+        IModelTrackedComponent *el = _TrackedComponents.at(i);
+        if (el && el->getValid())
+            _validChildren.push_back(i);
     }
+    g_calcValid = 0;
+}
 
-    return nullptr;
+IModelTrackedComponent* TrackedTrajectory::getValidChild(int index)
+{
+    if (index < 0)
+        return nullptr;
+
+    int frame;
+    {
+        QMutexLocker locker(&_lookupMutex);
+        loadAll();
+        updateValidChildren();
+        const int c = int(_validChildren.size());
+        if (index < c)
+            return _TrackedComponents.at(_validChildren[index]);
+        frame = _columns.validFrame(index - c);
+    }
+    return proxy(frame);
 }
 
 IModelTrackedComponent* TrackedTrajectory::getLastChild()
 {
-    if (_TrackedComponents.empty())
-        return nullptr;
-	return _TrackedComponents.back();
+	return getChild(size() - 1);
 }
 
 int TrackedTrajectory::size()
 {
-    return (_size == 0 ? _size = _TrackedComponents.size() : _size);
+    const int loaded = std::max(_TrackedComponents.size(), _columns.size());
+    return _source ? std::max(loaded, _source->frameEnd()) : loaded;
 }
 
 int TrackedTrajectory::validCount()
 {
-    if (g_calcValid == 1) {
-        int c = 0;
-        foreach(IModelTrackedComponent* el, _TrackedComponents) {
-            if (el)
-                c += el->getValid() ? 1 : 0;
-        }
-
-        g_validCount = c;
-        g_calcValid = 0;
-        return c;
-    }
-    else {
-        return g_validCount;
-    }
+    QMutexLocker locker(&_lookupMutex);
+    loadAll();
+    updateValidChildren();
+    return int(_validChildren.size()) + _columns.validCount();
 }
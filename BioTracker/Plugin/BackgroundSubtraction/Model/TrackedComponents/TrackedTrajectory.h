@@ -2,14 +2,27 @@
 #define TRACKEDOTRAJECTORY_H
 
 #include "Interfaces/IModel/IModelTrackedTrajectory.h"
+#include "Model/TrackedComponents/TrajectoryColumns.h"
+#include "Model/TrackedComponents/pose/FishPose.h"
+#include "QHash"
 #include "QList"
+#include "QMutex"
 #include "QString"
+#include <vector>
+
+class TrackedElement;
 
 /**
  * This class inherits from the IModelTrackedTrajectory class and is therefor part of the Composite Pattern.
  * This class represents the Composite class.
  * This class is responsibility for the handling of Leaf objects.
- * Internaly this class uses a QList for storing Leaf object.
+ * Child trajectories are kept in a QList. Tracked points are not stored as objects: their values are copied
+ * into TrajectoryColumns, indexed by the frame number, and getChild hands out TrackedElement proxies reading
+ * and writing these columns.
+ * getValidChild and validCount don't scan: the columns index their valid frames, and the positions of the valid
+ * children in the QList are kept in a table, which is only rebuilt after the list or a child's valid flag changed.
+ * The lookups are called from the GUI and the tracking thread, a mutex guards the proxies and the table.
+ * A trajectory loaded from a track file reads its points from the mapped file chunk by chunk, as they are accessed.
  *
  * Objects of this class have a QObject as parent.
  */
@@ -18,6 +31,7 @@ class TrackedTrajectory : public IModelTrackedTrajectory {
 
   public:
 	TrackedTrajectory(QObject *parent = 0, QString name = "n.a.");
+	~TrackedTrajectory();
 
 	// ITrackedComponent interface
 public:
@@ -25,22 +39,94 @@ public:
 
 	// ITrackedObject interface
 public:
+	/**
+	 * Adds a child trajectory, or a tracked point at the frame pos.
+	 * The values of a point are copied into the columns and the trajectory takes the ownership of it,
+	 * i.e. the point is deleted unless it is a proxy handed out by getChild.
+	 */
 	void add(IModelTrackedComponent *comp, int pos = -1) override;
 	bool remove(IModelTrackedComponent *comp) override;
 	void clear() override;
+
+	/**
+	 * For the frames of the tracked points a proxy is returned. The proxies are a small pool that is recycled:
+	 * a pointer stays valid for the next PROXY_COUNT - 1 lookups of other frames and until clear().
+	 */
 	IModelTrackedComponent *getChild(int index) override;
     IModelTrackedComponent* getValidChild(int index) override;
 	IModelTrackedComponent *getLastChild() override;
     int size() override;
     int validCount() override;
+    bool setElementSource(std::shared_ptr<IModelTrackedElementSource> source) override;
     void setValid(bool v) override;
     void triggerRecalcValid();
 
+	/**
+	 * Stores a pose as the valid position at the frame pos, without creating a TrackedElement.
+	 */
+	void addPose(const FishPose &pose, std::chrono::system_clock::time_point time, int pos);
+
+	/**
+	 * Overwrites the pose at the frame pos, if it exists, and sets it valid.
+	 */
+	void setPose(int pos, const FishPose &pose);
+
+	/**
+	 * @return: whether there is a tracked point at the frame pos.
+	 */
+	bool hasPose(int pos) { load(pos); return _columns.contains(pos); };
+
+	/**
+	 * @return: the pose at the frame pos, a default FishPose if there is none.
+	 */
+	FishPose getFishPose(int pos);
+
+	TrajectoryColumns &columns() { return _columns; };
+
 private:
+	TrackedElement *proxy(int frame);
+
+	/**
+	 * Copies the values of the point into the columns at the frame pos.
+	 */
+	void storePoint(IModelTrackedPoint *point, int pos);
+
+	/**
+	 * Reads the chunk of the columns holding the frame from the element source, if it wasn't read yet.
+	 * loadAll reads all chunks and releases the source.
+	 */
+	void load(int frame);
+	void loadAll();
+
+	/**
+	 * Rebuilds _validChildren if it is outdated.
+	 */
+	void updateValidChildren();
+
     int g_calcValid = 1;
-    int g_validCount = 0;
-    int _size = 0;
 	QString name;
+
+	// positions of the valid children in _TrackedComponents
+	std::vector<int> _validChildren;
+
+	TrajectoryColumns _columns;
+
+	// guards the proxies and _validChildren
+	QMutex _lookupMutex;
+
+	// the proxy pool, rebound round-robin starting at _nextProxy once it is full.
+	// _proxyFrames maps the frames to the bound proxies.
+	static const int PROXY_COUNT = 32;
+	std::vector<TrackedElement*> _proxies;
+	int _nextProxy = 0;
+	QHash<int, TrackedElement*> _proxyFrames;
+
+	void deleteProxies();
+
+	// the elements not read yet, _sourceChunks flags the chunks of the columns that are
+	std::shared_ptr<IModelTrackedElementSource> _source;
+	std::vector<bool> _sourceChunks;
+	int _sourceChunksLeft = 0;
 };
 
 #endif // TRACKEDOTRAJECTORY_H
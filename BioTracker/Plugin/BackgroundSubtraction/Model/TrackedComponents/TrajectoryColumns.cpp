@@ -0,0 +1,176 @@
+#include "TrajectoryColumns.h"
+
+#include <algorithm>
+
+namespace {
+	int popcount(uint64_t v)
+	{
+		v = v - ((v >> 1) & 0x5555555555555555ull);
+		v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+		v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<int>((v * 0x0101010101010101ull) >> 56);
+	}
+
+	/**
+	 * @return: the position of the index-th set bit of v, which must have more than index bits set.
+	 */
+	int selectBit(uint64_t v, int index)
+	{
+		for (int i = 0; i < index; i++)
+			v &= v - 1;
+		// the bits below the lowest set one
+		return popcount((v & (0 - v)) - 1);
+	}
+}
+
+TrajectoryColumns::TrajectoryColumns(void) :
+	_size(0),
+	_validCount(0)
+{}
+
+TrajectoryColumns::Chunk* TrajectoryColumns::find(int frame) const
+{
+	if (frame < 0)
+		return nullptr;
+	const size_t c = static_cast<size_t>(frame) >> ChunkBits;
+	if (c >= _chunks.size() || !_chunks[c])
+		return nullptr;
+	Chunk* chunk = _chunks[c].get();
+	return chunk->present[frame & ChunkMask] ? chunk : nullptr;
+}
+
+bool TrajectoryColumns::contains(int frame) const
+{
+	return find(frame) != nullptr;
+}
+
+void TrajectoryColumns::insert(int frame)
+{
+	if (frame < 0)
+		return;
+
+	const size_t c = static_cast<size_t>(frame) >> ChunkBits;
+	if (c >= _chunks.size()) {
+		_chunks.resize(c + 1);
+		rebuildIndex();
+	}
+	// value initialized, so all frames of a new chunk start out absent
+	if (!_chunks[c])
+		_chunks[c].reset(new Chunk());
+
+	Chunk& chunk = *_chunks[c];
+	const int i = frame & ChunkMask;
+	for (int column = 0; column < COLUMN_COUNT; column++)
+		chunk.values[column][i] = 0;
+	chunk.time[i] = 0;
+	updateValid(chunk, c, i, false);
+	chunk.present[i] = 1;
+
+	_size = std::max(_size, frame + 1);
+}
+
+void TrajectoryColumns::clear()
+{
+	_chunks.clear();
+	_size = 0;
+	_validTree.clear();
+	_validCount = 0;
+}
+
+float TrajectoryColumns::value(Column column, int frame) const
+{
+	const Chunk* chunk = find(frame);
+	return chunk ? chunk->values[column][frame & ChunkMask] : 0;
+}
+
+void TrajectoryColumns::setValue(Column column, int frame, float value)
+{
+	Chunk* chunk = find(frame);
+	if (chunk)
+		chunk->values[column][frame & ChunkMask] = value;
+}
+
+qint64 TrajectoryColumns::time(int frame) const
+{
+	const Chunk* chunk = find(frame);
+	return chunk ? chunk->time[frame & ChunkMask] : 0;
+}
+
+void TrajectoryColumns::setTime(int frame, qint64 time)
+{
+	Chunk* chunk = find(frame);
+	if (chunk)
+		chunk->time[frame & ChunkMask] = time;
+}
+
+bool TrajectoryColumns::valid(int frame) const
+{
+	const Chunk* chunk = find(frame);
+	const int i = frame & ChunkMask;
+	return chunk && (chunk->valid[i / WordBits] >> (i % WordBits) & 1);
+}
+
+void TrajectoryColumns::setValid(int frame, bool valid)
+{
+	Chunk* chunk = find(frame);
+	if (chunk)
+		updateValid(*chunk, static_cast<size_t>(frame) >> ChunkBits, frame & ChunkMask, valid);
+}
+
+void TrajectoryColumns::updateValid(Chunk& chunk, size_t c, int i, bool valid)
+{
+	uint64_t& word = chunk.valid[i / WordBits];
+	const uint64_t bit = uint64_t(1) << (i % WordBits);
+	if (((word & bit) != 0) == valid)
+		return;
+
+	word ^= bit;
+	const int delta = valid ? 1 : -1;
+	_validCount += delta;
+	for (size_t n = c + 1; n < _validTree.size(); n += n & (0 - n))
+		_validTree[n] += delta;
+}
+
+void TrajectoryColumns::rebuildIndex()
+{
+	_validTree.assign(_chunks.size() + 1, 0);
+	for (size_t c = 0; c < _chunks.size(); c++) {
+		if (!_chunks[c])
+			continue;
+		for (uint64_t word : _chunks[c]->valid)
+			_validTree[c + 1] += popcount(word);
+	}
+	// turn the counts into the tree in place
+	for (size_t n = 1; n < _validTree.size(); n++) {
+		const size_t parent = n + (n & (0 - n));
+		if (parent < _validTree.size())
+			_validTree[parent] += _validTree[n];
+	}
+}
+
+int TrajectoryColumns::validFrame(int index) const
+{
+	if (index < 0 || index >= _validCount)
+		return -1;
+
+	// descend the Fenwick tree to the chunk holding the frame
+	size_t pos = 0;
+	size_t step = 1;
+	while (step * 2 < _validTree.size())
+		step *= 2;
+	for (; step > 0; step /= 2) {
+		if (pos + step < _validTree.size() && _validTree[pos + step] <= index) {
+			pos += step;
+			index -= _validTree[pos];
+		}
+	}
+
+	const Chunk* chunk = _chunks[pos].get();
+	for (int w = 0; w < ChunkSize / WordBits; w++) {
+		const int count = popcount(chunk->valid[w]);
+		if (index < count)
+			return static_cast<int>(pos << ChunkBits) + w * WordBits + selectBit(chunk->valid[w], index);
+		index -= count;
+	}
+	return -1;
+}
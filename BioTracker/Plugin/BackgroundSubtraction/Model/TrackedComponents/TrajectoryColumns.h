@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QtGlobal>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Stores the positions of one trajectory column-wise: every attribute is kept in an array of its own, indexed by the
+ * frame number. The frames are split into chunks of ChunkSize frames each. A chunk is only allocated once a frame
+ * within its range is inserted, so gaps in a trajectory cost one null pointer per chunk.
+ * The valid flags are kept as a bitset per chunk, together with the number of valid frames of every chunk in a
+ * Fenwick tree. So validCount is O(1) and validFrame O(log chunks) instead of a scan over all frames.
+ */
+class TrajectoryColumns
+{
+public:
+
+	/**
+	 * The float valued columns.
+	 */
+	enum Column
+	{
+		COLUMN_X = 0,
+		COLUMN_Y,
+		COLUMN_XPX,
+		COLUMN_YPX,
+		COLUMN_RAD,
+		COLUMN_DEG,
+		COLUMN_W,
+		COLUMN_H,
+		COLUMN_SCORE,
+		COLUMN_COUNT
+	};
+
+	static const int ChunkBits = 10;
+	static const int ChunkSize = 1 << ChunkBits;
+	static const int ChunkMask = ChunkSize - 1;
+
+	TrajectoryColumns(void);
+
+	/**
+	 * @return: one past the highest frame inserted, 0 if there is none.
+	 */
+	int size() const { return _size; }
+
+	/**
+	 * @return: whether there is a position for the frame.
+	 */
+	bool contains(int frame) const;
+
+	/**
+	 * Adds the frame with all values set to zero and invalid, or resets it if it already exists.
+	 */
+	void insert(int frame);
+
+	/**
+	 * Removes all frames and frees the chunks.
+	 */
+	void clear();
+
+	/**
+	 * The getters return zero for frames that don't exist, the setters ignore them.
+	 */
+	float value(Column column, int frame) const;
+	void setValue(Column column, int frame, float value);
+	qint64 time(int frame) const;
+	void setTime(int frame, qint64 time);
+	bool valid(int frame) const;
+	void setValid(int frame, bool valid);
+
+	/**
+	 * @return: the number of valid frames.
+	 */
+	int validCount() const { return _validCount; }
+
+	/**
+	 * @return: the index-th valid frame, counted from 0, or -1 if there are not as many.
+	 */
+	int validFrame(int index) const;
+
+private:
+	static const int WordBits = 64;
+
+	struct Chunk
+	{
+		float values[COLUMN_COUNT][ChunkSize];
+		qint64 time[ChunkSize];
+		uint64_t valid[ChunkSize / WordBits];
+		uint8_t present[ChunkSize];
+	};
+
+	/**
+	 * @return: the chunk holding the frame if the frame exists, nullptr otherwise.
+	 */
+	Chunk* find(int frame) const;
+
+	/**
+	 * Sets the valid bit of an existing frame and keeps the counts up to date.
+	 */
+	void updateValid(Chunk& chunk, size_t c, int i, bool valid);
+
+	/**
+	 * Rebuilds the Fenwick tree after the number of chunks changed.
+	 */
+	void rebuildIndex();
+
+	std::vector<std::unique_ptr<Chunk>> _chunks;
+	int _size;
+
+	// Fenwick tree over the valid counts of the chunks, 1-based
+	std::vector<int> _validTree;
+	int _validCount;
+};
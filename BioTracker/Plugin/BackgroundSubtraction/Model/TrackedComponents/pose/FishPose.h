@@ -95,7 +95,7 @@ public:
 	/**
 	* @return: the score of the fish that comes from the mapper - usually between 0 and 1
 	*/
-	float		getScore() { return _score; }
+	float		getScore() const { return _score; }
 
 	/**
 	* Sets the score of the fish pose. Conventionally, it should be between 0 and 1.
@@ -12,6 +12,8 @@ TrackerParameter::TrackerParameter(QObject *parent) :
 	_SizeDilate = _settings->getValueOrDefault(TRACKERPARAM::SIZE_DILATE, 8);
 	_MinBlobSize = _settings->getValueOrDefault(TRACKERPARAM::MIN_BLOB_SIZE, 40);
 	_MaxBlobSize = _settings->getValueOrDefault(TRACKERPARAM::MAX_BLOB_SIZE, 999999);
+	_blobDetector = _settings->getValueOrDefault(TRACKERPARAM::BLOB_DETECTOR, (int)BLOB_DETECTOR_CVBLOBS);
+	_maxAssignmentDistance = _settings->getValueOrDefault(TRACKERPARAM::MAX_ASSIGNMENT_DISTANCE, 10.0);
 
 	_mog2History = _settings->getValueOrDefault(TRACKERPARAM::BG_MOG2_HISTORY, 200);
 	_mog2VarThresh = _settings->getValueOrDefault(TRACKERPARAM::BG_MOG2_VAR_THRESHOLD, 64);
@@ -10,6 +10,15 @@ class TrackerParameter : public IModel
 {
     Q_OBJECT
 public:
+	/**
+	 * The detectors finding the blobs in the pre-processed image.
+	 */
+	enum BlobDetector {
+		BLOB_DETECTOR_CVBLOBS = 0,
+		BLOB_DETECTOR_SIMPLE = 1,
+		BLOB_DETECTOR_COMPONENTS = 2
+	};
+
     TrackerParameter(QObject *parent = 0);
 
     void setThreshold(int x);
@@ -63,6 +72,20 @@ public:
 		Q_EMIT notifyView();
 	};
 
+	int getBlobDetector() { return _blobDetector; };
+	void setBlobDetector(int x) {
+		_blobDetector = x;
+		_settings->setParam(TRACKERPARAM::BLOB_DETECTOR, x);
+		Q_EMIT notifyView();
+	};
+
+	double getMaxAssignmentDistance() { return _maxAssignmentDistance; };
+	void setMaxAssignmentDistance(double x) {
+		_maxAssignmentDistance = x;
+		_settings->setParam(TRACKERPARAM::MAX_ASSIGNMENT_DISTANCE, x);
+		Q_EMIT notifyView();
+	};
+
 	bool getDoBackground() { return _doBackground; };
 	void setDoBackground(bool x) {
 		_doBackground = x;
@@ -145,6 +168,8 @@ private:
 	double _mog2BackgroundRatio;
 	int _MinBlobSize;
 	int _MaxBlobSize;
+	int _blobDetector;
+	double _maxAssignmentDistance;
 
 	bool _doBackground;
 	int _sendImage;
@@ -0,0 +1,226 @@
+#include "AssignmentSolver.h"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+	double distance(const cv::Point2f& a, const cv::Point2f& b)
+	{
+		const double d = std::sqrt(double(a.x - b.x) * (a.x - b.x) + double(a.y - b.y) * (a.y - b.y));
+		// unknown positions can still be matched, but only as a last resort
+		return std::isfinite(d) ? d : double(std::numeric_limits<float>::max());
+	}
+
+	int64_t cellKey(int64_t x, int64_t y)
+	{
+		return (x << 32) ^ (y & 0xffffffff);
+	}
+
+	/**
+	 * Matches all rows with all columns, rows.size() <= cols.size() has to hold.
+	 * @return the column of every row.
+	 */
+	std::vector<int> solveDense(const std::vector<cv::Point2f>& rows, const std::vector<cv::Point2f>& cols)
+	{
+		std::vector<std::vector<AssignmentSolver::Edge>> edges(rows.size());
+		for (size_t i = 0; i < rows.size(); i++) {
+			edges[i].reserve(cols.size());
+			for (size_t j = 0; j < cols.size(); j++)
+				edges[i].push_back(AssignmentSolver::Edge{ static_cast<int>(j), distance(rows[i], cols[j]) });
+		}
+		return AssignmentSolver::solve(static_cast<int>(cols.size()), edges);
+	}
+}
+
+std::vector<int> AssignmentSolver::solve(int cols, const std::vector<std::vector<Edge>>& rows)
+{
+	const double infinity = std::numeric_limits<double>::infinity();
+	const int numRows = static_cast<int>(rows.size());
+
+	// the dual variables; the reduced costs cost - u[row] - v[col] stay non-negative
+	std::vector<double> u(numRows, 0.0);
+	std::vector<double> v(cols, 0.0);
+	std::vector<int> col4row(numRows, -1);
+	std::vector<int> row4col(cols, -1);
+
+	std::vector<double> shortest(cols, infinity);
+	std::vector<int> path(cols, -1);
+	std::vector<char> scanned(cols, 0);
+	std::vector<int> touchedCols;
+	std::vector<int> visitedRows;
+	typedef std::pair<double, int> HeapEntry;
+
+	for (int current = 0; current < numRows; current++) {
+		// Dijkstra from the current row over the reduced costs until a free column is reached
+		std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+		touchedCols.clear();
+		visitedRows.clear();
+
+		double minVal = 0.0;
+		int row = current;
+		int sink = -1;
+		while (sink < 0) {
+			visitedRows.push_back(row);
+			for (const Edge& e : rows[row]) {
+				if (scanned[e.col])
+					continue;
+				const double reduced = minVal + e.cost - u[row] - v[e.col];
+				if (reduced < shortest[e.col]) {
+					if (shortest[e.col] == infinity)
+						touchedCols.push_back(e.col);
+					shortest[e.col] = reduced;
+					path[e.col] = row;
+					heap.push(HeapEntry(reduced, e.col));
+				}
+			}
+
+			int col = -1;
+			while (!heap.empty()) {
+				const HeapEntry top = heap.top();
+				heap.pop();
+				if (!scanned[top.second] && top.first == shortest[top.second]) {
+					col = top.second;
+					break;
+				}
+			}
+			// no augmenting path, the row stays unassigned
+			if (col < 0)
+				break;
+
+			minVal = shortest[col];
+			scanned[col] = 1;
+			if (row4col[col] < 0)
+				sink = col;
+			else
+				row = row4col[col];
+		}
+
+		if (sink >= 0) {
+			u[current] += minVal;
+			for (int r : visitedRows) {
+				if (r != current)
+					u[r] += minVal - shortest[col4row[r]];
+			}
+			for (int c : touchedCols) {
+				if (scanned[c])
+					v[c] -= minVal - shortest[c];
+			}
+
+			// flip the matching along the path
+			int col = sink;
+			while (true) {
+				const int r = path[col];
+				row4col[col] = r;
+				std::swap(col4row[r], col);
+				if (r == current)
+					break;
+			}
+		}
+
+		for (int c : touchedCols) {
+			shortest[c] = infinity;
+			path[c] = -1;
+			scanned[c] = 0;
+		}
+	}
+
+	return col4row;
+}
+
+std::vector<int> AssignmentSolver::assignNearest(const std::vector<cv::Point2f>& points, const std::vector<cv::Point2f>& targets, float gate)
+{
+	std::vector<int> result(points.size(), -1);
+	if (points.empty() || targets.empty())
+		return result;
+
+	std::vector<char> used(targets.size(), 0);
+	std::vector<int> leftover;
+
+	if (gate > 0) {
+		// bin the targets into cells of the gate size, so only the 3x3 cells around a point need to be checked
+		std::unordered_map<int64_t, std::vector<int>> grid;
+		for (size_t t = 0; t < targets.size(); t++) {
+			if (std::isfinite(targets[t].x) && std::isfinite(targets[t].y)) {
+				const int64_t x = static_cast<int64_t>(std::floor(targets[t].x / gate));
+				const int64_t y = static_cast<int64_t>(std::floor(targets[t].y / gate));
+				grid[cellKey(x, y)].push_back(static_cast<int>(t));
+			}
+		}
+
+		// every point may also stay unmatched for the cost of the gate, through a column of its own
+		const int numTargets = static_cast<int>(targets.size());
+		std::vector<std::vector<Edge>> edges(points.size());
+		for (size_t p = 0; p < points.size(); p++) {
+			if (std::isfinite(points[p].x) && std::isfinite(points[p].y)) {
+				const int64_t x = static_cast<int64_t>(std::floor(points[p].x / gate));
+				const int64_t y = static_cast<int64_t>(std::floor(points[p].y / gate));
+				for (int64_t dy = -1; dy <= 1; dy++) {
+					for (int64_t dx = -1; dx <= 1; dx++) {
+						auto cell = grid.find(cellKey(x + dx, y + dy));
+						if (cell == grid.end())
+							continue;
+						for (int t : cell->second) {
+							const double d = distance(points[p], targets[t]);
+							if (d <= gate)
+								edges[p].push_back(Edge{ t, d });
+						}
+					}
+				}
+			}
+			edges[p].push_back(Edge{ numTargets + static_cast<int>(p), double(gate) });
+		}
+
+		std::vector<int> assigned = solve(numTargets + static_cast<int>(points.size()), edges);
+		for (size_t p = 0; p < points.size(); p++) {
+			if (assigned[p] >= 0 && assigned[p] < numTargets) {
+				result[p] = assigned[p];
+				used[assigned[p]] = 1;
+			}
+			else {
+				leftover.push_back(static_cast<int>(p));
+			}
+		}
+	}
+	else {
+		for (size_t p = 0; p < points.size(); p++)
+			leftover.push_back(static_cast<int>(p));
+	}
+
+	std::vector<int> remaining;
+	for (size_t t = 0; t < targets.size(); t++) {
+		if (!used[t])
+			remaining.push_back(static_cast<int>(t));
+	}
+	if (leftover.empty() || remaining.empty())
+		return result;
+
+	// match the rest regardless of the distance, with the smaller side as the rows
+	std::vector<cv::Point2f> leftoverPoints;
+	for (int p : leftover)
+		leftoverPoints.push_back(points[p]);
+	std::vector<cv::Point2f> remainingTargets;
+	for (int t : remaining)
+		remainingTargets.push_back(targets[t]);
+
+	if (leftover.size() <= remaining.size()) {
+		std::vector<int> assigned = solveDense(leftoverPoints, remainingTargets);
+		for (size_t i = 0; i < leftover.size(); i++) {
+			if (assigned[i] >= 0)
+				result[leftover[i]] = remaining[assigned[i]];
+		}
+	}
+	else {
+		std::vector<int> assigned = solveDense(remainingTargets, leftoverPoints);
+		for (size_t i = 0; i < remaining.size(); i++) {
+			if (assigned[i] >= 0)
+				result[leftover[assigned[i]]] = remaining[i];
+		}
+	}
+
+	return result;
+}
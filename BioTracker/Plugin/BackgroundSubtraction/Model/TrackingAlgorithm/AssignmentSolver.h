@@ -0,0 +1,40 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+/**
+ * Minimum cost assignment, used to associate the tracked fish with the detected blobs.
+ * The results are deterministic: ties are always resolved towards the lower index.
+ */
+class AssignmentSolver
+{
+public:
+
+	struct Edge
+	{
+		int col;
+		double cost;
+	};
+
+	/**
+	 * Assigns every row to a distinct column so that the summed cost is minimal (shortest augmenting paths with
+	 * a binary heap, after Jonker-Volgenant). Only the given edges are considered, so sparse problems stay cheap.
+	 * Every row has to be assignable, i.e. there has to be a complete matching of the rows.
+	 * @param: cols, the number of columns,
+	 * @param: rows, the edges of every row,
+	 * @return: the column of every row.
+	 */
+	static std::vector<int> solve(int cols, const std::vector<std::vector<Edge>>& rows);
+
+	/**
+	 * Assigns the points to the targets, minimizing the summed distance.
+	 * Pairs closer than gate are found through a uniform grid and matched first. The points left over are then
+	 * matched with the remaining targets regardless of their distance, so as many points as possible are assigned.
+	 * @param: points, the points to assign,
+	 * @param: targets, the targets to assign them to,
+	 * @param: gate, the gating distance, 0 or less matches all pairs at once,
+	 * @return: the target of every point, -1 if there were not enough targets.
+	 */
+	static std::vector<int> assignNearest(const std::vector<cv::Point2f>& points, const std::vector<cv::Point2f>& targets, float gate);
+};
@@ -1,6 +1,7 @@
 #include "NN2dMapper.h"
 
 #include "helper/CvHelper.h"
+#include "AssignmentSolver.h"
 #include <limits>
 #include <tuple>
 #include <utility>
@@ -11,6 +12,7 @@ float dif(float a, float b) {
 
 NN2dMapper::NN2dMapper(TrackedTrajectory *tree) {
 	_tree = tree;
+	_maxDistance = 0;
 
 	//Looks kinda complicated but is a rather simple thing:
 	//For every true trajectory below the tree's root (which are in fact, fish trajectories in out case)
@@ -26,76 +28,43 @@ NN2dMapper::NN2dMapper(TrackedTrajectory *tree) {
 	}
 }
 
-// Functor to compare by the Mth element, as per https://stackoverflow.com/questions/23030267/custom-sorting-a-vector-of-tuples
-struct TupleCompare
-{
-	bool operator()(std::tuple<float, FishPose> a, std::tuple<float, FishPose> b) const {
-		return std::get<0>(a) > std::get<0>(b);
-	}
-
-};
-
 FishPose getFishpose(TrackedTrajectory* traj, uint frameid, uint id) {
     IModelTrackedComponent* comp = traj->getValidChild(id);
     TrackedTrajectory* ct = dynamic_cast<TrackedTrajectory*>(comp);
-    if (ct) {
-        TrackedElement *el = dynamic_cast<TrackedElement*>(ct->getChild(frameid-1));
-        if (el)
-            return el->getFishPose();
-    }
+    if (ct)
+        return ct->getFishPose(frameid-1);
     return FishPose();
 }
 
 std::tuple<std::vector<FishPose>, std::vector<float>> NN2dMapper::getNewPoses(TrackedTrajectory* traj, uint frameid, std::vector<BlobPose> blobPoses) {
-	/* The algorithm seems kinda inefficient, as there is many fish*blobs and fish*fish loops.
-	 * But as N is expected to be pretty small (<10 for fish, <20 for blobs) this seems feasible.
-	*/
 	std::vector<FishPose> blobs = convertBlobPosesToFishPoses(blobPoses);
 
 	int sizeF = traj->validCount();
-	int sizeB = blobs.size();
-	std::vector<std::vector<std::tuple<float, FishPose>>> propMap;
-	
-	//Create propability matrix and sort it
-	for (int i = 0; i < sizeF ; i++) {
-		std::vector<std::tuple<float, FishPose>> currentFish;
-        FishPose cpose = getFishpose(traj, frameid, i);
-		for (int j = 0; j < sizeB ; j++) {
-            currentFish.push_back(std::tuple<float, FishPose>(FishPose::calculateProbabilityOfIdentity(cpose, blobs[j]), blobs[j]));
-		}
-		std::sort(begin(currentFish), end(currentFish), TupleCompare());
-		propMap.push_back(currentFish);
-	}
-
-	//I'm sorry for the goto/inefficient loop. But usually we will not have more than a 
-	//hand full (<6) of blobs to walk through, so it's not worth the optimizing.
-	retry:
-	for (int i = 0; i < propMap.size(); i++) {
-		for (int j = 0; j < propMap.size(); j++) {
-			//Is this 
-			if (!propMap[i].empty() && !propMap[j].empty() && i!=j) {
-				//Reads: If same blob, but i has higher props than j
-				bool samePose = std::get<1>(propMap[i][0]) == std::get<1>(propMap[j][0]);
-				bool propLess = std::get<0>(propMap[i][0]) <= std::get<0>(propMap[j][0]);
-				if (samePose && propLess) {
-					//...then remove the 0'th element from j and try again.
-					propMap[i].erase(propMap[i].begin());
-					goto retry;
-				}
-			}
-		}
+	std::vector<FishPose> lastPoses;
+	std::vector<cv::Point2f> fishPositions;
+	lastPoses.reserve(sizeF);
+	fishPositions.reserve(sizeF);
+	for (int i = 0; i < sizeF; i++) {
+		lastPoses.push_back(getFishpose(traj, frameid, i));
+		fishPositions.push_back(lastPoses.back().position_cm());
 	}
+	std::vector<cv::Point2f> blobPositions;
+	blobPositions.reserve(blobs.size());
+	for (const FishPose& blob : blobs)
+		blobPositions.push_back(blob.position_cm());
 
+	//Match fish and blobs such that the summed distance is minimal
+	std::vector<int> matches = AssignmentSolver::assignNearest(fishPositions, blobPositions, _maxDistance);
 
 	std::vector<float> bestMatchesProps;
 	std::vector<FishPose> bestMatchesPoses;
-	for (int i = 0; i < propMap.size(); i++) {
-		if (propMap[i].size() > 0) {
-			bestMatchesProps.push_back(std::get<0>(propMap[i][0]));
-			bestMatchesPoses.push_back(std::get<1>(propMap[i][0]));
+	for (int i = 0; i < sizeF; i++) {
+		if (matches[i] >= 0) {
+			bestMatchesProps.push_back(FishPose::calculateProbabilityOfIdentity(lastPoses[i], blobs[matches[i]]));
+			bestMatchesPoses.push_back(blobs[matches[i]]);
 		}
 		else {
-			bestMatchesPoses.push_back(getFishpose(traj, frameid, i));
+			bestMatchesPoses.push_back(lastPoses[i]);
 			bestMatchesProps.push_back(100);
 		}
 	}
@@ -252,10 +221,9 @@ float NN2dMapper::estimateOrientationRad(int trackid, float *confidence)
 
 	//std::deque<FishPose>::const_reverse_iterator iter = _histComponents.rbegin();
 	int start = std::max(t->size()-20, 0);
-	TrackedElement* e = (TrackedElement*)t->getChild(start);
-	if (!e)
+	if (!t->hasPose(start))
 		return std::numeric_limits<float>::quiet_NaN();
-	cv::Point2f nextPoint = e->getFishPose().position_cm();
+	cv::Point2f nextPoint = t->getFishPose(start).position_cm();
 	cv::Point2f positionDerivative(0.0f, 0.0f);
 
 	// weights the last poses with falloff^k * pose[end - k] until falloff^k < falloffMargin
@@ -267,10 +235,9 @@ float NN2dMapper::estimateOrientationRad(int trackid, float *confidence)
 
 	for (int i=start+1; i<t->size(); i++)
 	{
-		TrackedElement* ecur = (TrackedElement*)t->getChild(i);
-		if (!ecur)
+		if (!t->hasPose(i))
 			return std::numeric_limits<float>::quiet_NaN();
-		cv::Point2f currentPoint = ecur->getFishPose().position_cm();
+		cv::Point2f currentPoint = t->getFishPose(i).position_cm();
 		const cv::Point2f oneStepDerivative = nextPoint - currentPoint;
 
 		positionDerivative += currentWeight * oneStepDerivative;
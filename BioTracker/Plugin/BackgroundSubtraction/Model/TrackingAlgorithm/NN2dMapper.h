@@ -19,7 +19,18 @@ public:
 
 	~NN2dMapper(void) {};
 	
+	/**
+	 * Assigns the blobs to the fish, minimizing the summed distance to their last positions.
+	 * Fish without a blob keep their last pose.
+	 */
 	std::tuple<std::vector<FishPose>, std::vector<float>> getNewPoses(TrackedTrajectory* traj, uint frameid, std::vector<BlobPose> blobPoses);
+
+	/**
+	 * Sets the distance in cm within which blobs are searched for a fish first, 0 or less searches all blobs at once.
+	 * Fish without a blob that close are matched with the remaining blobs afterwards.
+	 */
+	void setMaxDistance(float x) { _maxDistance = x; }
+
 	std::vector<FishPose> convertBlobPosesToFishPoses(std::vector<BlobPose> blobPoses);
 	float estimateOrientationRad(int trackid, float *confidence);
 	bool correctAngle(int trackid, FishPose &pose);
@@ -28,6 +39,7 @@ public:
 	TrackedTrajectory *_tree;
 
 protected:
+	float _maxDistance;
 
 };
 
@@ -27,6 +27,11 @@ namespace TRACKERPARAM
 	// Blob dectection issue
 	const std::string MAX_BLOB_SIZE					= "TRACKERPARAM/MAX_BLOB_SIZE";
 	const std::string MIN_BLOB_SIZE					= "TRACKERPARAM/MIN_BLOB_SIZE";
+	// one of TrackerParameter::BlobDetector
+	const std::string BLOB_DETECTOR					= "TRACKERPARAM/BLOB_DETECTOR";
+
+	// Distance in cm within which blobs are matched with a fish first
+	const std::string MAX_ASSIGNMENT_DISTANCE		= "TRACKERPARAM/MAX_ASSIGNMENT_DISTANCE";
 
 	// Parameters for image pre-processing step
 	const std::string SIZE_ERODE					= "TRACKERPARAM/SIZE_ERODE";
@@ -82,5 +87,10 @@ namespace FISHTANKPARAM
     const std::string FISHTANK_AREA_CORNER4 = "FISHTANKPARAM/FISHTANK_AREA_CORNER4";
     const std::string FISHTANK_ENABLE_NETWORKING = "FISHTANKPARAM/FISHTANK_ENABLE_NETWORKING";
     const std::string FISHTANK_NETWORKING_PORT = "FISHTANKPARAM/FISHTANK_NETWORKING_PORT";
+    // 0: text lines, 1: binary records, see TcpListener
+    const std::string FISHTANK_NETWORKING_PROTOCOL = "FISHTANKPARAM/FISHTANK_NETWORKING_PROTOCOL";
+    // Frames and poses for processes on the same host, see SharedMemoryPublisher
+    const std::string FISHTANK_ENABLE_SHAREDMEMORY = "FISHTANKPARAM/FISHTANK_ENABLE_SHAREDMEMORY";
+    const std::string FISHTANK_SHAREDMEMORY_NAME = "FISHTANKPARAM/FISHTANK_SHAREDMEMORY_NAME";
 }
 
@@ -0,0 +1,201 @@
+#include "ComponentBlobsDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+	/**
+	 * Sum of k^2 for k in [0, n].
+	 */
+	inline int64_t sumOfSquares(int64_t n)
+	{
+		return n * (n + 1) * (2 * n + 1) / 6;
+	}
+
+	/**
+	 * The ellipse of a blob from its moments, following CBlob::GetEllipse.
+	 */
+	cv::RotatedRect ellipseFromMoments(double m00, double m10, double m01, double m11, double m20, double m02)
+	{
+		cv::RotatedRect ellipse(cv::Point2f(0, 0), cv::Size2f(0, 0), 0);
+		if (m00 <= 0)
+			return ellipse;
+
+		// central moments
+		const double u11 = -(m11 - m10 * m01 / m00) / m00;
+		const double u20 = (m20 - m10 * m10 / m00) / m00;
+		const double u02 = (m02 - m01 * m01 / m00) / m00;
+
+		const double delta = std::sqrt(4 * u11 * u11 + (u20 - u02) * (u20 - u02));
+		ellipse.center = cv::Point2f(float(m10 / m00), float(m01 / m00));
+
+		if (u20 + u02 + delta <= 0)
+			return ellipse;
+		ellipse.size.width = float(std::sqrt(2 * (u20 + u02 + delta)));
+
+		if (u20 + u02 - delta <= 0)
+			return ellipse;
+		ellipse.size.height = float(std::sqrt(2 * (u20 + u02 - delta)));
+
+		double num, den;
+		if (u20 > u02) {
+			num = u02 - u20 + std::sqrt((u02 - u20) * (u02 - u20) + 4 * u11 * u11);
+			den = 2 * u11;
+		}
+		else {
+			num = 2 * u11;
+			den = u20 - u02 + std::sqrt((u20 - u02) * (u20 - u02) + 4 * u11 * u11);
+		}
+		if (num != 0 && den != 0)
+			ellipse.angle = float(180.0 + (180.0 / CV_PI) * std::atan(num / den));
+
+		return ellipse;
+	}
+}
+
+ComponentBlobsDetector::ComponentBlobsDetector(void) :
+	_minBlobSize(1),
+	_maxBlobSize(99999),
+	_mask(nullptr)
+{}
+
+int ComponentBlobsDetector::findRoot(int label)
+{
+	while (_components[label].parent != label) {
+		// path halving
+		_components[label].parent = _components[_components[label].parent].parent;
+		label = _components[label].parent;
+	}
+	return label;
+}
+
+void ComponentBlobsDetector::unite(int a, int b)
+{
+	int rootA = findRoot(a);
+	int rootB = findRoot(b);
+	if (rootA == rootB)
+		return;
+	// the older label stays the root
+	if (rootB < rootA)
+		std::swap(rootA, rootB);
+
+	Component& root = _components[rootA];
+	const Component& child = _components[rootB];
+	root.area += child.area;
+	root.sumX += child.sumX;
+	root.sumY += child.sumY;
+	root.sumXX += child.sumXX;
+	root.sumYY += child.sumYY;
+	root.sumXY += child.sumXY;
+	root.minX = std::min(root.minX, child.minX);
+	root.minY = std::min(root.minY, child.minY);
+	root.maxX = std::max(root.maxX, child.maxX);
+	root.maxY = std::max(root.maxY, child.maxY);
+	_components[rootB].parent = rootA;
+}
+
+void ComponentBlobsDetector::labelComponents(const cv::Mat& binImage)
+{
+	_components.clear();
+	_previousRuns.clear();
+
+	const bool useMask = _mask && !_mask->empty() && _mask->size() == binImage.size();
+
+	for (int y = 0; y < binImage.rows; y++) {
+		const uchar* row = binImage.ptr<uchar>(y);
+		const uchar* maskRow = useMask ? _mask->ptr<uchar>(y) : nullptr;
+		_currentRuns.clear();
+
+		size_t above = 0;
+		int x = 0;
+		while (x < binImage.cols) {
+			while (x < binImage.cols && (!row[x] || (maskRow && !maskRow[x])))
+				x++;
+			if (x == binImage.cols)
+				break;
+			const int begin = x;
+			while (x < binImage.cols && row[x] && (!maskRow || maskRow[x]))
+				x++;
+			const int end = x - 1;
+
+			const int label = static_cast<int>(_components.size());
+			const int64_t length = end - begin + 1;
+			Component c;
+			c.parent = label;
+			c.area = length;
+			c.sumX = length * (begin + end) / 2;
+			c.sumY = length * y;
+			c.sumXX = sumOfSquares(end) - sumOfSquares(begin - 1);
+			c.sumYY = length * y * y;
+			c.sumXY = c.sumX * y;
+			c.minX = begin;
+			c.minY = y;
+			c.maxX = end;
+			c.maxY = y;
+			_components.push_back(c);
+			_currentRuns.push_back(Run{ begin, end, label });
+
+			// merge with the runs above touching this one, diagonally included
+			while (above < _previousRuns.size() && _previousRuns[above].end < begin - 1)
+				above++;
+			for (size_t i = above; i < _previousRuns.size() && _previousRuns[i].begin <= end + 1; i++)
+				unite(label, _previousRuns[i].label);
+		}
+
+		std::swap(_previousRuns, _currentRuns);
+	}
+}
+
+std::vector<BlobPose> ComponentBlobsDetector::findBlobs(const cv::Mat& binImage, const cv::Mat& oriImage)
+{
+	std::vector<BlobPose> blobPoses;
+
+	labelComponents(binImage);
+
+	for (int i = 0; i < static_cast<int>(_components.size()); i++)
+	{
+		const Component& c = _components[i];
+		if (c.parent != i)
+			continue;
+
+		// filter the blobs by size criteria
+		if (c.area < minBlobSize() || c.area > maxBlobSize())
+			continue;
+
+		cv::RotatedRect ellipse = ellipseFromMoments(double(c.area), double(c.sumX), double(c.sumY),
+			double(c.sumXY), double(c.sumXX), double(c.sumYY));
+
+		// gets blob center
+		cv::Point blobPose_px = cv::Point(int(ellipse.center.x), int(ellipse.center.y));
+
+		// ignore blobs outside the tracking area
+		if (!_areaInfo->inTrackingArea(blobPose_px))
+			continue;
+
+		// apply homography
+		cv::Point2f blobPose_cm = _areaInfo->pxToCm(blobPose_px);
+
+		blobPoses.push_back(BlobPose(blobPose_cm, blobPose_px, ellipse.angle, ellipse.size.width, ellipse.size.height));
+	}
+
+	return blobPoses;
+}
+
+std::vector<BlobPose> ComponentBlobsDetector::getPoses(cv::Mat& binImage, cv::Mat& oriImage)
+{
+	return findBlobs(binImage, oriImage);
+}
+
+void ComponentBlobsDetector::setDouble(std::string spec_param, double value)
+{
+	if (spec_param.compare("1") == 0) {
+		this->setMinBlobSize(value);
+	}
+	else if (spec_param.compare("999999") == 0) {
+		this->setMaxBlobSize(value);
+	}
+	else {
+		std::cout << "ComponentBlobsDetector::Warning - Parameter: " << spec_param << " not found!" << std::endl;
+	}
+}
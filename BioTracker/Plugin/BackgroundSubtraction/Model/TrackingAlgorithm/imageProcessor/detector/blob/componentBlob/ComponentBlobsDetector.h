@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Model/TrackingAlgorithm/imageProcessor/detector/IDetector.h"
+
+#include "Model/TrackingAlgorithm/imageProcessor/detector/blob/BlobPose.h"
+
+#include <cstdint>
+
+/**
+ * Blob detector labeling the 8-connected components of the binarized image in a single scan.
+ * The foreground of every row is split into runs, which are merged with the overlapping runs of the row above
+ * by union-find. Area, bounding box and the moments up to second order are accumulated per label during the same
+ * scan, and the ellipse of each blob is derived from its second order central moments the same way as
+ * CBlob::GetEllipse does. Unlike BlobsDetector no contours are traced.
+ */
+class ComponentBlobsDetector : public IDetector<BlobPose>
+{
+public:
+
+	/**
+	 * The standard constructor.
+	 */
+	ComponentBlobsDetector(void);
+
+	virtual ~ComponentBlobsDetector(void) {}
+
+	void setMask(cv::Mat *mask) { _mask = mask; }
+
+	std::vector<BlobPose> getPoses(cv::Mat& binImage, cv::Mat& oriImage);
+
+	void setDouble(std::string spec_param, double value);
+
+	double minBlobSize() { return _minBlobSize; };
+	double maxBlobSize() { return _maxBlobSize; };
+	void setMinBlobSize(double x) { _minBlobSize = x; };
+	void setMaxBlobSize(double x) { _maxBlobSize = x; };
+
+private:
+
+	/**
+	 * A horizontal run [begin, end] of foreground pixels and its label.
+	 */
+	struct Run
+	{
+		int begin;
+		int end;
+		int label;
+	};
+
+	/**
+	 * The statistics accumulated per label, the sums are over the pixel coordinates.
+	 */
+	struct Component
+	{
+		int parent;
+		int64_t area;
+		int64_t sumX;
+		int64_t sumY;
+		int64_t sumXX;
+		int64_t sumYY;
+		int64_t sumXY;
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+	};
+
+	/**
+	 * Labels the image and accumulates the statistics of all components into _components.
+	 * @param: binImage, the binarized image, every pixel != 0 is foreground.
+	 */
+	void labelComponents(const cv::Mat& binImage);
+
+	int findRoot(int label);
+	void unite(int a, int b);
+
+	/**
+	 * Find all blobs within an image.
+	 * @param: binarized_image_mat, image contains blobs and is already binarized,
+	 * @return: all found blobs within the image.
+	 */
+	std::vector<BlobPose> findBlobs(const cv::Mat& binImage, const cv::Mat& oriImage);
+
+	double _minBlobSize;
+	double _maxBlobSize;
+
+	cv::Mat *_mask;
+
+	// kept between frames to avoid reallocating them
+	std::vector<Component> _components;
+	std::vector<Run> _previousRuns;
+	std::vector<Run> _currentRuns;
+};
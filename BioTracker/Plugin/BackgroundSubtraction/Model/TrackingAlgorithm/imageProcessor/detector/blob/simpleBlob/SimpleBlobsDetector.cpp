@@ -92,11 +92,7 @@ void SimpleBlobsDetector::setDouble(std::string spec_param, double value)
 {	
 	if(spec_param.compare("1") == 0) { //TRACKERPARAM::MIN_BLOB_SIZE
 		_params.minArea = value;
-	} else {
-		std::cout << "SimpleBlobsDetector::Warning - Parameter: " << spec_param << " not found!" << std::endl;
-	}
-
-	if(spec_param.compare("999999") == 0) { //TRACKERPARAM::MAX_BLOB_SIZE
+	} else if(spec_param.compare("999999") == 0) { //TRACKERPARAM::MAX_BLOB_SIZE
 		_params.maxArea = value;
 	} else {
 		std::cout << "SimpleBlobsDetector::Warning - Parameter: " << spec_param << " not found!" << std::endl;
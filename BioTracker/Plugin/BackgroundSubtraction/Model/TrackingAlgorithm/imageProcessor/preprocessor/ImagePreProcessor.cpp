@@ -1,8 +1,13 @@
 #include "ImagePreProcessor.h"
+#include "PreProcessKernel.h"
+#include "helper/ThreadPool.h"
 
 #include <opencv2/highgui.hpp>
 
-#include <future>
+#include <algorithm>
+#ifdef __unix__
+#include <unistd.h>
+#endif
 #include <QMutex>
 
 QMutex bgsMutex;
@@ -40,7 +45,7 @@ void ImagePreProcessor::init()
 	QMutexLocker locker(&bgsMutex);
 
 	m_backgroundImage = std::make_shared<cv::Mat>();
-	m_foregroundImage = std::make_shared<cv::Mat>();
+	m_spareBackgroundImage = std::make_shared<cv::Mat>();
 	
 	_pMOG = cv::createBackgroundSubtractorMOG2(
 		_TrackingParameter->getmog2History(),
@@ -56,149 +61,109 @@ void ImagePreProcessor::init()
 	_resetBackgroundImageEnabled = false;
 }
 
-cv::Mat ImagePreProcessor::binarize(cv::Mat& image)
-{
-	//cv::cvtColor( image, grayImage, CV_BGR2GRAY );
-
-	cv::Mat binarizedImage;
-
-	if (image.channels() >= 3)
-		cv::cvtColor(image, binarizedImage, CV_BGR2GRAY);
-	else
-		image.copyTo(binarizedImage);
-
-	if (binarizedImage.data)
-		cv::threshold(binarizedImage, binarizedImage, m_TrackingParameter->getBinarizationThreshold(), 255, cv::THRESH_BINARY);
-
-	return binarizedImage;
-}
-
-cv::Mat ImagePreProcessor::erode(cv::Mat& image)
-{
-	cv::Mat erodedImage;
-	cv::Mat erodeKernel;
-	int sizeErode = m_TrackingParameter->getSizeErode();
-	if (sizeErode > 0)
+namespace {
+	size_t getL2CacheSize()
 	{
-		erodeKernel = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(sizeErode, sizeErode));
-	}
-	else {
-		return image;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+		const long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+		if (size > 0)
+			return static_cast<size_t>(size);
+#endif
+		return 256 * 1024;
 	}
-	if (image.data)
-		cv::erode(image, erodedImage, erodeKernel);
-	return erodedImage;
-}
-
-cv::Mat ImagePreProcessor::dilate(cv::Mat& image)
-{
-	cv::Mat dilatedImage;
-	cv::Mat dilateKernel;
-	int sizeDilate = m_TrackingParameter->getSizeDilate();
-	if (sizeDilate > 0)
-	{
-		dilateKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(sizeDilate, sizeDilate));
-	}
-	else {
-		return image;
-	}
-	if (image.data)
-		cv::dilate(image, dilatedImage, dilateKernel);
-	return dilatedImage;
-}
 
-cv::Mat ImagePreProcessor::backgroundSubtraction(cv::Mat& image)
-{
-	if (false)//(isEnabledMog2())
+	/**
+	 * The number of rows per band: a few bands per thread, so idle threads can steal the rest,
+	 * but small enough that the rows a band reads and writes stay in the L2 cache,
+	 * and large enough that the rows recomputed for the morphology don't dominate.
+	 */
+	int getBandHeight(const cv::Mat& image, const PreProcessKernelParams& params, int threads)
 	{
-		//QMutexLocker locker(&bgsMutex);
-		cv::Mat fgMaskMOG;
-		_pMOG->setBackgroundRatio(m_TrackingParameter->getmog2BackgroundRatio());
-
-		_pMOG->apply(image, fgMaskMOG); //fg mask generated by MOG method		
-		_pMOG->getBackgroundImage(*m_backgroundImage);
-		return fgMaskMOG;
+		static const size_t l2CacheSize = getL2CacheSize();
+		// source, greyscale, both backgrounds and the foreground
+		const size_t bytesPerRow = static_cast<size_t>(image.cols) * (image.channels() + 4);
+		const int cachedRows = static_cast<int>(std::max<size_t>(l2CacheSize / std::max<size_t>(bytesPerRow, 1), 1));
+		const int halo = std::max(params.sizeErode, 0) + std::max(params.sizeDilate, 0);
+
+		int height = (image.rows + 4 * threads - 1) / (4 * threads);
+		height = std::min(height, cachedRows);
+		height = std::max(height, 2 * halo);
+		return std::max(height, 1);
 	}
 
-	// otherwise, custom background subtraction
-
-	if (!m_backgroundImage->data)
-		image.copyTo(*m_backgroundImage);
-
-	// calculate the image difference
-	const double alpha = m_TrackingParameter->getmog2BackgroundRatio();
-
-	const int &imageWidth = m_backgroundImage->cols;
-	const int &imageHeight = m_backgroundImage->rows;
-	const int totalRegionsX = 4;
-	const int totalRegionsY = 4;
-	const int totalRegions = totalRegionsX * totalRegionsY;
-	const int regionWidth = imageWidth / totalRegionsX;
-	const int regionHeight = imageHeight / totalRegionsY;
-
-	cv::Mat results(imageHeight, imageWidth, image.type());
-
-	auto workOnRegion = [&](int x, int y) {
-		const int startingX = x * regionWidth;
-		const int startingY = y * regionHeight;
-		const cv::Rect subArea = cv::Rect(startingX, startingY, regionWidth, regionHeight);
-		cv::Mat subBackground = (*m_backgroundImage)(subArea);
-		cv::Mat subImage = image(subArea);
-		cv::Mat subResults = results(subArea);
-
-		subResults = (subBackground - subImage);
-		subBackground = (1.0 - alpha) * subBackground + alpha * subImage;
-	};
-
-	std::vector<std::future<void>> merger;
-	merger.reserve(totalRegions);
-
-	for (int x = 0; x < totalRegionsX; ++x)
+	/**
+	 * Makes the buffer a CV_8UC1 image of the given size, reusing its memory unless it is still referenced elsewhere,
+	 * be it through another shared_ptr or a cv::Mat header sharing the pixels, e.g. a texture showing it.
+	 */
+	void prepareBuffer(std::shared_ptr<cv::Mat>& buffer, cv::Size size)
 	{
-		for (int y = 0; y < totalRegionsY; ++y)
-		{
-			merger.push_back(std::async([&, x, y] { workOnRegion(x, y); }));
-		}
+		// the Mat's count is changed atomically in other threads, read it the same way
+		if (!buffer || buffer.use_count() > 1 || (buffer->u && CV_XADD(&buffer->u->refcount, 0) > 1))
+			buffer = std::make_shared<cv::Mat>();
+		buffer->create(size, CV_8UC1);
 	}
-
-	for (const auto & asyncResult : merger)
-		asyncResult.wait();
-
-	return results;
 }
 
-std::map<std::string, std::shared_ptr<cv::Mat>> ImagePreProcessor::preProcess(std::shared_ptr<cv::Mat> p_image)
+ImagePreProcessor::PreProcessedImages ImagePreProcessor::preProcess(std::shared_ptr<cv::Mat> p_image, int selectedImage)
 {
-	std::shared_ptr<cv::Mat> greyMat		= std::make_shared<cv::Mat>();
-	std::shared_ptr<cv::Mat> binarizedImage = std::make_shared<cv::Mat>();
-	std::shared_ptr<cv::Mat> erodedImage	= std::make_shared<cv::Mat>();
-	std::shared_ptr<cv::Mat> dilatedImage	= std::make_shared<cv::Mat>();
-	//cv::Mat test;
-
-	cv::cvtColor(*p_image, *greyMat, CV_BGR2GRAY);
-	//cv::cvtColor(*p_image, test, CV_BGR2GRAY);
-	
-	// 1. step: do the background subtraction
-	*m_foregroundImage = backgroundSubtraction(*greyMat);
-
-	// 2. step: binarize the image 
-	*binarizedImage = binarize(*m_foregroundImage);
-
-	// 3. step: erode the image
-	*erodedImage = erode(*binarizedImage);
-
-	// 4. step: dilate the image
-	*dilatedImage = dilate(*erodedImage);
-
-	std::map<std::string, std::shared_ptr<cv::Mat>> all;
-	all.insert(std::pair<std::string, std::shared_ptr<cv::Mat>>(std::string("Greyscale"), greyMat));
-	all.insert(std::pair<std::string, std::shared_ptr<cv::Mat>>(std::string("Background"), m_backgroundImage));
-	all.insert(std::pair<std::string, std::shared_ptr<cv::Mat>>(std::string("Difference"), m_foregroundImage));
-	all.insert(std::pair<std::string, std::shared_ptr<cv::Mat>>(std::string("Binarized"), binarizedImage));
-	all.insert(std::pair<std::string, std::shared_ptr<cv::Mat>>(std::string("Eroded"), erodedImage));
-	all.insert(std::pair<std::string, std::shared_ptr<cv::Mat>>(std::string("Dilated"), dilatedImage));
+	const cv::Size size = p_image->size();
+
+	// a new or resized background starts out as the current image
+	if (m_backgroundImage->empty() || m_backgroundImage->size() != size) {
+		m_backgroundImage = std::make_shared<cv::Mat>();
+		if (p_image->channels() == 4)
+			cv::cvtColor(*p_image, *m_backgroundImage, CV_BGRA2GRAY);
+		else if (p_image->channels() == 3)
+			cv::cvtColor(*p_image, *m_backgroundImage, CV_BGR2GRAY);
+		else
+			p_image->copyTo(*m_backgroundImage);
+	}
 
-	return all;
+	prepareBuffer(m_greyscaleImage, size);
+	prepareBuffer(m_foregroundImage, size);
+	prepareBuffer(m_spareBackgroundImage, size);
+
+	const bool intermediate = selectedImage == IMAGE_BINARIZED || selectedImage == IMAGE_ERODED || selectedImage == IMAGE_DIFFERENCE;
+	if (intermediate)
+		prepareBuffer(m_selectedImage, size);
+
+	PreProcessKernelParams params;
+	params.binarizationThreshold = m_TrackingParameter->getBinarizationThreshold();
+	params.sizeErode = m_TrackingParameter->getSizeErode();
+	params.sizeDilate = m_TrackingParameter->getSizeDilate();
+	params.backgroundRatio = m_TrackingParameter->getmog2BackgroundRatio();
+
+	PreProcessKernelImages images;
+	images.source = p_image.get();
+	images.background = m_backgroundImage.get();
+	images.updatedBackground = m_spareBackgroundImage.get();
+	images.greyscale = m_greyscaleImage.get();
+	images.foreground = m_foregroundImage.get();
+	images.difference = selectedImage == IMAGE_DIFFERENCE ? m_selectedImage.get() : nullptr;
+	images.binarized = selectedImage == IMAGE_BINARIZED ? m_selectedImage.get() : nullptr;
+	images.eroded = selectedImage == IMAGE_ERODED ? m_selectedImage.get() : nullptr;
+
+	// the bands only read the old background, so they need no synchronization
+	ThreadPool& pool = ThreadPool::instance();
+	const int bandHeight = getBandHeight(*p_image, params, static_cast<int>(pool.concurrency()));
+	const int totalBands = (size.height + bandHeight - 1) / bandHeight;
+
+	pool.parallelFor(totalBands, [&](int band) {
+		preProcessRows(images, params, band * bandHeight, (band + 1) * bandHeight);
+	});
+
+	std::swap(m_backgroundImage, m_spareBackgroundImage);
+
+	PreProcessedImages result;
+	result.greyscale = m_greyscaleImage;
+	result.foreground = m_foregroundImage;
+	if (intermediate)
+		result.selected = m_selectedImage;
+	else if (selectedImage == IMAGE_DILATED)
+		result.selected = m_foregroundImage;
+	else if (selectedImage == IMAGE_BACKGROUND)
+		result.selected = m_backgroundImage;
+	return result;
 }
 
 void ImagePreProcessor::resetBackgroundImage()
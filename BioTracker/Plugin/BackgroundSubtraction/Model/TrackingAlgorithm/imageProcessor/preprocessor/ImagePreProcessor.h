@@ -30,45 +30,38 @@ public:
 	void init();
 
 	/**
-	 * A computer vision method to binarize an image.
-	 * @param: image, image to binarize,
-	 * @return: a binarized image.
+	 * The images the tracking can ask to be displayed, as selected by TrackerParameter::getSendImage.
 	 */
-	cv::Mat binarize(cv::Mat& image);
+	enum SelectedImage {
+		IMAGE_NONE = 0,
+		IMAGE_BINARIZED = 1,
+		IMAGE_ERODED = 2,
+		IMAGE_DILATED = 3,
+		IMAGE_DIFFERENCE = 4,
+		IMAGE_BACKGROUND = 5
+	};
+
+	struct PreProcessedImages {
+		std::shared_ptr<cv::Mat> greyscale;
+		// the binarized, eroded and dilated background difference
+		std::shared_ptr<cv::Mat> foreground;
+		// the image requested by selectedImage, nullptr for IMAGE_NONE
+		std::shared_ptr<cv::Mat> selected;
+	};
 
 	/**
-	 * A mathematical morphology operation using in computer vision to erode an image.
-	 * Erode image with 3x3 4-connectivity.
-	 * @param: image, image to erode,
-	 * @return: an eroded image.
-	 */
-	cv::Mat erode(cv::Mat& image);	
-
-	/**
-	 * A mathematical morphology operation using in computer vision to dilate an image.
-	 * Dilate image with 6x6 8-connectivity.
-	 * @param: image, image to dilate,
-	 * @return: a dilated image.
-	 */
-	cv::Mat dilate(cv::Mat& image);
-
-	/**
-	 * A computer vision methode to calculate the image difference.
-	 * Background image subtracts the foreground image.
-	 * @param: image, image to background subtract,
-	 * @return: the background subtracted image.
-	 */
-	cv::Mat backgroundSubtraction(cv::Mat& image);
-
-	/**
-	 * Pre-process an image, if all methods enabled, this function:
-	 * - does the background subtraction
+	 * Pre-process an image in a single pass over it (see preProcessRows):
+	 * - does the background subtraction and updates the background
+	 * - binarizes the difference
 	 * - erodes the image
 	 * - dilates the image
+	 * Only the intermediate image given by selectedImage is materialized.
+	 * The returned images are reused for the next frame unless they are still referenced elsewhere.
 	 * @param: image, image to process,
-	 * @return: a pre-process image.
+	 * @param: selectedImage, one of SelectedImage,
+	 * @return: the pre-processed images.
 	 */
-	std::map<std::string, std::shared_ptr<cv::Mat>> preProcess(std::shared_ptr<cv::Mat> p_image);
+	PreProcessedImages preProcess(std::shared_ptr<cv::Mat> p_image, int selectedImage);
 
 	/**
 	 * The method updates the image background.
@@ -84,7 +77,11 @@ private:
 
 	int m_Mog2ShadowDetection = true;
 	std::shared_ptr<cv::Mat> m_backgroundImage;
+	// the background is updated into this one, then both are swapped
+	std::shared_ptr<cv::Mat> m_spareBackgroundImage;
+	std::shared_ptr<cv::Mat> m_greyscaleImage;
 	std::shared_ptr<cv::Mat> m_foregroundImage;
+	std::shared_ptr<cv::Mat> m_selectedImage;
 
 	// background subtraction
 	cv::Ptr<cv::BackgroundSubtractorMOG2> _pMOG;
@@ -0,0 +1,300 @@
+#include "PreProcessKernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PREPROCESS_NEON
+#endif
+
+namespace {
+
+	struct MinOp
+	{
+		static uchar apply(uchar a, uchar b) { return std::min(a, b); }
+#if defined(__AVX2__)
+		static __m256i apply(__m256i a, __m256i b) { return _mm256_min_epu8(a, b); }
+#elif defined(PREPROCESS_NEON)
+		static uint8x16_t apply(uint8x16_t a, uint8x16_t b) { return vminq_u8(a, b); }
+#endif
+	};
+
+	struct MaxOp
+	{
+		static uchar apply(uchar a, uchar b) { return std::max(a, b); }
+#if defined(__AVX2__)
+		static __m256i apply(__m256i a, __m256i b) { return _mm256_max_epu8(a, b); }
+#elif defined(PREPROCESS_NEON)
+		static uint8x16_t apply(uint8x16_t a, uint8x16_t b) { return vmaxq_u8(a, b); }
+#endif
+	};
+
+	/**
+	 * out[x] = Op over rows[i][x] for all i < count.
+	 */
+	template<typename Op>
+	void combineRows(const uchar* const* rows, int count, uchar* out, int width)
+	{
+		int x = 0;
+#if defined(__AVX2__)
+		for (; x + 32 <= width; x += 32) {
+			__m256i v = _mm256_loadu_si256((const __m256i*)(rows[0] + x));
+			for (int i = 1; i < count; i++)
+				v = Op::apply(v, _mm256_loadu_si256((const __m256i*)(rows[i] + x)));
+			_mm256_storeu_si256((__m256i*)(out + x), v);
+		}
+#elif defined(PREPROCESS_NEON)
+		for (; x + 16 <= width; x += 16) {
+			uint8x16_t v = vld1q_u8(rows[0] + x);
+			for (int i = 1; i < count; i++)
+				v = Op::apply(v, vld1q_u8(rows[i] + x));
+			vst1q_u8(out + x, v);
+		}
+#endif
+		for (; x < width; x++) {
+			uchar v = rows[0][x];
+			for (int i = 1; i < count; i++)
+				v = Op::apply(v, rows[i][x]);
+			out[x] = v;
+		}
+	}
+
+	/**
+	 * out[x] = Op over in[x - anchor + k] for all k < size.
+	 * in has to be padded by size on both sides with the neutral element of Op.
+	 */
+	template<typename Op>
+	void combineWindow(const uchar* in, int size, int anchor, uchar* out, int width)
+	{
+		const uchar* first = in - anchor;
+		int x = 0;
+#if defined(__AVX2__)
+		for (; x + 32 <= width; x += 32) {
+			__m256i v = _mm256_loadu_si256((const __m256i*)(first + x));
+			for (int k = 1; k < size; k++)
+				v = Op::apply(v, _mm256_loadu_si256((const __m256i*)(first + x + k)));
+			_mm256_storeu_si256((__m256i*)(out + x), v);
+		}
+#elif defined(PREPROCESS_NEON)
+		for (; x + 16 <= width; x += 16) {
+			uint8x16_t v = vld1q_u8(first + x);
+			for (int k = 1; k < size; k++)
+				v = Op::apply(v, vld1q_u8(first + x + k));
+			vst1q_u8(out + x, v);
+		}
+#endif
+		for (; x < width; x++) {
+			uchar v = first[x];
+			for (int k = 1; k < size; k++)
+				v = Op::apply(v, first[x + k]);
+			out[x] = v;
+		}
+	}
+
+#if defined(__AVX2__)
+	/**
+	 * Running average of 16 pixels widened to 16 bit, in the same fixed point arithmetic as the scalar loop.
+	 */
+	inline __m256i blend16(__m256i background, __m256i grey, __m256i alpha)
+	{
+		const __m256i delta = _mm256_slli_epi16(_mm256_sub_epi16(grey, background), 7);
+		const __m256i v = _mm256_add_epi16(_mm256_slli_epi16(background, 7), _mm256_mulhrs_epi16(delta, alpha));
+		return _mm256_srai_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(64)), 7);
+	}
+#elif defined(PREPROCESS_NEON)
+	/**
+	 * Running average of 8 pixels, in the same fixed point arithmetic as the scalar loop.
+	 */
+	inline uint8x8_t blend8(uint8x8_t background, uint8x8_t grey, int16x8_t alpha)
+	{
+		const int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(background));
+		const int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(grey));
+		// vqrdmulh rounds like _mm256_mulhrs_epi16
+		const int16x8_t v = vaddq_s16(vshlq_n_s16(b, 7), vqrdmulhq_s16(vshlq_n_s16(vsubq_s16(g, b), 7), alpha));
+		return vqmovun_s16(vshrq_n_s16(vaddq_s16(v, vdupq_n_s16(64)), 7));
+	}
+#endif
+
+	/**
+	 * Background difference, binarization and background update of one row.
+	 * The background is updated as background + alpha * (grey - background), with alpha in Q15 and the product
+	 * kept with 7 fractional bits, which fits all intermediate values into 16 bit.
+	 * updated and difference may be nullptr.
+	 */
+	void subtractRow(const uchar* grey, const uchar* background, uchar* updated, uchar* difference, uchar* binarized,
+		int width, int threshold, short alpha)
+	{
+		int x = 0;
+		// thresholds outside of [0, 255) set all or no pixels, which is left to the scalar loop
+		if (threshold >= 0 && threshold < 255) {
+#if defined(__AVX2__)
+			const __m256i limit = _mm256_set1_epi8(char(threshold + 1));
+			const __m256i weight = _mm256_set1_epi16(alpha);
+			const __m256i zero = _mm256_setzero_si256();
+			for (; x + 32 <= width; x += 32) {
+				const __m256i g = _mm256_loadu_si256((const __m256i*)(grey + x));
+				const __m256i b = _mm256_loadu_si256((const __m256i*)(background + x));
+				const __m256i d = _mm256_subs_epu8(b, g);
+				// d > threshold <=> max(d, threshold + 1) == d
+				_mm256_storeu_si256((__m256i*)(binarized + x), _mm256_cmpeq_epi8(_mm256_max_epu8(d, limit), d));
+				if (difference)
+					_mm256_storeu_si256((__m256i*)(difference + x), d);
+				if (updated) {
+					// unpack and pack work within the same 128 bit lanes, so the pixel order is kept
+					const __m256i low = blend16(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(g, zero), weight);
+					const __m256i high = blend16(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(g, zero), weight);
+					_mm256_storeu_si256((__m256i*)(updated + x), _mm256_packus_epi16(low, high));
+				}
+			}
+#elif defined(PREPROCESS_NEON)
+			const uint8x16_t limit = vdupq_n_u8(uchar(threshold));
+			const int16x8_t weight = vdupq_n_s16(alpha);
+			for (; x + 16 <= width; x += 16) {
+				const uint8x16_t g = vld1q_u8(grey + x);
+				const uint8x16_t b = vld1q_u8(background + x);
+				const uint8x16_t d = vqsubq_u8(b, g);
+				vst1q_u8(binarized + x, vcgtq_u8(d, limit));
+				if (difference)
+					vst1q_u8(difference + x, d);
+				if (updated)
+					vst1q_u8(updated + x, vcombine_u8(
+						blend8(vget_low_u8(b), vget_low_u8(g), weight),
+						blend8(vget_high_u8(b), vget_high_u8(g), weight)));
+			}
+#endif
+		}
+		for (; x < width; x++) {
+			const int d = std::max(background[x] - grey[x], 0);
+			binarized[x] = d > threshold ? 255 : 0;
+			if (difference)
+				difference[x] = uchar(d);
+			if (updated) {
+				const int delta = (grey[x] - background[x]) * 128;
+				const int v = background[x] * 128 + ((delta * alpha + (1 << 14)) >> 15);
+				updated[x] = uchar((v + 64) >> 7);
+			}
+		}
+	}
+
+	void greyRow(const cv::Mat& source, int y, uchar* out)
+	{
+		if (source.channels() == 1) {
+			std::memcpy(out, source.ptr<uchar>(y), source.cols);
+			return;
+		}
+		cv::Mat grey(1, source.cols, CV_8UC1, out);
+		cv::cvtColor(source.row(y), grey, source.channels() == 4 ? CV_BGRA2GRAY : CV_BGR2GRAY);
+	}
+
+	/**
+	 * The last rows of a pipeline stage, padded on both sides with the neutral element of the morphology reading them.
+	 */
+	class RowRing
+	{
+	public:
+		RowRing(int rows, int width, int padding, uchar border) :
+			_rows(rows),
+			_stride(width + 2 * padding),
+			_padding(padding),
+			_data(rows * _stride, border)
+		{}
+
+		uchar* row(int y) { return &_data[(y % _rows) * _stride + _padding]; }
+
+	private:
+		int _rows;
+		int _stride;
+		int _padding;
+		std::vector<uchar> _data;
+	};
+}
+
+void preProcessRows(const PreProcessKernelImages& images, const PreProcessKernelParams& params, int rowBegin, int rowEnd)
+{
+	const cv::Mat& source = *images.source;
+	const int width = source.cols;
+	const int height = source.rows;
+	rowBegin = std::max(rowBegin, 0);
+	rowEnd = std::min(rowEnd, height);
+	if (rowBegin >= rowEnd)
+		return;
+
+	// extent of the kernels above and below their anchor, which is the center as with cv::getStructuringElement
+	const int sizeErode = std::max(params.sizeErode, 1);
+	const int sizeDilate = std::max(params.sizeDilate, 1);
+	const int erodeTop = sizeErode / 2;
+	const int erodeBottom = sizeErode - 1 - erodeTop;
+	const int dilateTop = sizeDilate / 2;
+	const int dilateBottom = sizeDilate - 1 - dilateTop;
+
+	// the rows the output rows depend on
+	const int erodeBegin = std::max(rowBegin - dilateTop, 0);
+	const int erodeEnd = std::min(rowEnd + dilateBottom, height);
+	const int binarizeBegin = std::max(erodeBegin - erodeTop, 0);
+	const int binarizeEnd = std::min(erodeEnd + erodeBottom, height);
+
+	const int padding = std::max(sizeErode, sizeDilate);
+	RowRing binarized(sizeErode, width, padding, 255);
+	RowRing eroded(sizeDilate, width, padding, 0);
+	std::vector<uchar> greyScratch(width);
+	std::vector<uchar> erodeScratch(width);
+	std::vector<uchar> dilateScratch(width + 2 * padding, 0);
+	uchar* dilateRow = &dilateScratch[padding];
+	std::vector<const uchar*> rows(padding + 1);
+
+	const double ratio = std::min(std::max(params.backgroundRatio, 0.0), 1.0);
+	const short alpha = short(std::min(cvRound(ratio * 32768), 32767));
+
+	int nextErode = erodeBegin;
+	int nextDilate = rowBegin;
+	for (int y = binarizeBegin; y < binarizeEnd; y++) {
+		// rows outside the range only feed the morphology and are not written
+		const bool own = y >= rowBegin && y < rowEnd;
+		uchar* grey = own ? images.greyscale->ptr<uchar>(y) : greyScratch.data();
+		greyRow(source, y, grey);
+		subtractRow(grey, images.background->ptr<uchar>(y),
+			own ? images.updatedBackground->ptr<uchar>(y) : nullptr,
+			own && images.difference ? images.difference->ptr<uchar>(y) : nullptr,
+			binarized.row(y), width, params.binarizationThreshold, alpha);
+		if (own && images.binarized)
+			std::memcpy(images.binarized->ptr<uchar>(y), binarized.row(y), width);
+
+		// erode every row whose neighbourhood is complete now and dilate right behind it
+		while (nextErode < erodeEnd && std::min(nextErode + erodeBottom, height - 1) <= y) {
+			const int e = nextErode++;
+			uchar* erodedRow = eroded.row(e);
+			if (sizeErode > 1) {
+				combineWindow<MinOp>(binarized.row(e), sizeErode, erodeTop, erodeScratch.data(), width);
+				int count = 0;
+				rows[count++] = erodeScratch.data();
+				for (int r = std::max(e - erodeTop, 0); r <= std::min(e + erodeBottom, height - 1); r++)
+					rows[count++] = binarized.row(r);
+				combineRows<MinOp>(rows.data(), count, erodedRow, width);
+			}
+			else {
+				std::memcpy(erodedRow, binarized.row(e), width);
+			}
+			if (images.eroded && e >= rowBegin && e < rowEnd)
+				std::memcpy(images.eroded->ptr<uchar>(e), erodedRow, width);
+
+			while (nextDilate < rowEnd && std::min(nextDilate + dilateBottom, height - 1) <= e) {
+				const int d = nextDilate++;
+				uchar* foreground = images.foreground->ptr<uchar>(d);
+				if (sizeDilate > 1) {
+					int count = 0;
+					for (int r = std::max(d - dilateTop, 0); r <= std::min(d + dilateBottom, height - 1); r++)
+						rows[count++] = eroded.row(r);
+					combineRows<MaxOp>(rows.data(), count, dilateRow, width);
+					combineWindow<MaxOp>(dilateRow, sizeDilate, dilateTop, foreground, width);
+				}
+				else {
+					std::memcpy(foreground, eroded.row(d), width);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * The parameters of the fused pre-processing kernel.
+ */
+struct PreProcessKernelParams
+{
+	int binarizationThreshold;
+
+	// size of the cross shaped erosion kernel, 1 or less disables the erosion
+	int sizeErode;
+
+	// size of the rectangular dilation kernel, 1 or less disables the dilation
+	int sizeDilate;
+
+	// weight of the current image when updating the background
+	double backgroundRatio;
+};
+
+/**
+ * The images read and written by the fused pre-processing kernel.
+ * All written images have to be allocated as CV_8UC1 with the size of the source image.
+ * The intermediate images (difference, binarized, eroded) are optional and may be nullptr.
+ */
+struct PreProcessKernelImages
+{
+	// BGR, BGRA or greyscale image
+	const cv::Mat* source;
+	// the background of the last frame, CV_8UC1
+	const cv::Mat* background;
+
+	cv::Mat* updatedBackground;
+	cv::Mat* greyscale;
+	cv::Mat* foreground;
+
+	cv::Mat* difference;
+	cv::Mat* binarized;
+	cv::Mat* eroded;
+};
+
+/**
+ * Pre-processes the rows [rowBegin, rowEnd) in a single streaming pass:
+ * - converts the image to greyscale
+ * - subtracts the image from the background (saturated, like cv::subtract)
+ * - updates the background with the running average (1 - ratio) * background + ratio * image, in fixed point
+ * - binarizes the difference
+ * - erodes with a cross and dilates with a rectangle, ignoring pixels outside the image like cv::erode and cv::dilate
+ *
+ * Rows are passed through small ring buffers, so only the requested images are written to memory.
+ * The rows above and below the range that the morphology needs are recomputed from the old background without
+ * being written. Disjoint row ranges can therefore be processed concurrently.
+ * The arithmetic runs with AVX2 or NEON if the build targets it, with a scalar fallback otherwise.
+ */
+void preProcessRows(const PreProcessKernelImages& images, const PreProcessKernelParams& params, int rowBegin, int rowEnd);
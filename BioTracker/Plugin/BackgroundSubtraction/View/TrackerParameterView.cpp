@@ -37,6 +37,12 @@ void TrackerParameterView::on_comboBoxSendImage_currentIndexChanged(int v) {
 	parameter->setNewSelection(_ui->comboBoxSendImage->currentText().toStdString());
 }
 
+void TrackerParameterView::on_comboBoxBlobDetector_currentIndexChanged(int v) {
+	TrackerParameter *parameter = qobject_cast<TrackerParameter *>(getModel());
+	parameter->setBlobDetector(v);
+	Q_EMIT parametersChanged();
+}
+
 
 void TrackerParameterView::on_pushButton_clicked()
 {
@@ -79,4 +85,6 @@ void TrackerParameterView::getNotified()
 
 	val = parameter->getMaxBlobSize();
 	_ui->lineEdit_9MaxBlob->setValue(val);
+
+	_ui->comboBoxBlobDetector->setCurrentIndex(parameter->getBlobDetector());
 }
@@ -21,6 +21,7 @@ private slots:
 	void on_pushButtonResetBackground_clicked();
 	//void on_pushButtonNoFish_clicked();
 	void on_comboBoxSendImage_currentIndexChanged(int v);
+	void on_comboBoxBlobDetector_currentIndexChanged(int v);
 	//void on_checkBoxNetwork_stateChanged(int v);
 	//void on_checkBoxBackground_stateChanged(int v);
 	//void on_checkBoxTrackingArea_stateChanged(int v);
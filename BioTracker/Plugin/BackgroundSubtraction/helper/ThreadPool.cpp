@@ -0,0 +1,116 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool& ThreadPool::instance()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+	return pool;
+}
+
+ThreadPool::ThreadPool(size_t threads) :
+	m_queued(0),
+	m_abort(false)
+{
+	threads = std::max<size_t>(threads, 1);
+	// the last queue belongs to the thread calling parallelFor
+	for (size_t i = 0; i <= threads; i++)
+		m_queues.emplace_back(new Queue());
+	for (size_t i = 0; i < threads; i++)
+		m_workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_abort = true;
+	}
+	m_work.notify_all();
+	for (std::thread& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task)
+{
+	if (count <= 0)
+		return;
+	if (count == 1) {
+		task(0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> submitLock(m_submitMutex);
+
+	Job job;
+	job.task = &task;
+	job.remaining = count;
+
+	// deal the tasks round robin, consecutive ones to different threads
+	for (int i = 0; i < count; i++) {
+		Queue& queue = *m_queues[i % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(Task{ &job, i });
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queued += count;
+	}
+	m_work.notify_all();
+
+	const size_t self = m_queues.size() - 1;
+	Task next;
+	while (tryPop(self, next))
+		execute(next);
+
+	std::unique_lock<std::mutex> lock(job.mutex);
+	job.done.wait(lock, [&job] { return job.remaining == 0; });
+}
+
+void ThreadPool::run(size_t worker)
+{
+	Task task;
+	while (true) {
+		if (tryPop(worker, task)) {
+			execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_work.wait(lock, [this] { return m_abort || m_queued > 0; });
+		if (m_abort)
+			return;
+	}
+}
+
+bool ThreadPool::tryPop(size_t worker, Task& task)
+{
+	for (size_t i = 0; i < m_queues.size(); i++) {
+		const bool own = i == 0;
+		Queue& queue = *m_queues[(worker + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+			continue;
+		if (own) {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		else {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		m_queued--;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::execute(const Task& task)
+{
+	Job& job = *task.job;
+	(*job.task)(task.index);
+	// count under the lock, the job lives on the stack of parallelFor and is gone as soon as it sees zero
+	std::lock_guard<std::mutex> lock(job.mutex);
+	if (--job.remaining == 0)
+		job.done.notify_all();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A pool of persistent worker threads.
+ * Every worker has its own task queue and steals from the others when it runs dry, so uneven tasks balance out.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * The pool shared by the plugin, with one worker per core besides the calling thread.
+	 */
+	static ThreadPool& instance();
+
+	/**
+	 * @param: threads, the number of worker threads, at least one is started.
+	 */
+	explicit ThreadPool(size_t threads);
+	~ThreadPool(void);
+
+	/**
+	 * The number of threads working on a parallelFor, including the calling one.
+	 */
+	size_t concurrency() const { return m_workers.size() + 1; }
+
+	/**
+	 * Runs task(i) for all i in [0, count) and returns once all of them have finished.
+	 * The calling thread works on the tasks as well. Must not be called from within a task.
+	 * @param: count, the number of tasks,
+	 * @param: task, the task, called concurrently.
+	 */
+	void parallelFor(int count, const std::function<void(int)>& task);
+
+private:
+	struct Job
+	{
+		const std::function<void(int)>* task;
+		// guarded by mutex
+		int remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+
+	struct Task
+	{
+		Job* job;
+		int index;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void run(size_t worker);
+
+	// pops from the front of the own queue, or steals from the back of another one
+	bool tryPop(size_t worker, Task& task);
+	void execute(const Task& task);
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	// the number of queued tasks; incremented under m_mutex so waiting workers can't miss it
+	std::atomic<int> m_queued;
+	bool m_abort;
+	std::mutex m_mutex;
+	std::condition_variable m_work;
+
+	// serializes parallelFor calls from different threads
+	std::mutex m_submitMutex;
+};